@@ -12,30 +12,42 @@ pushd lib/tco_linalg
 mv -f build/tco_linalg.a ../../build
 popd
 
+# Builds the daemon from the same sources with the compiler flags given after the binary's name.
+build_bin()
+{
+    local bin=$1
+    shift
+    clang \
+        -Wall \
+        -std=c11 \
+        -D _DEFAULT_SOURCE \
+        "$@" \
+        -I ../code \
+        -I ../code/utils \
+        -I ../lib/tco_libd/include \
+        -I ../lib/tco_linalg/include \
+        -I ../lib/tco_shmem \
+        -I /usr/lib/aarch64-linux-gnu/glib-2.0/include \
+        -I /usr/include/gstreamer-1.0 \
+        -I /usr/include/glib-2.0 \
+        -l m \
+        -O3 \
+        -l rt \
+        -l gstreamer-1.0 \
+        -l glib-2.0 \
+        -l gobject-2.0 \
+        -l pthread \
+        `pkg-config --cflags --libs gstreamer-1.0` \
+        ../code/*.c \
+        ../code/utils/*.c \
+        tco_libd.a \
+        tco_linalg.a \
+        -o $bin
+}
+
 pushd build
-clang \
-    -Wall \
-    -std=c11 \
-    -D _DEFAULT_SOURCE \
-    -I ../code \
-    -I ../code/utils \
-    -I ../lib/tco_libd/include \
-    -I ../lib/tco_linalg/include \
-    -I ../lib/tco_shmem \
-    -I /usr/lib/aarch64-linux-gnu/glib-2.0/include \
-	-I /usr/include/gstreamer-1.0 \
-	-I /usr/include/glib-2.0 \
-    -l m \
-    -O3 \
-    -l rt \
-    -l gstreamer-1.0 \
-    -l glib-2.0 \
-	-l gobject-2.0 \
-    -l pthread \
-    `pkg-config --cflags --libs gstreamer-1.0` \
-    ../code/*.c \
-    ../code/utils/*.c \
-    tco_libd.a \
-    tco_linalg.a \
-    -o tco_pland.bin
+# The one for the target board, with all debug drawing compiled out.
+build_bin tco_pland.bin -D DRAW_DISABLED
+# Draws on the frames shown by '-pt'.
+build_bin tco_pland_debug.bin
 popd
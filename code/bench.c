@@ -0,0 +1,1595 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string.h>
+#include <math.h>
+
+#include "tco_libd.h"
+#include "tco_shmem.h"
+
+#include "bench.h"
+#include "segment.h"
+#include "morph.h"
+#include "pre_proc.h"
+#include "roi.h"
+#include "pool.h"
+#include "timing.h"
+#include "fill.h"
+#include "label.h"
+#include "pyramid.h"
+#include "ipm.h"
+#include "rle.h"
+#include "ray_tmpl.h"
+#include "dist_map.h"
+#include "subpix.h"
+#include "tracker.h"
+#include "contour.h"
+#include "edge_scan.h"
+#include "lane.h"
+#include "hough.h"
+#include "polar.h"
+#include "block_map.h"
+#include "misc.h"
+#include "planner.h"
+
+#define BENCH_FRAMES_MAX 64 /* Frames read from a recording. The rest of the file is ignored. */
+#define BENCH_FRAMES_SYNTH 16
+#define BENCH_SYNTH_LINE_HALF 5 /* Pixels synthetic track lines reach to either side of their middle. */
+#define BENCH_REPEATS 8 /* How many times every frame is run through each kernel when timing. */
+
+typedef uint8_t frame_t[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH];
+
+static frame_t *frames = NULL;           /* Grayscale frames. */
+static frame_t *frames_segmented = NULL; /* The same frames after segmentation. */
+static uint16_t frame_num = 0;
+static morph_t morph;
+static morph_op_t morph_ref_ops[2]; /* Operations the reference morphology runs, in order. */
+static uint8_t morph_ref_width;
+static uint8_t morph_ref_height;
+static ipm_t ipm;
+static ipm_calib_t ipm_calib;
+static ipm_sample_t ipm_sample_mode;
+static roi_t roi_view; /* A trapezoid roughly matching the camera's view of the track. */
+
+#define BENCH_RAY_TOLERANCE 2 /* Pixels coarse to fine rays may differ by from full frame ones. */
+#define BENCH_NOTCH_Y_START 100 /* Rows cut out of the middle of the view's region of interest. */
+#define BENCH_NOTCH_Y_END 110
+#define BENCH_NOTCH_WIDTH 20 /* Pixels the cut reaches past the middle of the frame. */
+#define BENCH_IPM_ZOOM 2.0f /* The top row of the bird's-eye view covers this many times less of the frame than the bottom one. */
+#define BENCH_IPM_TOP 40.0f /* Frame row the top row of the bird's-eye view lies on. */
+#define BENCH_FILL_ROW 210 /* Row the fills look for the track center on, same as 'pre_proc'. */
+#define BENCH_FAN_SPACING 40 /* Pixels between the origins of the ray fans cast on every frame. */
+#define BENCH_DIST_SPACING 8 /* Pixels between the origins of the compass rays cast on every frame. */
+#define BENCH_SUBPIX_POSITIONS 32 /* Sub-pixel positions of the synthetic edge, each a frame. */
+#define BENCH_SUBPIX_EDGE 300.0f  /* Column the synthetic edge lies past. */
+#define BENCH_SUBPIX_BLUR 0.8f    /* Width of the synthetic edge in pixels, as a camera would blur it. */
+#define BENCH_TRACK_ROWS 8         /* Rows the tracker follows, the same as the planner's. */
+#define BENCH_TRACK_ROW_SPACING 20
+#define BENCH_LANE_FITS 1024      /* Synthetic pairs of edges fit. */
+#define BENCH_LANE_OUTLIERS 5     /* One in this many points is off the edge. */
+#define BENCH_LANE_NOISE 1.0f     /* Pixels the points on the edge are off by at most. */
+#define BENCH_HOUGH_DASH 16       /* Rows of the dashes and gaps borders get broken into. */
+#define BENCH_HOUGH_BAND_Y_START 40 /* Rows of the band painted across the track, most of those 'edge_plot' scans. */
+#define BENCH_HOUGH_BAND_Y_END 90
+#define BENCH_HOUGH_TOLERANCE 4   /* Pixels found borders may be off from the inner edges of the lines. */
+#define BENCH_POLAR_ANGLES POLAR_ANGLES_MAX
+#define BENCH_POLAR_TMPL_SCALE 64 /* Directions of the templates the profile is checked against are this long. */
+#define BENCH_POLAR_TOLERANCE 3   /* Pixels rays of the profile may differ by from templates, whose digital lines round differently. */
+
+#define BENCH_FAN_RAYS PLNR_FAN_DIR_NUM /* The planner's fan of rays, see 'plnr_fan_dirs'. */
+#define BENCH_FILL_VALUE 128 /* Filled pixels are written with this value. */
+
+/**
+ * @brief Read up to @c BENCH_FRAMES_MAX frames from a recording.
+ * @param frames_path Path to the recording.
+ * @return 0 on success, 1 on failure.
+ */
+static int frames_load(char const *const frames_path)
+{
+    FILE *const file = fopen(frames_path, "rb");
+    if (file == NULL)
+    {
+        log_error("Failed to open recorded frames at '%s'", frames_path);
+        return EXIT_FAILURE;
+    }
+    frames = malloc(BENCH_FRAMES_MAX * sizeof(frame_t));
+    if (frames == NULL)
+    {
+        log_error("Failed to allocate memory for recorded frames");
+        fclose(file);
+        return EXIT_FAILURE;
+    }
+    frame_num = fread(frames, sizeof(frame_t), BENCH_FRAMES_MAX, file);
+    fclose(file);
+    if (frame_num == 0)
+    {
+        log_error("No complete frames found in '%s'", frames_path);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Get the middle of a synthetic track line. The two lines converge towards the top and shift
+ * sideways every frame.
+ * @param frame_idx
+ * @param y Row.
+ * @param right 0 for the left line, 1 for the right one.
+ * @return Column, which can lie outside the frame.
+ */
+static int16_t synth_line_x(uint16_t const frame_idx, uint16_t const y, uint8_t const right)
+{
+    int16_t const slant = (TCO_FRAME_HEIGHT - y) / 2;
+    return (right ? 540 - slant : 100 + slant) + frame_idx * 7;
+}
+
+/**
+ * @brief Generate frames with a gradient background, bright track lines and noise so every branch
+ * of the kernels gets exercised without needing a recording.
+ * @return 0 on success, 1 on failure.
+ */
+static int frames_synthesize(void)
+{
+    frames = malloc(BENCH_FRAMES_SYNTH * sizeof(frame_t));
+    if (frames == NULL)
+    {
+        log_error("Failed to allocate memory for synthetic frames");
+        return EXIT_FAILURE;
+    }
+    uint32_t rand_state = 0x12345678;
+    for (frame_num = 0; frame_num < BENCH_FRAMES_SYNTH; frame_num++)
+    {
+        for (uint16_t y = 0; y < TCO_FRAME_HEIGHT; y++)
+        {
+            int16_t const line_left = synth_line_x(frame_num, y, 0);
+            int16_t const line_right = synth_line_x(frame_num, y, 1);
+            for (uint16_t x = 0; x < TCO_FRAME_WIDTH; x++)
+            {
+                /* xorshift32 */
+                rand_state ^= rand_state << 13;
+                rand_state ^= rand_state >> 17;
+                rand_state ^= rand_state << 5;
+                int16_t pixel = 40 + (x + y) / 8 + (rand_state % 32);
+                if (abs(x - line_left) <= BENCH_SYNTH_LINE_HALF || abs(x - line_right) <= BENCH_SYNTH_LINE_HALF)
+                {
+                    pixel += 150;
+                }
+                frames[frame_num][y][x] = pixel > 255 ? 255 : pixel;
+            }
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief OR or AND bytes into others.
+ * @param acc Bytes combined into.
+ * @param row Bytes combined with.
+ * @param num Number of bytes.
+ * @param dilate OR if set, AND otherwise.
+ */
+static void morph_ref_combine(uint8_t *const acc, uint8_t const *const row, uint16_t const num, uint8_t const dilate)
+{
+    if (dilate)
+    {
+        for (uint16_t idx = 0; idx < num; idx++)
+        {
+            acc[idx] |= row[idx];
+        }
+    }
+    else
+    {
+        for (uint16_t idx = 0; idx < num; idx++)
+        {
+            acc[idx] &= row[idx];
+        }
+    }
+}
+
+/**
+ * @brief Reference morphology which runs every operation as a pass along the rows and then one along
+ * the columns, a byte per pixel, on kernels of @c morph_ref_width by @c morph_ref_height . Runs the
+ * same operations as @c morph .
+ * @param pixels A segmented frame.
+ */
+static void morph_ref(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+{
+    static frame_t horiz;
+    uint16_t const radius_x = morph_ref_width / 2;
+    uint16_t const radius_y = morph_ref_height / 2;
+    uint16_t const inner_num = TCO_FRAME_WIDTH - 2 * radius_x;
+    for (uint8_t op_idx = 0; op_idx < 2; op_idx++)
+    {
+        uint8_t const dilate = morph_ref_ops[op_idx] == MORPH_DILATE;
+        memcpy(&horiz, pixels, sizeof(frame_t));
+        for (uint16_t y = 0; y < TCO_FRAME_HEIGHT; y++)
+        {
+            /* Column x of the kernel window starting at column 0 lands on pixel x + radius_x. */
+            memcpy(&horiz[y][radius_x], &(*pixels)[y][0], inner_num);
+            for (uint16_t dx = 1; dx <= 2 * radius_x; dx++)
+            {
+                morph_ref_combine(&horiz[y][radius_x], &(*pixels)[y][dx], inner_num, dilate);
+            }
+        }
+        for (uint16_t y = radius_y; y < TCO_FRAME_HEIGHT - radius_y; y++)
+        {
+            memcpy(&(*pixels)[y][radius_x], &horiz[y - radius_y][radius_x], inner_num);
+            for (uint16_t dy = 1; dy <= 2 * radius_y; dy++)
+            {
+                morph_ref_combine(&(*pixels)[y][radius_x], &horiz[y - radius_y + dy][radius_x], inner_num, dilate);
+            }
+        }
+    }
+}
+
+/**
+ * @brief The same operations using the morphology engine.
+ * @param pixels A segmented frame.
+ */
+static void morph_fast(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+{
+    morph_run(&morph, pixels, pixels, NULL, 0, TCO_FRAME_HEIGHT);
+}
+
+/**
+ * @brief Reference flood fill which visits the 4-connected neighbours of every filled pixel one by
+ * one. Pixels get filled when pushed so each one is pushed at most once.
+ * @param pixels A segmented frame where the black region around the track center gets filled.
+ */
+static void fill_ref(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+{
+    static mask_t mask;
+    static rle_t rle;
+    static point2_t stack[TCO_FRAME_WIDTH * TCO_FRAME_HEIGHT];
+    mask_from_frame(&mask, pixels);
+    rle_encode_rows(&rle, &mask, 0, TCO_FRAME_HEIGHT);
+    point2_t const seed = track_center_black(&rle, BENCH_FILL_ROW, TCO_FRAME_WIDTH / 2);
+    if ((*pixels)[seed.y][seed.x] != 0)
+    {
+        return;
+    }
+    uint32_t top = 0;
+    (*pixels)[seed.y][seed.x] = BENCH_FILL_VALUE;
+    stack[top++] = seed;
+    while (top > 0)
+    {
+        point2_t const pt = stack[--top];
+        point2_t const neighbours[4] = {{pt.x + 1, pt.y}, {pt.x - 1, pt.y}, {pt.x, pt.y + 1}, {pt.x, pt.y - 1}};
+        for (uint8_t neighbour_idx = 0; neighbour_idx < 4; neighbour_idx++)
+        {
+            point2_t const next = neighbours[neighbour_idx]; /* Coordinates of -1 wrap around out of bounds. */
+            if (next.x < TCO_FRAME_WIDTH && next.y < TCO_FRAME_HEIGHT && (*pixels)[next.y][next.x] == 0)
+            {
+                (*pixels)[next.y][next.x] = BENCH_FILL_VALUE;
+                stack[top++] = next;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Scanline fill on the packed mask.
+ * @param pixels A segmented frame where the black region around the track center gets filled.
+ */
+static void fill_fast(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+{
+    static mask_t mask, filled;
+    static rle_t rle;
+    mask_from_frame(&mask, pixels);
+    rle_encode_rows(&rle, &mask, 0, TCO_FRAME_HEIGHT);
+    fill_span(&filled, &mask, NULL, track_center_black(&rle, BENCH_FILL_ROW, TCO_FRAME_WIDTH / 2));
+    for (uint16_t y = 0; y < TCO_FRAME_HEIGHT; y++)
+    {
+        for (uint8_t word_idx = 0; word_idx < MASK_WORDS; word_idx++)
+        {
+            for (uint64_t word = filled.rows[y][word_idx]; word != 0; word &= word - 1)
+            {
+                (*pixels)[y][word_idx * MASK_WORD_BITS + __builtin_ctzll(word)] = BENCH_FILL_VALUE;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Write where the white pixels nearest to every column of a row lie over that row, 4 pixels
+ * per column holding the offset of the one on the right and of the one on the left.
+ * @param row
+ * @param x Column the search started at, a multiple of 4.
+ * @param right Next white pixel to the right or TCO_FRAME_WIDTH.
+ * @param left Next white pixel to the left or -1.
+ */
+static void rle_write(uint8_t *const row, uint16_t const x, uint16_t const right, int16_t const left)
+{
+    row[x] = right & 0xFF;
+    row[x + 1] = right >> 8;
+    row[x + 2] = (left + 1) & 0xFF;
+    row[x + 3] = (left + 1) >> 8;
+}
+
+/**
+ * @brief Reference search for the white pixels nearest to every 4th column, reading pixels one by
+ * one.
+ * @param pixels A segmented frame which gets overwritten with the positions, see @c rle_write .
+ */
+static void rle_ref(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+{
+    for (uint16_t y = 0; y < TCO_FRAME_HEIGHT; y++)
+    {
+        uint8_t row[TCO_FRAME_WIDTH];
+        memcpy(row, (*pixels)[y], TCO_FRAME_WIDTH);
+        for (uint16_t x = 0; x < TCO_FRAME_WIDTH; x += 4)
+        {
+            uint16_t right = x;
+            while (right < TCO_FRAME_WIDTH && row[right] == 0)
+            {
+                right++;
+            }
+            int16_t left = x;
+            while (left >= 0 && row[left] == 0)
+            {
+                left--;
+            }
+            rle_write((*pixels)[y], x, right, left);
+        }
+    }
+}
+
+/**
+ * @brief Same search on the run-length encoding, which includes encoding the frame.
+ * @param pixels A segmented frame which gets overwritten with the positions, see @c rle_write .
+ */
+static void rle_fast(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+{
+    static mask_t mask;
+    static rle_t rle;
+    mask_from_frame(&mask, pixels);
+    rle_encode_rows(&rle, &mask, 0, TCO_FRAME_HEIGHT);
+    for (uint16_t y = 0; y < TCO_FRAME_HEIGHT; y++)
+    {
+        for (uint16_t x = 0; x < TCO_FRAME_WIDTH; x += 4)
+        {
+            rle_write((*pixels)[y], x, rle_next_right(&rle, y, x), rle_next_left(&rle, y, x));
+        }
+    }
+}
+
+/**
+ * @brief Overwrite a frame with the lengths of the rays cast from a grid of origins, 2 pixels per
+ * ray.
+ * @param pixels
+ * @param lengths Lengths of every fan in @c plnr_fan_dirs order, the fans in raster order of their
+ * origins.
+ * @param length_num
+ */
+static void fan_write(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], uint16_t const *const lengths, uint16_t const length_num)
+{
+    memset(pixels, 0, sizeof(*pixels));
+    uint8_t *const out = &(*pixels)[0][0];
+    for (uint16_t length_idx = 0; length_idx < length_num; length_idx++)
+    {
+        out[2 * length_idx] = lengths[length_idx] & 0xFF;
+        out[2 * length_idx + 1] = lengths[length_idx] >> 8;
+    }
+}
+
+/**
+ * @brief Value a labelled pixel is written with, so both the labels and the statistics of the
+ * regions get compared.
+ * @param region_idx
+ * @param region
+ * @return Non-zero value.
+ */
+static uint8_t label_value(uint16_t const region_idx, label_region_t const *const region)
+{
+    return 1 + (region_idx + region->area + region->centroid.x + region->centroid.y +
+                region->x_min + region->x_max + region->y_min + region->y_max) % 254;
+}
+
+/**
+ * @brief Reference labelling which grows every component pixel by pixel from its first pixel in
+ * raster order.
+ * @param pixels A segmented frame whose white pixels get replaced by @c label_value .
+ */
+static void label_ref(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+{
+    static uint16_t labels[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH];
+    static point2_t stack[TCO_FRAME_WIDTH * TCO_FRAME_HEIGHT];
+    static label_region_t regions[TCO_FRAME_WIDTH * TCO_FRAME_HEIGHT / 2];
+    uint32_t region_num = 0;
+    memset(labels, 0xFF, sizeof(labels));
+    for (uint16_t y = 0; y < TCO_FRAME_HEIGHT; y++)
+    {
+        for (uint16_t x = 0; x < TCO_FRAME_WIDTH; x++)
+        {
+            if ((*pixels)[y][x] == 0 || labels[y][x] != LABEL_NONE)
+            {
+                continue;
+            }
+            label_region_t *const region = &regions[region_num];
+            *region = (label_region_t){.x_min = x, .x_max = x, .y_min = y, .y_max = y};
+            uint32_t sum_x = 0, sum_y = 0, top = 0;
+            labels[y][x] = region_num;
+            stack[top++] = (point2_t){x, y};
+            while (top > 0)
+            {
+                point2_t const pt = stack[--top];
+                region->area++;
+                sum_x += pt.x;
+                sum_y += pt.y;
+                region->x_min = pt.x < region->x_min ? pt.x : region->x_min;
+                region->x_max = pt.x > region->x_max ? pt.x : region->x_max;
+                region->y_max = pt.y > region->y_max ? pt.y : region->y_max;
+                for (int8_t dy = -1; dy <= 1; dy++)
+                {
+                    for (int8_t dx = -1; dx <= 1; dx++)
+                    {
+                        point2_t const next = {pt.x + dx, pt.y + dy}; /* Coordinates of -1 wrap around out of bounds. */
+                        if (next.x < TCO_FRAME_WIDTH && next.y < TCO_FRAME_HEIGHT &&
+                            (*pixels)[next.y][next.x] != 0 && labels[next.y][next.x] == LABEL_NONE)
+                        {
+                            labels[next.y][next.x] = region_num;
+                            stack[top++] = next;
+                        }
+                    }
+                }
+            }
+            region->centroid = (point2_t){(sum_x + region->area / 2) / region->area, (sum_y + region->area / 2) / region->area};
+            region_num++;
+        }
+    }
+    for (uint16_t y = 0; y < TCO_FRAME_HEIGHT; y++)
+    {
+        for (uint16_t x = 0; x < TCO_FRAME_WIDTH; x++)
+        {
+            if (labels[y][x] != LABEL_NONE)
+            {
+                (*pixels)[y][x] = label_value(labels[y][x], &regions[labels[y][x]]);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Run-based union-find labelling on the packed mask, read back through @c label_at .
+ * @param pixels A segmented frame whose white pixels get replaced by @c label_value .
+ */
+static void label_fast(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+{
+    static mask_t mask;
+    static label_table_t table;
+    mask_from_frame(&mask, pixels);
+    label_mask(&table, &mask, 0);
+    for (uint16_t y = 0; y < TCO_FRAME_HEIGHT; y++)
+    {
+        for (uint16_t run_idx = table.row_run_start[y]; run_idx < table.row_run_start[y + 1]; run_idx++)
+        {
+            /* Labels are looked up at both ends of every run the way consumers would, so a
+            wrong lookup leaves the run white and shows as a mismatch. */
+            label_run_t const *const run = &table.runs[run_idx];
+            uint16_t const label = label_at(&table, run->x_start, y);
+            if (label != LABEL_NONE && label_at(&table, run->x_end - 1, y) == label)
+            {
+                memset(&(*pixels)[y][run->x_start], label_value(label, &table.regions[label]), run->x_end - run->x_start);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Copy the levels of a pyramid into the top left of a frame, the 2x level first and the 4x
+ * level to its right.
+ * @param pixels
+ * @param pyramid
+ */
+static void pyramid_to_frame(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], pyramid_t const *const pyramid)
+{
+    for (uint16_t y = 0; y < PYRAMID_HEIGHT(1); y++)
+    {
+        memcpy(&(*pixels)[y][0], pyramid->half[y], PYRAMID_WIDTH(1));
+    }
+    for (uint16_t y = 0; y < PYRAMID_HEIGHT(2); y++)
+    {
+        memcpy(&(*pixels)[y][PYRAMID_WIDTH(1)], pyramid->quarter[y], PYRAMID_WIDTH(2));
+    }
+}
+
+/**
+ * @brief Reference pyramid which averages every block pixel by pixel.
+ * @param pixels A segmented frame whose top left gets overwritten by @c pyramid_to_frame .
+ */
+static void pyramid_ref(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+{
+    static pyramid_t pyramid;
+    for (uint16_t y = 0; y < PYRAMID_HEIGHT(1); y++)
+    {
+        for (uint16_t x = 0; x < PYRAMID_WIDTH(1); x++)
+        {
+            uint8_t const avg_even = ((*pixels)[2 * y][2 * x] + (*pixels)[2 * y + 1][2 * x] + 1) / 2;
+            uint8_t const avg_odd = ((*pixels)[2 * y][2 * x + 1] + (*pixels)[2 * y + 1][2 * x + 1] + 1) / 2;
+            pyramid.half[y][x] = (avg_even + avg_odd + 1) / 2;
+        }
+    }
+    for (uint16_t y = 0; y < PYRAMID_HEIGHT(2); y++)
+    {
+        for (uint16_t x = 0; x < PYRAMID_WIDTH(2); x++)
+        {
+            uint8_t const avg_even = (pyramid.half[2 * y][2 * x] + pyramid.half[2 * y + 1][2 * x] + 1) / 2;
+            uint8_t const avg_odd = (pyramid.half[2 * y][2 * x + 1] + pyramid.half[2 * y + 1][2 * x + 1] + 1) / 2;
+            pyramid.quarter[y][x] = (avg_even + avg_odd + 1) / 2;
+        }
+    }
+    pyramid_to_frame(pixels, &pyramid);
+}
+
+/**
+ * @brief Pyramid built with the vectorized box filter.
+ * @param pixels A segmented frame whose top left gets overwritten by @c pyramid_to_frame .
+ */
+static void pyramid_fast(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+{
+    static pyramid_t pyramid;
+    for (uint8_t level = 1; level <= PYRAMID_LEVELS_MAX; level++)
+    {
+        pyramid_build(&pyramid, pixels, level);
+    }
+    pyramid_to_frame(pixels, &pyramid);
+}
+
+/**
+ * @brief Make up a calibration of a camera looking down the track, which keeps the bottom row of
+ * the frame and narrows every row above towards the frame center up to @c BENCH_IPM_TOP .
+ * @param calib
+ */
+static void ipm_calib_synthesize(ipm_calib_t *const calib)
+{
+    float const bot = TCO_FRAME_HEIGHT - 1;
+    float const zoom_per_row = BENCH_IPM_ZOOM / bot;
+    float const y_slope = (bot - BENCH_IPM_TOP * (1.0f + BENCH_IPM_ZOOM)) / bot;
+    *calib = (ipm_calib_t){
+        .magic = IPM_CALIB_MAGIC,
+        .mm_per_pixel = 5.0f,
+        .track_width_mm = 1500.0f,
+        .homography = {1.0f, -TCO_FRAME_WIDTH / 2 * zoom_per_row, TCO_FRAME_WIDTH / 2 * BENCH_IPM_ZOOM,
+                       0.0f, y_slope, BENCH_IPM_TOP * (1.0f + BENCH_IPM_ZOOM),
+                       0.0f, -zoom_per_row, 1.0f + BENCH_IPM_ZOOM},
+    };
+}
+
+/**
+ * @brief Reference remap which solves the homography for every pixel.
+ * @param pixels A frame which gets replaced by its bird's-eye view.
+ */
+static void ipm_ref(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+{
+    static frame_t out;
+    for (uint16_t v = 0; v < TCO_FRAME_HEIGHT; v++)
+    {
+        for (uint16_t u = 0; u < TCO_FRAME_WIDTH; u++)
+        {
+            uint32_t offset;
+            uint8_t frac_x, frac_y;
+            ipm_source(&ipm_calib, u, v, &offset, &frac_x, &frac_y);
+            out[v][u] = ipm_sample(&(*pixels)[0][0], offset, frac_x, frac_y, ipm_sample_mode);
+        }
+    }
+    memcpy(pixels, &out, sizeof(frame_t));
+}
+
+/**
+ * @brief Remap through the lookup table.
+ * @param pixels A frame which gets replaced by its bird's-eye view.
+ */
+static void ipm_fast(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+{
+    static frame_t out;
+    ipm_remap(&ipm, pixels, &out, ipm_sample_mode);
+    memcpy(pixels, &out, sizeof(frame_t));
+}
+
+/**
+ * @brief Cast the planner's straight ray and fan of templates on the bird's-eye view of the
+ * segmented frames, once on the view @c ipm_remap makes and once looking every step up in the
+ * lookup table with @c ipm_ray_cast . The close origin is the planner's, found in the view through
+ * the inverse homography. Logs the time per frame of both.
+ * @return 0 if every ray is the same length both ways, 1 otherwise.
+ */
+static int bench_ipm_fan(void)
+{
+    static frame_t view;
+    static ray_tmpl_t tmpl_straight;
+    static ray_tmpl_t tmpls[BENCH_FAN_RAYS];
+    ray_tmpl_build(&tmpl_straight, (vec2_t){0, -1});
+    for (uint8_t dir_idx = 0; dir_idx < BENCH_FAN_RAYS; dir_idx++)
+    {
+        ray_tmpl_build(&tmpls[dir_idx], plnr_fan_dirs[dir_idx]);
+    }
+    point2_t origin_close;
+    if (ipm_to_bird(&ipm, (point2_t){TCO_FRAME_WIDTH / 2, 200}, &origin_close) != EXIT_SUCCESS)
+    {
+        log_error("ipm_fan: the close origin is not seen in the bird's-eye view");
+        return EXIT_FAILURE;
+    }
+    uint64_t ns_remap = 0, ns_lut = 0;
+    uint32_t mismatch_num = 0;
+    for (uint16_t frame_idx = 0; frame_idx < frame_num; frame_idx++)
+    {
+        uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH] = &frames_segmented[frame_idx];
+        uint16_t lengths_remap[BENCH_FAN_RAYS + 1], lengths_lut[BENCH_FAN_RAYS + 1];
+        uint64_t const start_remap = timing_now_ns();
+        ipm_remap(&ipm, pixels, &view, IPM_SAMPLE_NEAREST);
+        lengths_remap[BENCH_FAN_RAYS] = ray_tmpl_cast(&tmpl_straight, &view, NULL, origin_close);
+        point2_t const origin_far_remap = {origin_close.x, origin_close.y - lengths_remap[BENCH_FAN_RAYS] / 3};
+        for (uint8_t dir_idx = 0; dir_idx < BENCH_FAN_RAYS; dir_idx++)
+        {
+            lengths_remap[dir_idx] = ray_tmpl_cast(&tmpls[dir_idx], &view, NULL, origin_far_remap);
+        }
+        uint64_t const start_lut = timing_now_ns();
+        lengths_lut[BENCH_FAN_RAYS] = ipm_ray_cast(&ipm, &tmpl_straight, pixels, origin_close);
+        point2_t const origin_far_lut = {origin_close.x, origin_close.y - lengths_lut[BENCH_FAN_RAYS] / 3};
+        for (uint8_t dir_idx = 0; dir_idx < BENCH_FAN_RAYS; dir_idx++)
+        {
+            lengths_lut[dir_idx] = ipm_ray_cast(&ipm, &tmpls[dir_idx], pixels, origin_far_lut);
+        }
+        uint64_t const end = timing_now_ns();
+        ns_remap += start_lut - start_remap;
+        ns_lut += end - start_lut;
+        for (uint8_t ray_idx = 0; ray_idx <= BENCH_FAN_RAYS; ray_idx++)
+        {
+            mismatch_num += lengths_remap[ray_idx] != lengths_lut[ray_idx];
+        }
+    }
+    log_info("ipm_fan: remap and %u rays %.1f us per frame, rays through the lookup table %.1f us, %u rays differ",
+             (unsigned)BENCH_FAN_RAYS + 1, ns_remap / 1000.0f / frame_num, ns_lut / 1000.0f / frame_num, mismatch_num);
+    return mismatch_num == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Compare a frame kernel against its reference on all frames and log the timings.
+ * @param name Name of the kernel used when logging.
+ * @param input Frames the kernels get run on.
+ * @param kernel_ref Reference implementation.
+ * @param kernel Optimized implementation.
+ * @return 0 if outputs matched on all frames, 1 otherwise.
+ */
+static int bench_frame_kernel(char const *const name,
+                              frame_t const *const input,
+                              void (*const kernel_ref)(uint8_t (*const)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH]),
+                              void (*const kernel)(uint8_t (*const)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH]))
+{
+    static frame_t out_ref, out;
+    uint64_t ns_ref = 0, ns = 0;
+    uint16_t mismatch_num = 0;
+    for (uint16_t frame_idx = 0; frame_idx < frame_num; frame_idx++)
+    {
+        for (uint8_t repeat = 0; repeat < BENCH_REPEATS; repeat++)
+        {
+            memcpy(&out_ref, &input[frame_idx], sizeof(frame_t));
+            uint64_t const start_ref = timing_now_ns();
+            kernel_ref(&out_ref);
+            ns_ref += timing_now_ns() - start_ref;
+
+            memcpy(&out, &input[frame_idx], sizeof(frame_t));
+            uint64_t const start = timing_now_ns();
+            kernel(&out);
+            ns += timing_now_ns() - start;
+        }
+        if (memcmp(&out_ref, &out, sizeof(frame_t)) != 0)
+        {
+            mismatch_num++;
+        }
+    }
+
+    uint32_t const run_num = frame_num * BENCH_REPEATS;
+    log_info("%s: ref %.1f us, optimized %.1f us, speedup %.2fx, %u/%u frames mismatched",
+             name, ns_ref / 1000.0f / run_num, ns / 1000.0f / run_num, ns > 0 ? (float)ns_ref / ns : 0.0f, mismatch_num, frame_num);
+    return mismatch_num == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Compare the morphology engine against the reference on a closing or opening of a kernel.
+ * @param op_first Operation run first, a dilation for a closing and an erosion for an opening.
+ * @param width Kernel width.
+ * @param height Kernel height.
+ * @return 0 if no frame mismatched, 1 otherwise.
+ */
+static int bench_morph(morph_op_t const op_first, uint8_t const width, uint8_t const height)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "morph_%s_%ux%u", op_first == MORPH_DILATE ? "close" : "open", width, height);
+    morph_reset(&morph);
+    if ((op_first == MORPH_DILATE ? morph_close(&morph, width, height) : morph_open(&morph, width, height)) != 0)
+    {
+        log_error("Failed to set up a %ux%u kernel", width, height);
+        return EXIT_FAILURE;
+    }
+    morph_ref_ops[0] = op_first;
+    morph_ref_ops[1] = op_first == MORPH_DILATE ? MORPH_ERODE : MORPH_DILATE;
+    morph_ref_width = width;
+    morph_ref_height = height;
+    return bench_frame_kernel(name, frames_segmented, &morph_ref, &morph_fast);
+}
+
+/**
+ * @brief Time a frame kernel on all frames.
+ * @param input Frames the kernel gets run on.
+ * @param kernel
+ * @return Average time per frame in microseconds.
+ */
+static float bench_time(frame_t const *const input, void (*const kernel)(uint8_t (*const)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH]))
+{
+    static frame_t out;
+    uint64_t ns = 0;
+    for (uint16_t frame_idx = 0; frame_idx < frame_num; frame_idx++)
+    {
+        for (uint8_t repeat = 0; repeat < BENCH_REPEATS; repeat++)
+        {
+            memcpy(&out, &input[frame_idx], sizeof(frame_t));
+            uint64_t const start = timing_now_ns();
+            kernel(&out);
+            ns += timing_now_ns() - start;
+        }
+    }
+    return ns / 1000.0f / (frame_num * BENCH_REPEATS);
+}
+
+/**
+ * @brief Cast the planner's fan of rays on the segmented frames, on the full frame and coarse to
+ * fine from every level of the pyramid, and log the time per frame and how many rays ended close
+ * to the full frame ones.
+ * @param roi Region of interest the rays stop at, or NULL.
+ * @return 0 if every ray ended close to the full frame one, 1 otherwise.
+ */
+static int bench_pyramid_raycast(roi_t const *const roi)
+{
+    int status = EXIT_SUCCESS;
+    static pyramid_t pyramid;
+    uint8_t const dir_num = BENCH_FAN_RAYS;
+    point2_t const start_close = {TCO_FRAME_WIDTH / 2, 200};
+    for (uint8_t level = 0; level <= PYRAMID_LEVELS_MAX; level++)
+    {
+        uint64_t ns = 0;
+        uint32_t close_num = 0;
+        for (uint16_t frame_idx = 0; frame_idx < frame_num; frame_idx++)
+        {
+            uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH] = &frames_segmented[frame_idx];
+            pyramid.level_num = 0;
+            for (uint8_t level_built = 1; level_built <= level; level_built++)
+            {
+                pyramid_build(&pyramid, pixels, level_built);
+            }
+            uint16_t const straight_ref = raycast(pixels, roi, start_close, (vec2_t){0, -1}, &cb_draw_no_stop_white);
+            point2_t const start_far = {start_close.x, start_close.y - straight_ref / 3};
+            for (uint8_t repeat = 0; repeat < BENCH_REPEATS; repeat++)
+            {
+                uint64_t const start = timing_now_ns();
+                uint16_t const straight = pyramid_raycast_refine(&pyramid, level, pixels, roi, start_close, (vec2_t){0, -1}, &raycast_draw_no_stop_white);
+                uint16_t lengths[BENCH_FAN_RAYS];
+                for (uint8_t dir_idx = 0; dir_idx < dir_num; dir_idx++)
+                {
+                    lengths[dir_idx] = pyramid_raycast_refine(&pyramid, level, pixels, roi, start_far, plnr_fan_dirs[dir_idx], &raycast_draw_no_stop_white);
+                }
+                ns += timing_now_ns() - start;
+                if (repeat > 0)
+                {
+                    continue;
+                }
+                close_num += abs(straight - straight_ref) <= BENCH_RAY_TOLERANCE;
+                for (uint8_t dir_idx = 0; dir_idx < dir_num; dir_idx++)
+                {
+                    uint16_t const length_ref = raycast(pixels, roi, start_far, plnr_fan_dirs[dir_idx], &cb_draw_no_stop_white);
+                    close_num += abs(lengths[dir_idx] - length_ref) <= BENCH_RAY_TOLERANCE;
+                }
+            }
+        }
+        log_info("raycast_pyramid_%ux%s: %.1f us per frame, %u/%u rays within %u pixels of the full frame ones",
+                 1 << level, roi != NULL ? "_roi" : "", ns / 1000.0f / (frame_num * BENCH_REPEATS), close_num, frame_num * (dir_num + 1), BENCH_RAY_TOLERANCE);
+        if (close_num != frame_num * (dir_num + 1))
+        {
+            status = EXIT_FAILURE;
+        }
+    }
+    return status;
+}
+
+/**
+ * @brief Cast fans of rays in @c plnr_fan_dirs from a grid of origins along templates and log the time
+ * per frame against @c raycast , and how many rays ended close to the @c raycast ones. The
+ * horizontal rays are also found in the runs of their row like the planner does and timed against
+ * their templates.
+ * @return 0 if the rays found in the runs are the same length as their templates, 1 otherwise.
+ */
+static int bench_ray_tmpl(void)
+{
+    static ray_tmpl_t tmpls[BENCH_FAN_RAYS];
+    static mask_t mask;
+    static rle_t rle;
+    for (uint8_t dir_idx = 0; dir_idx < BENCH_FAN_RAYS; dir_idx++)
+    {
+        ray_tmpl_build(&tmpls[dir_idx], plnr_fan_dirs[dir_idx]);
+    }
+    uint64_t ns_raycast = 0, ns_tmpl = 0, ns_row_tmpl = 0, ns_row_rle = 0;
+    uint32_t ray_num = 0, exact_num = 0, close_num = 0, row_mismatch_num = 0;
+    for (uint16_t frame_idx = 0; frame_idx < frame_num; frame_idx++)
+    {
+        uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH] = &frames_segmented[frame_idx];
+        mask_from_frame(&mask, pixels);
+        rle_encode_rows(&rle, &mask, 0, TCO_FRAME_HEIGHT);
+        for (uint16_t y = BENCH_FAN_SPACING / 2; y < TCO_FRAME_HEIGHT; y += BENCH_FAN_SPACING)
+        {
+            for (uint16_t x = BENCH_FAN_SPACING / 2; x < TCO_FRAME_WIDTH; x += BENCH_FAN_SPACING)
+            {
+                point2_t const origin = {x, y};
+                uint16_t lengths_ref[BENCH_FAN_RAYS], lengths_tmpl[BENCH_FAN_RAYS];
+                uint64_t const start_raycast = timing_now_ns();
+                for (uint8_t dir_idx = 0; dir_idx < BENCH_FAN_RAYS; dir_idx++)
+                {
+                    lengths_ref[dir_idx] = raycast(pixels, NULL, origin, plnr_fan_dirs[dir_idx], &cb_draw_no_stop_white);
+                }
+                uint64_t const start_tmpl = timing_now_ns();
+                for (uint8_t dir_idx = 0; dir_idx < BENCH_FAN_RAYS; dir_idx++)
+                {
+                    lengths_tmpl[dir_idx] = ray_tmpl_cast(&tmpls[dir_idx], pixels, NULL, origin);
+                }
+                uint64_t const end = timing_now_ns();
+                ns_raycast += start_tmpl - start_raycast;
+                ns_tmpl += end - start_tmpl;
+                for (uint8_t dir_idx = 0; dir_idx < BENCH_FAN_RAYS; dir_idx++)
+                {
+                    exact_num += lengths_tmpl[dir_idx] == lengths_ref[dir_idx];
+                    close_num += abs(lengths_tmpl[dir_idx] - lengths_ref[dir_idx]) <= BENCH_RAY_TOLERANCE;
+                    ray_num++;
+                    if (plnr_fan_dirs[dir_idx].y != 0)
+                    {
+                        continue;
+                    }
+                    uint64_t const start_row_tmpl = timing_now_ns();
+                    uint16_t const length_tmpl = ray_tmpl_cast(&tmpls[dir_idx], pixels, &roi_view, origin);
+                    uint64_t const start_row_rle = timing_now_ns();
+                    uint16_t const length_rle = rle_raycast_row(&rle, &roi_view, origin, plnr_fan_dirs[dir_idx].x < 0);
+                    uint64_t const end_row = timing_now_ns();
+                    ns_row_tmpl += start_row_rle - start_row_tmpl;
+                    ns_row_rle += end_row - start_row_rle;
+                    row_mismatch_num += length_rle != length_tmpl;
+                }
+            }
+        }
+    }
+    log_info("ray_tmpl: raycast %.1f us, templates %.1f us per frame, %u/%u rays exact and %u within %u pixels",
+             ns_raycast / 1000.0f / frame_num, ns_tmpl / 1000.0f / frame_num, exact_num, ray_num, close_num, BENCH_RAY_TOLERANCE);
+    log_info("ray_tmpl rows: horizontal rays in the view's region %.1f us per frame along templates, %.1f us in the runs, %u mismatched",
+             ns_row_tmpl / 1000.0f / frame_num, ns_row_rle / 1000.0f / frame_num, row_mismatch_num);
+    return row_mismatch_num == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Cast the fans of rays of @c bench_ray_tmpl through @c raycast with a callback and
+ * through its variant with the callback inlined, and log the time per traced pixel of both. The
+ * rays are cast with and without the view's region of interest.
+ * @return 0 if both gave the same lengths, 1 otherwise.
+ */
+static int bench_raycast_inline(void)
+{
+    uint64_t ns_callback = 0, ns_inline = 0;
+    uint32_t pixel_num = 0, mismatch_num = 0;
+    for (uint16_t frame_idx = 0; frame_idx < frame_num; frame_idx++)
+    {
+        uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH] = &frames_segmented[frame_idx];
+        for (uint8_t roi_idx = 0; roi_idx < 2; roi_idx++)
+        {
+            roi_t const *const roi = roi_idx == 0 ? NULL : &roi_view;
+            for (uint16_t y = BENCH_FAN_SPACING / 2; y < TCO_FRAME_HEIGHT; y += BENCH_FAN_SPACING)
+            {
+                for (uint16_t x = BENCH_FAN_SPACING / 2; x < TCO_FRAME_WIDTH; x += BENCH_FAN_SPACING)
+                {
+                    point2_t const origin = {x, y};
+                    uint16_t lengths_callback[BENCH_FAN_RAYS], lengths_inline[BENCH_FAN_RAYS];
+                    uint64_t const start_callback = timing_now_ns();
+                    for (uint8_t dir_idx = 0; dir_idx < BENCH_FAN_RAYS; dir_idx++)
+                    {
+                        lengths_callback[dir_idx] = raycast(pixels, roi, origin, plnr_fan_dirs[dir_idx], &cb_draw_no_stop_white);
+                    }
+                    uint64_t const start_inline = timing_now_ns();
+                    for (uint8_t dir_idx = 0; dir_idx < BENCH_FAN_RAYS; dir_idx++)
+                    {
+                        lengths_inline[dir_idx] = raycast_draw_no_stop_white(pixels, roi, origin, plnr_fan_dirs[dir_idx]);
+                    }
+                    uint64_t const end = timing_now_ns();
+                    ns_callback += start_inline - start_callback;
+                    ns_inline += end - start_inline;
+                    for (uint8_t dir_idx = 0; dir_idx < BENCH_FAN_RAYS; dir_idx++)
+                    {
+                        /* Every ray visits one pixel more than its length, the one it stops on. */
+                        pixel_num += lengths_callback[dir_idx] + 1;
+                        mismatch_num += lengths_inline[dir_idx] != lengths_callback[dir_idx];
+                    }
+                }
+            }
+        }
+    }
+    log_info("raycast_inline: callback %.2f ns, inlined %.2f ns per traced pixel, speedup %.2fx, %u rays mismatched",
+             pixel_num > 0 ? (float)ns_callback / pixel_num : 0.0f, pixel_num > 0 ? (float)ns_inline / pixel_num : 0.0f,
+             ns_inline > 0 ? (float)ns_callback / ns_inline : 0.0f, mismatch_num);
+    return mismatch_num == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Place a blurred vertical edge at known fractions of a pixel, segment it like @c pre_proc
+ * does and cast the rays of the fan at it from both sides. Logs how far the ray lengths are from the
+ * true edge before and after @c subpix_ray , and the time it takes per edge. Rays moving right stop
+ * short of the edge by up to @c SEGMENT_LOOK_AHEAD , rays moving left stop on it.
+ * @return 0 if the refined lengths are closer on average, 1 otherwise.
+ */
+static int bench_subpix(void)
+{
+    static frame_t gray, segmented;
+    static ray_tmpl_t tmpls[BENCH_FAN_RAYS];
+    for (uint8_t dir_idx = 0; dir_idx < BENCH_FAN_RAYS; dir_idx++)
+    {
+        ray_tmpl_build(&tmpls[dir_idx], plnr_fan_dirs[dir_idx]);
+    }
+    float error_int = 0.0f, error_fine = 0.0f;
+    uint64_t ns = 0;
+    uint32_t edge_num = 0;
+    for (uint8_t position = 0; position < BENCH_SUBPIX_POSITIONS; position++)
+    {
+        float const edge = BENCH_SUBPIX_EDGE + position / (float)BENCH_SUBPIX_POSITIONS;
+        for (uint16_t x = 0; x < TCO_FRAME_WIDTH; x++)
+        {
+            uint8_t const pixel = 40 + 160 / (1.0f + expf(-(x - edge) / BENCH_SUBPIX_BLUR));
+            for (uint16_t y = 0; y < TCO_FRAME_HEIGHT; y++)
+            {
+                gray[y][x] = pixel;
+            }
+        }
+        memcpy(&segmented, &gray, sizeof(frame_t));
+        pre_proc_segment_chain(&segmented);
+        for (uint16_t y = BENCH_FAN_SPACING / 2; y < TCO_FRAME_HEIGHT; y += BENCH_FAN_SPACING)
+        {
+            for (uint16_t x = BENCH_FAN_SPACING / 2; x < TCO_FRAME_WIDTH; x += BENCH_FAN_SPACING)
+            {
+                point2_t const origin = {x, y};
+                for (uint8_t dir_idx = 0; dir_idx < BENCH_FAN_RAYS; dir_idx++)
+                {
+                    uint8_t const right = plnr_fan_dirs[dir_idx].x > 0;
+                    if (right != (x < edge) || segmented[y][x] == 255)
+                    {
+                        /* Points away from the edge or starts on it. */
+                        continue;
+                    }
+                    uint16_t const length = ray_tmpl_cast(&tmpls[dir_idx], &segmented, NULL, origin);
+                    if (fabsf(x + tmpls[dir_idx].x[length] - edge) > SEGMENT_LOOK_AHEAD + 1)
+                    {
+                        /* Missed the edge through the top or bottom of the frame, where the border
+                        fill of 'pre_proc' gets segmented too. */
+                        continue;
+                    }
+                    uint64_t const start = timing_now_ns();
+                    int32_t const length_fine = subpix_ray(&tmpls[dir_idx], &segmented, NULL, &gray, origin, length);
+                    ns += timing_now_ns() - start;
+                    /* Rays of these directions step one column at a time, so the true length is the
+                    distance to the edge plus the half pixel to the boundary of the origin. */
+                    float const length_true = (right ? edge - x : x - edge) + 0.5f;
+                    error_int += fabsf(length - length_true);
+                    error_fine += fabsf(length_fine / (float)SUBPIX_ONE - length_true);
+                    edge_num++;
+                }
+            }
+        }
+    }
+    error_int /= edge_num > 0 ? edge_num : 1;
+    error_fine /= edge_num > 0 ? edge_num : 1;
+    log_info("subpix: rays off the true edge by %.3f pixels on average, refined by %.3f pixels, %.1f ns per edge over %u edges",
+             error_int, error_fine, edge_num > 0 ? (float)ns / edge_num : 0.0f, edge_num);
+    return edge_num > 0 && error_fine < error_int ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Follow the track edges through the frames in order with @c tracker and log the time per
+ * frame against scanning for them from the frame center every frame, like @c track_center does,
+ * how many edges had to be scanned for and how far the filtered edges are from the scanned ones.
+ * @return 0 on success, 1 on failure.
+ */
+static int bench_tracker(void)
+{
+    static mask_t mask;
+    static rle_t rle;
+    static tracker_t tracker;
+    uint16_t rows[BENCH_TRACK_ROWS];
+    for (uint8_t row_idx = 0; row_idx < BENCH_TRACK_ROWS; row_idx++)
+    {
+        rows[row_idx] = 200 - row_idx * BENCH_TRACK_ROW_SPACING;
+    }
+    tracker_init(&tracker, rows, BENCH_TRACK_ROWS);
+    uint64_t ns_scan = 0, ns_track = 0;
+    float error = 0.0f;
+    uint32_t edge_num = 0;
+    for (uint16_t frame_idx = 0; frame_idx < frame_num; frame_idx++)
+    {
+        mask_from_frame(&mask, &frames_segmented[frame_idx]);
+        rle_encode_rows(&rle, &mask, 0, TCO_FRAME_HEIGHT);
+        int16_t lefts[BENCH_TRACK_ROWS], rights[BENCH_TRACK_ROWS];
+        uint64_t const start_scan = timing_now_ns();
+        for (uint8_t row_idx = 0; row_idx < BENCH_TRACK_ROWS; row_idx++)
+        {
+            lefts[row_idx] = rle_next_left(&rle, rows[row_idx], TCO_FRAME_WIDTH / 2 - 1);
+            rights[row_idx] = rle_next_right(&rle, rows[row_idx], TCO_FRAME_WIDTH / 2);
+        }
+        uint64_t const start_track = timing_now_ns();
+        tracker_step(&tracker, &rle);
+        uint64_t const end = timing_now_ns();
+        ns_scan += start_track - start_scan;
+        ns_track += end - start_track;
+        for (uint8_t row_idx = 0; row_idx < BENCH_TRACK_ROWS; row_idx++)
+        {
+            if (tracker.left[row_idx].valid)
+            {
+                error += fabsf(tracker.left[row_idx].pos - lefts[row_idx]);
+                edge_num++;
+            }
+            if (tracker.right[row_idx].valid)
+            {
+                error += fabsf(tracker.right[row_idx].pos - rights[row_idx]);
+                edge_num++;
+            }
+        }
+    }
+    log_info("tracker: scanning %.2f us, tracking %.2f us per frame, %u edges found in their window and %u scanned for, tracked edges %.2f pixels from scanned ones",
+             ns_scan / 1000.0f / frame_num, ns_track / 1000.0f / frame_num, tracker.window_num, tracker.scan_num, edge_num > 0 ? error / edge_num : 0.0f);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Trace the left and right borders of the track up from the rows the tracker follows on the
+ * segmented frames, and log the time per frame and how long the contours were. Every traced pixel
+ * is checked to be white with a black neighbour.
+ * @return 0 if every traced pixel lay on a border, 1 otherwise.
+ */
+static int bench_contour(void)
+{
+    static mask_t mask;
+    static rle_t rle;
+    static contour_t contour;
+    uint64_t ns = 0;
+    uint32_t step_num = 0, off_border_num = 0;
+    for (uint16_t frame_idx = 0; frame_idx < frame_num; frame_idx++)
+    {
+        uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH] = &frames_segmented[frame_idx];
+        mask_from_frame(&mask, pixels);
+        rle_encode_rows(&rle, &mask, 0, TCO_FRAME_HEIGHT);
+        for (uint8_t row_idx = 0; row_idx < BENCH_TRACK_ROWS; row_idx++)
+        {
+            uint16_t const y = 200 - row_idx * BENCH_TRACK_ROW_SPACING;
+            int16_t const left = rle_next_left(&rle, y, TCO_FRAME_WIDTH / 2 - 1);
+            uint16_t const right = rle_next_right(&rle, y, TCO_FRAME_WIDTH / 2);
+            for (uint8_t edge_idx = 0; edge_idx < 2; edge_idx++)
+            {
+                if ((edge_idx == 0 && left < 0) || (edge_idx == 1 && right >= TCO_FRAME_WIDTH))
+                {
+                    continue;
+                }
+                point2_t const start = {edge_idx == 0 ? left : right, y};
+                uint64_t const start_ns = timing_now_ns();
+                contour_trace(&contour, pixels, start, edge_idx == 0 ? CONTOUR_DIR_RIGHT : CONTOUR_DIR_LEFT, edge_idx, CONTOUR_LENGTH_MAX);
+                ns += timing_now_ns() - start_ns;
+                point2_t pos = start;
+                for (uint16_t step = 0; step < contour.length; step++)
+                {
+                    pos = contour_walk(&contour, pos, step, step + 1);
+                    uint8_t const border = (*pixels)[pos.y][pos.x - 1] == 0 || (*pixels)[pos.y][pos.x + 1] == 0 ||
+                                           (*pixels)[pos.y - 1][pos.x] == 0 || (*pixels)[pos.y + 1][pos.x] == 0;
+                    off_border_num += (*pixels)[pos.y][pos.x] == 0 || !border;
+                }
+                step_num += contour.length;
+            }
+        }
+    }
+    log_info("contour: %.1f us per frame tracing %u steps, %.1f ns per step, %u steps off the border",
+             ns / 1000.0f / frame_num, step_num / frame_num, step_num > 0 ? (float)ns / step_num : 0.0f, off_border_num);
+    return off_border_num == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Next number of a fixed sequence, so the synthetic edges are the same on every run.
+ * @param state
+ * @return A number in [-1, 1].
+ */
+static float bench_rand(uint32_t *const state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return (*state >> 8) / (float)(1u << 23) - 1.0f;
+}
+
+/**
+ * @brief Fit lanes to synthetic edges scanned on the rows of 'edge_scan', with a few points thrown
+ * off the edges, and log the time per call of 'edge_calculate', which fits both borders, and how far
+ * the heading and curvature are from the truth.
+ * @return 0 if every fit found its edge, 1 otherwise.
+ */
+static int bench_lane(void)
+{
+    uint32_t rand_state = 1;
+    uint64_t ns = 0;
+    uint16_t fail_num = 0;
+    float heading_error = 0.0f, curvature_error = 0.0f, curvature_sum = 0.0f;
+    uint32_t inlier_num = 0, outlier_num = 0;
+    for (uint16_t fit_idx = 0; fit_idx < BENCH_LANE_FITS; fit_idx++)
+    {
+        point2_t edges[2][NUM_LINE_POINTS];
+        lane_model_t truth = {.a = 0.004f * bench_rand(&rand_state), .b = 0.8f * bench_rand(&rand_state), .c = 200.0f};
+        truth.y_ref = ((NUM_LINE_POINTS + POINT_OFFSET) * TCO_FRAME_HEIGHT) / (POINT_MULTIPLIER * NUM_LINE_POINTS);
+        for (uint8_t i = 0; i < NUM_LINE_POINTS; i++)
+        {
+            uint16_t const y = ((NUM_LINE_POINTS - i + POINT_OFFSET) * TCO_FRAME_HEIGHT) / (POINT_MULTIPLIER * NUM_LINE_POINTS);
+            for (uint8_t e = 0; e < 2; e++)
+            {
+                float x = lane_x(&truth, y) + e * 240.0f + BENCH_LANE_NOISE * bench_rand(&rand_state);
+                if ((fit_idx + i + e) % BENCH_LANE_OUTLIERS == 0)
+                {
+                    x += 40.0f * bench_rand(&rand_state) > 0.0f ? 40.0f : -40.0f;
+                    outlier_num++;
+                }
+                edges[e][i] = (point2_t){x + 0.5f, y};
+            }
+        }
+        line_t lines[2];
+        lane_model_t models[2];
+        uint64_t const start_ns = timing_now_ns();
+        edge_calculate(lines, models, &edges[0], &edges[1]);
+        ns += timing_now_ns() - start_ns;
+
+        float const slope = -truth.b;
+        float const heading = atanf(slope);
+        float const curvature = 2.0f * truth.a / powf(1.0f + slope * slope, 1.5f);
+        for (uint8_t e = 0; e < 2; e++)
+        {
+            fail_num += !lines[e].valid;
+            heading_error += fabsf(models[e].heading - heading);
+            curvature_error += fabsf(models[e].curvature - curvature);
+            curvature_sum += fabsf(curvature);
+            inlier_num += models[e].inlier_num;
+        }
+    }
+    uint32_t const fit_num = 2 * BENCH_LANE_FITS;
+    log_info("lane: %.2f us per edge_calculate fitting 2 borders of %u points at most %u triples, %u failed, %.1f of %.1f points kept, heading %.4f rad and curvature %.1f%% off",
+             ns / 1000.0f / BENCH_LANE_FITS, NUM_LINE_POINTS, LANE_RANSAC_ITERATIONS, fail_num, (float)inlier_num / fit_num,
+             NUM_LINE_POINTS - (float)outlier_num / fit_num, heading_error / fit_num, 100.0f * curvature_error / curvature_sum);
+    return fail_num == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Draw the segmented borders of a synthetic frame, see 'synth_line_x(...)'.
+ * @param frame Where the borders are drawn, cleared first.
+ * @param frame_idx
+ * @param pattern 0 for solid borders, 1 for borders broken into dashes and 2 for solid ones with a
+ * band painted across the track on the rows 'edge_plot' scans.
+ */
+static void hough_frame_draw(frame_t *const frame, uint16_t const frame_idx, uint8_t const pattern)
+{
+    memset(frame, 0, sizeof(frame_t));
+    for (uint16_t y = 0; y < TCO_FRAME_HEIGHT; y++)
+    {
+        if (pattern == 1 && (y / BENCH_HOUGH_DASH) % 2)
+        {
+            continue;
+        }
+        int16_t const left = synth_line_x(frame_idx, y, 0), right = synth_line_x(frame_idx, y, 1);
+        int16_t x_start = left - BENCH_SYNTH_LINE_HALF, x_end = right + BENCH_SYNTH_LINE_HALF;
+        if (pattern != 2 || y < BENCH_HOUGH_BAND_Y_START || y >= BENCH_HOUGH_BAND_Y_END)
+        {
+            x_end = left + BENCH_SYNTH_LINE_HALF;
+            for (int16_t x = right - BENCH_SYNTH_LINE_HALF; x <= right + BENCH_SYNTH_LINE_HALF && x < TCO_FRAME_WIDTH; x++)
+            {
+                (*frame)[y][x] = 255;
+            }
+        }
+        for (int16_t x = x_start < 0 ? 0 : x_start; x <= x_end && x < TCO_FRAME_WIDTH; x++)
+        {
+            (*frame)[y][x] = 255;
+        }
+    }
+}
+
+/**
+ * @brief Check a found border against the inner edge of a synthetic line, on both of its ends.
+ * @param line
+ * @param frame_idx
+ * @param right 0 for the left line, 1 for the right one.
+ * @param error Where the larger of the errors at both ends is written.
+ * @return 1 if the border is valid and within @c BENCH_HOUGH_TOLERANCE at both ends, 0 otherwise.
+ */
+static uint8_t hough_border_check(line_t const *const line, uint16_t const frame_idx, uint8_t const right, uint16_t *const error)
+{
+    if (!line->valid)
+    {
+        return 0;
+    }
+    int16_t const inner = right ? -BENCH_SYNTH_LINE_HALF : BENCH_SYNTH_LINE_HALF;
+    uint16_t const error_bot = abs(line->bot.x - (synth_line_x(frame_idx, line->bot.y, right) + inner));
+    uint16_t const error_top = abs(line->top.x - (synth_line_x(frame_idx, line->top.y, right) + inner));
+    *error = error_bot > error_top ? error_bot : error_top;
+    return *error <= BENCH_HOUGH_TOLERANCE;
+}
+
+/**
+ * @brief Find the track borders of synthetic segmented frames with 'edge_plot' and with the Hough
+ * transform as the planner does, on solid borders, dashed ones and ones with a band painted across
+ * the track, and log the time per frame and how often both borders were found where they are.
+ * @return 0 if the Hough transform finds both borders within @c BENCH_HOUGH_TOLERANCE on every frame
+ * and 'edge_plot' does on every frame of the solid borders, 1 otherwise.
+ */
+static int bench_hough(void)
+{
+    static char const *const pattern_names[] = {"", " dashed", " banded"};
+    static hough_t hough;
+    static mask_t mask;
+    static rle_t rle;
+    static frame_t frame;
+    int status = EXIT_SUCCESS;
+    hough_init(&hough);
+#ifndef DRAW_DISABLED
+    /* Nothing draws the queue between frames here, it would only fill up. */
+    int const draw_was_enabled = draw_enabled;
+    draw_enabled = 0;
+#endif
+    for (uint8_t pattern = 0; pattern < 3; pattern++)
+    {
+        uint64_t ns_scan = 0, ns_hough = 0;
+        uint16_t found_scan = 0, found_hough = 0, error_scan = 0, error_hough = 0;
+        for (uint16_t frame_idx = 0; frame_idx < BENCH_FRAMES_SYNTH; frame_idx++)
+        {
+            hough_frame_draw(&frame, frame_idx, pattern);
+            mask_from_frame(&mask, &frame);
+            rle_encode_rows(&rle, &mask, 0, TCO_FRAME_HEIGHT);
+
+            line_t lines[2];
+            lane_model_t models[2];
+            uint64_t const scan_start = timing_now_ns();
+            edge_plot(&frame, &rle, TCO_FRAME_WIDTH / 2, lines, models);
+            ns_scan += timing_now_ns() - scan_start;
+            /* 'edge_plot' writes the border it finds right of the center first. */
+            uint16_t error_right = 0, error_left = 0;
+            uint8_t const scan_right = hough_border_check(&lines[0], frame_idx, 1, &error_right);
+            uint8_t const scan_left = hough_border_check(&lines[1], frame_idx, 0, &error_left);
+            found_scan += scan_left && scan_right;
+            if (scan_left && scan_right)
+            {
+                error_scan = error_left > error_scan ? error_left : error_scan;
+                error_scan = error_right > error_scan ? error_right : error_scan;
+            }
+
+            /* Same rows and picking of the borders as the planner. */
+            uint16_t const y_bot = 200, y_top = 40, center = TCO_FRAME_WIDTH / 2;
+            uint64_t const hough_start = timing_now_ns();
+            hough_step(&hough, &rle, y_top, y_bot + 1, center);
+            memset(lines, 0, sizeof(lines));
+            for (uint8_t line_idx = 0; line_idx < hough.line_num; line_idx++)
+            {
+                int16_t const bot_x = hough_line_x(&hough, &hough.lines[line_idx], y_bot);
+                line_t *const edge = &lines[bot_x < center ? 0 : 1];
+                if (!edge->valid)
+                {
+                    edge->bot = (point2_t){bot_x, y_bot};
+                    edge->top = (point2_t){hough_line_x(&hough, &hough.lines[line_idx], y_top), y_top};
+                    edge->valid = 1;
+                }
+            }
+            ns_hough += timing_now_ns() - hough_start;
+            uint8_t const hough_left = hough_border_check(&lines[0], frame_idx, 0, &error_left);
+            uint8_t const hough_right = hough_border_check(&lines[1], frame_idx, 1, &error_right);
+            found_hough += hough_left && hough_right;
+            if (hough_left && hough_right)
+            {
+                error_hough = error_left > error_hough ? error_left : error_hough;
+                error_hough = error_right > error_hough ? error_right : error_hough;
+            }
+        }
+        log_info("hough%s: edge_plot %.1f us finding both borders in %u of %u frames at most %u px off, hough %.1f us in %u at most %u px off, %u points voted on the last",
+                 pattern_names[pattern], ns_scan / 1000.0f / BENCH_FRAMES_SYNTH, found_scan, BENCH_FRAMES_SYNTH, error_scan,
+                 ns_hough / 1000.0f / BENCH_FRAMES_SYNTH, found_hough, error_hough, hough.point_num);
+        if (found_hough != BENCH_FRAMES_SYNTH || (pattern == 0 && found_scan != BENCH_FRAMES_SYNTH))
+        {
+            log_error("hough%s: borders were not found within %u px of where they are", pattern_names[pattern], BENCH_HOUGH_TOLERANCE);
+            status = EXIT_FAILURE;
+        }
+    }
+#ifndef DRAW_DISABLED
+    draw_enabled = draw_was_enabled;
+#endif
+    return status;
+}
+
+/**
+ * @brief Cast a free-space profile of rays from a point above the bottom center of the segmented
+ * frames over a polar resampling, and check it against ray templates in the same directions. Logs
+ * the time per frame of both and of the planner's fan of 12 templates.
+ * @return 0 if every ray of the profile is within @c BENCH_POLAR_TOLERANCE of its template's, 1 otherwise.
+ */
+static int bench_polar(void)
+{
+    static polar_t polar;
+    static ray_tmpl_t tmpls[BENCH_POLAR_ANGLES];
+    static ray_tmpl_t tmpls_fan[BENCH_FAN_RAYS];
+    float const below = 5.0f * (float)M_PI / 180.0f; /* Same span as the planner's. */
+    if (polar_init(&polar, -(float)M_PI - below, below, BENCH_POLAR_ANGLES) != EXIT_SUCCESS)
+    {
+        return EXIT_FAILURE;
+    }
+    float step_lengths[BENCH_POLAR_ANGLES]; /* Pixels every step of a template covers. */
+    for (uint16_t angle_idx = 0; angle_idx < BENCH_POLAR_ANGLES; angle_idx++)
+    {
+        vec2_t const dir = {lroundf(polar.cos[angle_idx] * BENCH_POLAR_TMPL_SCALE), lroundf(polar.sin[angle_idx] * BENCH_POLAR_TMPL_SCALE)};
+        ray_tmpl_build(&tmpls[angle_idx], dir);
+        step_lengths[angle_idx] = hypotf(dir.x, dir.y) / (abs(dir.x) > abs(dir.y) ? abs(dir.x) : abs(dir.y));
+    }
+    for (uint8_t dir_idx = 0; dir_idx < BENCH_FAN_RAYS; dir_idx++)
+    {
+        ray_tmpl_build(&tmpls_fan[dir_idx], plnr_fan_dirs[dir_idx]);
+    }
+
+    point2_t const origin = {TCO_FRAME_WIDTH / 2, 150};
+    uint64_t ns_polar = 0, ns_tmpl = 0, ns_fan = 0;
+    uint32_t mismatch_num = 0;
+    uint16_t lengths[BENCH_POLAR_ANGLES];
+    for (uint16_t frame_idx = 0; frame_idx < frame_num; frame_idx++)
+    {
+        uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH] = &frames_segmented[frame_idx];
+        uint64_t const polar_start = timing_now_ns();
+        polar_resample(&polar, pixels, origin);
+        polar_profile(&polar, lengths);
+        ns_polar += timing_now_ns() - polar_start;
+
+        /* The fan's lengths are overwritten by the templates' right after. */
+        uint16_t steps[BENCH_POLAR_ANGLES];
+        uint64_t const fan_start = timing_now_ns();
+        for (uint8_t dir_idx = 0; dir_idx < BENCH_FAN_RAYS; dir_idx++)
+        {
+            steps[dir_idx] = ray_tmpl_cast(&tmpls_fan[dir_idx], pixels, NULL, origin);
+        }
+        ns_fan += timing_now_ns() - fan_start;
+
+        uint64_t const tmpl_start = timing_now_ns();
+        for (uint16_t angle_idx = 0; angle_idx < BENCH_POLAR_ANGLES; angle_idx++)
+        {
+            steps[angle_idx] = ray_tmpl_cast(&tmpls[angle_idx], pixels, NULL, origin);
+        }
+        ns_tmpl += timing_now_ns() - tmpl_start;
+
+        for (uint16_t angle_idx = 0; angle_idx < BENCH_POLAR_ANGLES; angle_idx++)
+        {
+            mismatch_num += fabsf(lengths[angle_idx] - steps[angle_idx] * step_lengths[angle_idx]) > BENCH_POLAR_TOLERANCE;
+        }
+    }
+    log_info("polar: %u rays %.1f us per frame, as templates %.1f us, the fan of %u templates %.1f us, %u rays off by more than %d pixels",
+             BENCH_POLAR_ANGLES, ns_polar / 1000.0f / frame_num, ns_tmpl / 1000.0f / frame_num, (unsigned)BENCH_FAN_RAYS,
+             ns_fan / 1000.0f / frame_num, mismatch_num, BENCH_POLAR_TOLERANCE);
+    return mismatch_num == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Cast the planner's straight ray and fan of templates from a grid of origins on the
+ * segmented frames with the view's region of interest, once stepping through every pixel and once
+ * jumping over the empty blocks of a block map. Logs the time per frame of both and of building the
+ * map.
+ * @return 0 if every ray is the same length both ways, 1 otherwise.
+ */
+static int bench_block_map(void)
+{
+    static block_map_t map;
+    static mask_t mask;
+    static ray_tmpl_t tmpls[BENCH_FAN_RAYS + 1];
+    for (uint8_t dir_idx = 0; dir_idx < BENCH_FAN_RAYS; dir_idx++)
+    {
+        ray_tmpl_build(&tmpls[dir_idx], plnr_fan_dirs[dir_idx]);
+    }
+    ray_tmpl_build(&tmpls[BENCH_FAN_RAYS], (vec2_t){0, -1});
+    uint64_t ns_build = 0, ns_pixels = 0, ns_blocks = 0;
+    uint32_t ray_num = 0, mismatch_num = 0, empty_num = 0;
+    for (uint16_t frame_idx = 0; frame_idx < frame_num; frame_idx++)
+    {
+        uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH] = &frames_segmented[frame_idx];
+        mask_from_frame(&mask, pixels);
+        uint64_t const build_start = timing_now_ns();
+        block_map_build(&map, &mask, &roi_view.inside);
+        ns_build += timing_now_ns() - build_start;
+        empty_num += map.empty_num[0];
+        for (uint16_t y = BENCH_FAN_SPACING / 2; y < TCO_FRAME_HEIGHT; y += BENCH_FAN_SPACING)
+        {
+            for (uint16_t x = BENCH_FAN_SPACING / 2; x < TCO_FRAME_WIDTH; x += BENCH_FAN_SPACING)
+            {
+                point2_t const origin = {x, y};
+                uint16_t lengths_pixels[BENCH_FAN_RAYS + 1], lengths_blocks[BENCH_FAN_RAYS + 1];
+                uint64_t const pixels_start = timing_now_ns();
+                for (uint8_t dir_idx = 0; dir_idx <= BENCH_FAN_RAYS; dir_idx++)
+                {
+                    lengths_pixels[dir_idx] = ray_tmpl_cast(&tmpls[dir_idx], pixels, &roi_view, origin);
+                }
+                uint64_t const blocks_start = timing_now_ns();
+                for (uint8_t dir_idx = 0; dir_idx <= BENCH_FAN_RAYS; dir_idx++)
+                {
+                    lengths_blocks[dir_idx] = ray_tmpl_cast_blocks(&tmpls[dir_idx], pixels, &roi_view, &map, origin);
+                }
+                uint64_t const end = timing_now_ns();
+                ns_pixels += blocks_start - pixels_start;
+                ns_blocks += end - blocks_start;
+                for (uint8_t dir_idx = 0; dir_idx <= BENCH_FAN_RAYS; dir_idx++)
+                {
+                    mismatch_num += lengths_pixels[dir_idx] != lengths_blocks[dir_idx];
+                    ray_num++;
+                }
+            }
+        }
+    }
+    log_info("block_map: built in %.1f us with %u of %u 8x8 blocks empty, rays %.1f us stepping every pixel and %.1f us jumping empty blocks per frame, %u/%u rays mismatched",
+             ns_build / 1000.0f / frame_num, empty_num / frame_num, (TCO_FRAME_WIDTH >> BLOCK_MAP_SHIFT_FINE) * BLOCK_MAP_ROWS,
+             ns_pixels / 1000.0f / frame_num, ns_blocks / 1000.0f / frame_num, mismatch_num, ray_num);
+    return mismatch_num == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Reference compass rays cast from a grid of origins through @c raycast with the view's
+ * region of interest.
+ * @param pixels A segmented frame which gets overwritten with the lengths, see @c fan_write .
+ */
+static void dist_ref(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+{
+    static uint16_t lengths[TCO_FRAME_WIDTH * TCO_FRAME_HEIGHT / 2];
+    uint16_t length_num = 0;
+    for (uint16_t y = 0; y < TCO_FRAME_HEIGHT; y += BENCH_DIST_SPACING)
+    {
+        for (uint16_t x = 0; x < TCO_FRAME_WIDTH; x += BENCH_DIST_SPACING)
+        {
+            for (dist_dir_t dir = 0; dir < DIST_DIR_NUM; dir++)
+            {
+                lengths[length_num++] = raycast(pixels, &roi_view, (point2_t){x, y}, (vec2_t){dist_dir_dx[dir], dist_dir_dy[dir]}, &cb_draw_no_stop_white);
+            }
+        }
+    }
+    fan_write(pixels, lengths, length_num);
+}
+
+/**
+ * @brief Same rays read from a distance map, which includes building the map.
+ * @param pixels A segmented frame which gets overwritten with the lengths, see @c fan_write .
+ */
+static void dist_fast(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+{
+    static dist_map_t map;
+    static mask_t mask;
+    static rle_t rle;
+    static uint16_t lengths[TCO_FRAME_WIDTH * TCO_FRAME_HEIGHT / 2];
+    uint16_t length_num = 0;
+    mask_from_frame(&mask, pixels);
+    rle_encode_rows(&rle, &mask, 0, TCO_FRAME_HEIGHT);
+    dist_map_build(&map, pixels, &rle, &roi_view);
+    for (uint16_t y = 0; y < TCO_FRAME_HEIGHT; y += BENCH_DIST_SPACING)
+    {
+        for (uint16_t x = 0; x < TCO_FRAME_WIDTH; x += BENCH_DIST_SPACING)
+        {
+            for (dist_dir_t dir = 0; dir < DIST_DIR_NUM; dir++)
+            {
+                lengths[length_num++] = dist_map_ray(&map, dir, (point2_t){x, y});
+            }
+        }
+    }
+    fan_write(pixels, lengths, length_num);
+}
+
+/**
+ * @brief Only build a distance map and the runs it needs, to time it on its own.
+ * @param pixels A segmented frame.
+ */
+static void dist_build(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+{
+    static dist_map_t map;
+    static mask_t mask;
+    static rle_t rle;
+    mask_from_frame(&mask, pixels);
+    rle_encode_rows(&rle, &mask, 0, TCO_FRAME_HEIGHT);
+    dist_map_build(&map, pixels, &rle, &roi_view);
+}
+
+int bench_run(char const *const frames_path)
+{
+    if ((frames_path != NULL ? frames_load(frames_path) : frames_synthesize()) != 0)
+    {
+        free(frames);
+        return EXIT_FAILURE;
+    }
+    frames_segmented = malloc(frame_num * sizeof(frame_t));
+    if (frames_segmented == NULL)
+    {
+        log_error("Failed to allocate memory for segmented frames");
+        free(frames);
+        return EXIT_FAILURE;
+    }
+    memcpy(frames_segmented, frames, frame_num * sizeof(frame_t));
+    for (uint16_t frame_idx = 0; frame_idx < frame_num; frame_idx++)
+    {
+        segment_delta_ref(&frames_segmented[frame_idx]);
+    }
+    if (pre_proc_init(NULL) != EXIT_SUCCESS)
+    {
+        free(frames);
+        free(frames_segmented);
+        return EXIT_FAILURE;
+    }
+    log_info("Benchmarking on %u %s frames", frame_num, frames_path != NULL ? "recorded" : "synthetic");
+
+    int status = EXIT_SUCCESS;
+    status |= bench_frame_kernel("segment_delta", frames, &segment_delta_ref, &segment_delta);
+    status |= bench_morph(MORPH_DILATE, 3, 3);
+    status |= bench_morph(MORPH_DILATE, 5, 5);
+    status |= bench_morph(MORPH_DILATE, 9, 3);
+    status |= bench_morph(MORPH_ERODE, 3, 9);
+    status |= bench_morph(MORPH_DILATE, MORPH_KERNEL_MAX, MORPH_KERNEL_MAX);
+    status |= bench_frame_kernel("pre_proc_segment", frames, &pre_proc_segment_chain, &pre_proc_segment_fused);
+    status |= bench_frame_kernel("segment_adaptive", frames, &segment_adaptive_ref, &segment_adaptive);
+    log_info("segment_adaptive costs %.1f us per frame against %.1f us for segment_delta",
+             bench_time(frames, &segment_adaptive), bench_time(frames, &segment_delta));
+    pre_proc_segment_mode_set(SEGMENT_MODE_ADAPTIVE);
+    status |= bench_frame_kernel("pre_proc_segment_adaptive", frames, &pre_proc_segment_chain, &pre_proc_segment_fused);
+    pre_proc_segment_mode_set(SEGMENT_MODE_DELTA);
+    status |= bench_frame_kernel("fill_track", frames_segmented, &fill_ref, &fill_fast);
+    status |= bench_frame_kernel("label", frames_segmented, &label_ref, &label_fast);
+    status |= bench_frame_kernel("rle_scan", frames_segmented, &rle_ref, &rle_fast);
+    status |= bench_frame_kernel("pyramid", frames_segmented, &pyramid_ref, &pyramid_fast);
+    status |= bench_pyramid_raycast(NULL);
+    roi_clear(&roi_view);
+    roi_set_trapezoid(&roi_view, 6, 211, TCO_FRAME_WIDTH / 4, TCO_FRAME_WIDTH * 3 / 4, 0, TCO_FRAME_WIDTH);
+    /* A notch the straight ray crosses, so coarse rays have to stop at the region's border before
+    reaching the white beyond it. */
+    static roi_t roi_notched;
+    memcpy(&roi_notched, &roi_view, sizeof(roi_t));
+    for (uint16_t y = BENCH_NOTCH_Y_START; y < BENCH_NOTCH_Y_END; y++)
+    {
+        roi_set_span(&roi_notched, y, roi_view.x_start[y], TCO_FRAME_WIDTH / 2 - BENCH_NOTCH_WIDTH);
+    }
+    status |= bench_pyramid_raycast(&roi_notched);
+    status |= bench_ray_tmpl();
+    dist_map_init();
+    status |= bench_frame_kernel("dist_map", frames_segmented, &dist_ref, &dist_fast);
+    status |= bench_raycast_inline();
+    status |= bench_block_map();
+    status |= bench_subpix();
+    status |= bench_tracker();
+    status |= bench_contour();
+    status |= bench_lane();
+    status |= bench_hough();
+    status |= bench_polar();
+    log_info("dist_map takes %zu kB and %.1f us per frame to build", sizeof(dist_map_t) / 1024, bench_time(frames_segmented, &dist_build));
+    ipm_calib_synthesize(&ipm_calib);
+    if (ipm_init(&ipm, &ipm_calib) == EXIT_SUCCESS)
+    {
+        ipm_sample_mode = IPM_SAMPLE_NEAREST;
+        status |= bench_frame_kernel("ipm_nearest", frames_segmented, &ipm_ref, &ipm_fast);
+        ipm_sample_mode = IPM_SAMPLE_BILINEAR;
+        status |= bench_frame_kernel("ipm_bilinear", frames, &ipm_ref, &ipm_fast);
+        status |= bench_ipm_fan();
+    }
+
+    /* The view's region of interest, to show the work it saves. */
+    pre_proc_init(&roi_view);
+    status |= bench_frame_kernel("pre_proc_segment_roi", frames, &pre_proc_segment_chain, &pre_proc_segment_fused);
+
+    if (pool_init(0) == EXIT_SUCCESS)
+    {
+        log_info("Splitting pre_proc across %u workers", pool_worker_num());
+        status |= bench_frame_kernel("pre_proc_segment_parallel_roi", frames, &pre_proc_segment_chain, &pre_proc_segment_parallel);
+        pre_proc_segment_mode_set(SEGMENT_MODE_ADAPTIVE);
+        status |= bench_frame_kernel("pre_proc_segment_parallel_roi_adaptive", frames, &pre_proc_segment_chain, &pre_proc_segment_parallel);
+        pre_proc_segment_mode_set(SEGMENT_MODE_DELTA);
+        pre_proc_init(NULL);
+        status |= bench_frame_kernel("pre_proc_segment_parallel", frames, &pre_proc_segment_chain, &pre_proc_segment_parallel);
+        pool_deinit();
+    }
+
+    free(frames);
+    free(frames_segmented);
+    frames = NULL;
+    frames_segmented = NULL;
+    if (status != EXIT_SUCCESS)
+    {
+        log_error("Optimized kernels do not match their reference implementations");
+    }
+    return status;
+}
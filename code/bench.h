@@ -0,0 +1,16 @@
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Run the optimized processing kernels against their reference implementations on recorded
+ * frames. Every kernel output is checked to be bit-exact with its reference and the time taken by
+ * both is logged.
+ * @param frames_path Path to a file of raw GRAY8 frames (TCO_FRAME_WIDTH x TCO_FRAME_HEIGHT) stored
+ * back to back e.g. dumped from the state shmem. If NULL, synthetic frames are generated instead.
+ * @return 0 if all kernels matched their references, 1 otherwise.
+ */
+int bench_run(char const *const frames_path);
+
+#endif /* _BENCH_H_ */
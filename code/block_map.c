@@ -0,0 +1,44 @@
+#include <string.h>
+
+#include "block_map.h"
+
+void block_map_build(block_map_t *const map, mask_t const *const mask, mask_t const *const inside)
+{
+    memset(map->bits, 0, sizeof(map->bits));
+    for (uint8_t level = 0; level < BLOCK_MAP_LEVELS; level++)
+    {
+        uint16_t const size = 1 << block_map_shift(level);
+        uint16_t const blocks_per_word = MASK_WORD_BITS / size;
+        uint64_t const block_bits = ((uint64_t)1 << size) - 1;
+        map->empty_num[level] = 0;
+        for (uint16_t by = 0; by * size < TCO_FRAME_HEIGHT; by++)
+        {
+            /* Pixels of a band of rows set anywhere in it, so a block is occupied if any of its
+            columns are. */
+            uint64_t band[MASK_WORDS] = {0};
+            uint16_t const y_end = (by + 1) * size < TCO_FRAME_HEIGHT ? (by + 1) * size : TCO_FRAME_HEIGHT;
+            for (uint16_t y = by * size; y < y_end; y++)
+            {
+                for (uint8_t word_idx = 0; word_idx < MASK_WORDS; word_idx++)
+                {
+                    band[word_idx] |= mask->rows[y][word_idx] | (inside != NULL ? ~inside->rows[y][word_idx] : 0);
+                }
+            }
+            for (uint8_t word_idx = 0; word_idx < MASK_WORDS; word_idx++)
+            {
+                for (uint16_t block_idx = 0; block_idx < blocks_per_word; block_idx++)
+                {
+                    uint16_t const bx = word_idx * blocks_per_word + block_idx;
+                    if ((band[word_idx] >> (block_idx * size)) & block_bits)
+                    {
+                        map->bits[level][by][bx / 64] |= (uint64_t)1 << (bx % 64);
+                    }
+                    else
+                    {
+                        map->empty_num[level]++;
+                    }
+                }
+            }
+        }
+    }
+}
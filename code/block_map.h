@@ -0,0 +1,63 @@
+#ifndef _BLOCK_MAP_H_
+#define _BLOCK_MAP_H_
+
+/**
+ * @brief Bitmaps of which blocks of a segmented frame hold any white, at 8x8 and 32x32 pixels. Most
+ * of a segmented frame is black, so rays check the block they are in first and jump straight to
+ * where they leave it when it is empty, stepping pixel by pixel only through occupied blocks. Blocks
+ * with any pixel outside the region of interest count as occupied, so rays which stop at its border
+ * never jump past it. Built from the bit-packed frame a few words at a time.
+ */
+
+#include <stdint.h>
+#include "tco_shmem.h"
+#include "mask.h"
+
+#define BLOCK_MAP_LEVELS 2
+#define BLOCK_MAP_SHIFT_FINE 3   /* Blocks of level 0 are 8x8 pixels. */
+#define BLOCK_MAP_SHIFT_COARSE 5 /* Blocks of level 1 are 32x32 pixels. */
+#define BLOCK_MAP_ROWS ((TCO_FRAME_HEIGHT + (1 << BLOCK_MAP_SHIFT_FINE) - 1) >> BLOCK_MAP_SHIFT_FINE) /* Of the finest level. */
+#define BLOCK_MAP_WORDS (((TCO_FRAME_WIDTH >> BLOCK_MAP_SHIFT_FINE) + 63) / 64) /* In a row of the finest level. */
+
+_Static_assert(MASK_WORD_BITS % (1 << BLOCK_MAP_SHIFT_COARSE) == 0, "Blocks must not straddle mask words");
+
+typedef struct block_map
+{
+    /* Bit 'bx % 64' of word 'bx / 64' of row 'by' is set if block (bx, by) of the level is occupied. */
+    uint64_t bits[BLOCK_MAP_LEVELS][BLOCK_MAP_ROWS][BLOCK_MAP_WORDS];
+    uint16_t empty_num[BLOCK_MAP_LEVELS]; /* Empty blocks of every level in the last build. */
+} block_map_t;
+
+/**
+ * @brief Build the bitmaps of a segmented frame.
+ * @param map
+ * @param mask Bit-packed segmented frame.
+ * @param inside Bit-packed region of interest, or NULL if all of the frame is inside.
+ */
+void block_map_build(block_map_t *const map, mask_t const *const mask, mask_t const *const inside);
+
+/**
+ * @brief Get the size of the blocks of a level.
+ * @param level
+ * @return Side of the blocks as a power of 2.
+ */
+static inline uint8_t block_map_shift(uint8_t const level)
+{
+    return level == 0 ? BLOCK_MAP_SHIFT_FINE : BLOCK_MAP_SHIFT_COARSE;
+}
+
+/**
+ * @brief Check whether the block a pixel lies in is occupied.
+ * @param map
+ * @param level
+ * @param x Must be inside the frame.
+ * @param y Must be inside the frame.
+ * @return 1 if occupied, 0 if empty.
+ */
+static inline uint8_t block_map_occupied(block_map_t const *const map, uint8_t const level, uint16_t const x, uint16_t const y)
+{
+    uint16_t const bx = x >> block_map_shift(level);
+    return (map->bits[level][y >> block_map_shift(level)][bx / 64] >> (bx % 64)) & 1;
+}
+
+#endif /* _BLOCK_MAP_H_ */
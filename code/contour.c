@@ -0,0 +1,82 @@
+#include "contour.h"
+
+int8_t const contour_dx[CONTOUR_DIR_NUM] = {1, 1, 0, -1, -1, -1, 0, 1};
+int8_t const contour_dy[CONTOUR_DIR_NUM] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+/* Neighbours as offsets into a frame. */
+static int16_t const contour_offsets[CONTOUR_DIR_NUM] = {
+    1,
+    TCO_FRAME_WIDTH + 1,
+    TCO_FRAME_WIDTH,
+    TCO_FRAME_WIDTH - 1,
+    -1,
+    -TCO_FRAME_WIDTH - 1,
+    -TCO_FRAME_WIDTH,
+    -TCO_FRAME_WIDTH + 1,
+};
+
+/* After a step, the direction of the black neighbour which was swept past just before it, seen from
+where the step lands. Sweeps start from there. Indexed by the direction of the step. */
+static uint8_t const contour_back_cw[CONTOUR_DIR_NUM] = {6, 6, 0, 0, 2, 2, 4, 4};
+static uint8_t const contour_back_ccw[CONTOUR_DIR_NUM] = {2, 4, 4, 6, 6, 0, 0, 2};
+
+contour_status_t contour_trace(contour_t *const contour,
+                               uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+                               point2_t const start,
+                               contour_dir_t const back,
+                               uint8_t const cw_or_ccw,
+                               uint16_t const length_max)
+{
+    contour->start = start;
+    contour->end = start;
+    contour->length = 0;
+    uint16_t const length_limit = length_max < CONTOUR_LENGTH_MAX ? length_max : CONTOUR_LENGTH_MAX;
+    uint8_t const *const back_next = cw_or_ccw ? contour_back_cw : contour_back_ccw;
+    uint8_t const rotate = cw_or_ccw ? 1 : CONTOUR_DIR_NUM - 1; /* Added to a direction to turn it one neighbour on. */
+
+    int16_t x = start.x, y = start.y;
+    uint8_t dir_back = back;
+    contour_status_t status = CONTOUR_STATUS_LENGTH;
+    if (x >= TCO_FRAME_WIDTH || y >= TCO_FRAME_HEIGHT || (*pixels)[y][x] == 0)
+    {
+        return CONTOUR_STATUS_ISOLATED;
+    }
+    uint8_t const *pixel = &(*pixels)[y][x];
+    while (contour->length < length_limit)
+    {
+        /* Pixels inside the margin have all their neighbours inside the frame. */
+        if (x < CONTOUR_MARGIN || x >= TCO_FRAME_WIDTH - CONTOUR_MARGIN || y < CONTOUR_MARGIN || y >= TCO_FRAME_HEIGHT - CONTOUR_MARGIN)
+        {
+            status = CONTOUR_STATUS_BORDER;
+            break;
+        }
+        uint8_t dir = dir_back;
+        uint8_t found = 0;
+        for (uint8_t swept = 1; swept < CONTOUR_DIR_NUM; swept++)
+        {
+            dir = (dir + rotate) & (CONTOUR_DIR_NUM - 1);
+            if (pixel[contour_offsets[dir]] > 0)
+            {
+                found = 1;
+                break;
+            }
+        }
+        if (!found)
+        {
+            status = CONTOUR_STATUS_ISOLATED;
+            break;
+        }
+        contour->codes[contour->length++] = dir;
+        pixel += contour_offsets[dir];
+        x += contour_dx[dir];
+        y += contour_dy[dir];
+        dir_back = back_next[dir];
+        if (x == start.x && y == start.y)
+        {
+            status = CONTOUR_STATUS_CLOSED;
+            break;
+        }
+    }
+    contour->end = (point2_t){x, y};
+    return status;
+}
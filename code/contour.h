@@ -0,0 +1,89 @@
+#ifndef _CONTOUR_H_
+#define _CONTOUR_H_
+
+/**
+ * @brief Moore-neighbour tracing of the border of white regions in a segmented frame. From every
+ * border pixel the 8 neighbours are swept in a fixed rotation, starting from the black one the
+ * trace came past, and the first white one is the next border pixel. Directions are integer codes
+ * and the neighbours and where the next sweep starts come from tables, so every step is a few
+ * loads and compares with no trigonometry or division. The border is written as a chain code.
+ */
+
+#include <stdint.h>
+#include "tco_shmem.h"
+#include "tco_linalg.h"
+
+#define CONTOUR_LENGTH_MAX 1024 /* Steps a chain holds. */
+#define CONTOUR_MARGIN 10      /* Traces stop this close to the frame border. Must be at least 1. */
+
+/* Directions of the steps, clockwise on the frame since rows grow downwards. */
+typedef enum contour_dir
+{
+    CONTOUR_DIR_RIGHT = 0,
+    CONTOUR_DIR_DOWN_RIGHT,
+    CONTOUR_DIR_DOWN,
+    CONTOUR_DIR_DOWN_LEFT,
+    CONTOUR_DIR_LEFT,
+    CONTOUR_DIR_UP_LEFT,
+    CONTOUR_DIR_UP,
+    CONTOUR_DIR_UP_RIGHT,
+    CONTOUR_DIR_NUM,
+} contour_dir_t;
+
+typedef enum contour_status
+{
+    CONTOUR_STATUS_LENGTH = 0, /* Traced as many steps as asked for. */
+    CONTOUR_STATUS_CLOSED,     /* Came back around to the start. */
+    CONTOUR_STATUS_BORDER,     /* Came within @c CONTOUR_MARGIN of the frame border. */
+    CONTOUR_STATUS_ISOLATED,   /* The start is black or has no white neighbours. */
+} contour_status_t;
+
+typedef struct contour
+{
+    point2_t start;
+    point2_t end;                      /* Where the last step lands. */
+    uint16_t length;                   /* Steps in the chain. */
+    uint8_t codes[CONTOUR_LENGTH_MAX]; /* Direction of every step, a @c contour_dir_t . */
+} contour_t;
+
+extern int8_t const contour_dx[CONTOUR_DIR_NUM];
+extern int8_t const contour_dy[CONTOUR_DIR_NUM];
+
+/**
+ * @brief Trace the border of a white region.
+ * @param contour Where the chain is written.
+ * @param pixels A segmented frame.
+ * @param start A white pixel on the border.
+ * @param back Direction of a black neighbour of @p start , where the first sweep starts.
+ * @param cw_or_ccw Sweep clockwise if 1, which walks the border with the region on the right, or
+ * counter-clockwise if 0, which walks it with the region on the left.
+ * @param length_max Steps after which the trace stops. At most @c CONTOUR_LENGTH_MAX .
+ * @return Why the trace stopped.
+ */
+contour_status_t contour_trace(contour_t *const contour,
+                               uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+                               point2_t const start,
+                               contour_dir_t const back,
+                               uint8_t const cw_or_ccw,
+                               uint16_t const length_max);
+
+/**
+ * @brief Follow part of a chain.
+ * @param contour
+ * @param pos Where step @p step_start begins.
+ * @param step_start First step taken.
+ * @param step_end Step after the last one taken.
+ * @return Where the last step lands.
+ */
+static inline point2_t contour_walk(contour_t const *const contour, point2_t const pos, uint16_t const step_start, uint16_t const step_end)
+{
+    int16_t x = pos.x, y = pos.y;
+    for (uint16_t step = step_start; step < step_end; step++)
+    {
+        x += contour_dx[contour->codes[step]];
+        y += contour_dy[contour->codes[step]];
+    }
+    return (point2_t){x, y};
+}
+
+#endif /* _CONTOUR_H_ */
@@ -0,0 +1,198 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "dist_map.h"
+#include "simd.h"
+
+int8_t const dist_dir_dx[DIST_DIR_NUM] = {1, 1, 0, -1, -1, -1, 0, 1};
+int8_t const dist_dir_dy[DIST_DIR_NUM] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+/**
+ * @brief Count one more step than a neighbour, saturating.
+ * @param steps Count of the neighbour.
+ * @return
+ */
+static inline uint8_t dist_step(uint8_t const steps)
+{
+    return steps + (steps != DIST_MAP_SATURATED);
+}
+
+/* Distances from the middle entry, saturating, so a ramp of distances to any column is a copy. */
+static uint8_t ramp[2 * TCO_FRAME_WIDTH + 1];
+
+/**
+ * @brief Write the distance to a column over a range of a row, saturating.
+ * @param out Row of the map.
+ * @param x_start First column written.
+ * @param x_end Column after the last one written.
+ * @param target Column the distance is taken to.
+ */
+static inline void dist_ramp(uint8_t *const out, uint16_t const x_start, uint16_t const x_end, uint16_t const target)
+{
+    memcpy(&out[x_start], &ramp[TCO_FRAME_WIDTH + x_start - target], x_end - x_start);
+}
+
+/**
+ * @brief Fill a row of a horizontal direction. Counting pixel by pixel would make every pixel wait
+ * for its neighbour, so the black gaps between the white runs of the row are filled as ramps down
+ * to where the ray stops instead.
+ * @param out Row of the map, which must be 0.
+ * @param rle Runs of the segmented frame.
+ * @param y Index of the row.
+ * @param x_start First column inside the region.
+ * @param x_end Column after the last one inside.
+ * @param dx Direction, 1 or -1.
+ */
+static void dist_row_horiz(uint8_t *const out, rle_t const *const rle, uint16_t const y, uint16_t const x_start, uint16_t const x_end, int8_t const dx)
+{
+    if (x_start >= x_end)
+    {
+        return;
+    }
+    rle_run_t const *const runs = rle->runs[y];
+    uint16_t const run_num = rle->run_num[y];
+    if (dx > 0)
+    {
+        /* Rays stop on the last column or, leaving the region, just past it. */
+        uint16_t const limit = x_end < TCO_FRAME_WIDTH ? x_end : TCO_FRAME_WIDTH - 1;
+        uint16_t x = x_start;
+        for (uint16_t run_idx = rle_run_find(rle, y, x_start); run_idx < run_num && x < limit; run_idx++)
+        {
+            uint16_t const stop = runs[run_idx].x_start < limit ? runs[run_idx].x_start : limit;
+            if (stop > x)
+            {
+                dist_ramp(out, x, stop, stop);
+            }
+            x = runs[run_idx].x_end;
+        }
+        if (x < limit)
+        {
+            dist_ramp(out, x, limit, limit);
+        }
+    }
+    else
+    {
+        /* Rays stop on the first column or, leaving the region, just before it. */
+        uint16_t stop = x_start > 0 ? x_start - 1 : 0;
+        for (uint16_t run_idx = rle_run_find(rle, y, x_start); run_idx < run_num && stop < x_end; run_idx++)
+        {
+            uint16_t const white = runs[run_idx].x_start < x_end ? runs[run_idx].x_start : x_end;
+            if (white > stop + 1)
+            {
+                dist_ramp(out, stop + 1, white, stop);
+            }
+            stop = runs[run_idx].x_end - 1;
+        }
+        if (stop + 1 < x_end)
+        {
+            dist_ramp(out, stop + 1, x_end, stop);
+        }
+    }
+}
+
+/**
+ * @brief Fill a row of a vertical or diagonal direction from the row its neighbours lie on, which
+ * is done already. Pixels do not depend on each other so NEON or SSE2 do 16 at a time when
+ * available.
+ * @param out Row of the map.
+ * @param next Row of the map the direction steps onto.
+ * @param row Row of the frame.
+ * @param x_start First column inside the region.
+ * @param x_end Column after the last one inside.
+ * @param dx Horizontal part of the direction, -1, 0 or 1.
+ */
+static void dist_row_vert(uint8_t *const out, uint8_t const *const next, uint8_t const *const row, uint16_t const x_start, uint16_t const x_end, int8_t const dx)
+{
+    /* Diagonal rays end on the first or last column where their neighbour would be outside. */
+    uint16_t const x_lo = dx < 0 && x_start == 0 ? 1 : x_start;
+    uint16_t const x_hi = dx > 0 && x_end == TCO_FRAME_WIDTH ? TCO_FRAME_WIDTH - 1 : (x_end > x_lo ? x_end : x_lo);
+    memset(out, 0, x_lo);
+    memset(&out[x_hi], 0, TCO_FRAME_WIDTH - x_hi);
+    uint8_t const *const next_dx = next + dx;
+    uint16_t x = x_lo;
+#if defined(SIMD_NEON)
+    uint8x16_t const white = vdupq_n_u8(255);
+    uint8x16_t const one = vdupq_n_u8(1);
+    for (; x + SIMD_WIDTH <= x_hi; x += SIMD_WIDTH)
+    {
+        uint8x16_t const steps = vqaddq_u8(vld1q_u8(&next_dx[x]), one);
+        vst1q_u8(&out[x], vbicq_u8(steps, vceqq_u8(vld1q_u8(&row[x]), white)));
+    }
+#elif defined(SIMD_SSE2)
+    __m128i const white = _mm_set1_epi8((char)255);
+    __m128i const one = _mm_set1_epi8(1);
+    for (; x + SIMD_WIDTH <= x_hi; x += SIMD_WIDTH)
+    {
+        /* Adding with unsigned saturation is 'dist_step'. */
+        __m128i const steps = _mm_adds_epu8(_mm_loadu_si128((__m128i const *)&next_dx[x]), one);
+        __m128i const stop = _mm_cmpeq_epi8(_mm_loadu_si128((__m128i const *)&row[x]), white);
+        _mm_storeu_si128((__m128i *)&out[x], _mm_andnot_si128(stop, steps));
+    }
+#endif
+    for (; x < x_hi; x++)
+    {
+        out[x] = row[x] == 255 ? 0 : dist_step(next_dx[x]);
+    }
+}
+
+void dist_map_init(void)
+{
+    for (uint16_t ramp_idx = 0; ramp_idx <= 2 * TCO_FRAME_WIDTH; ramp_idx++)
+    {
+        uint16_t const dist = abs(ramp_idx - TCO_FRAME_WIDTH);
+        ramp[ramp_idx] = dist < DIST_MAP_SATURATED ? dist : DIST_MAP_SATURATED;
+    }
+}
+
+void dist_map_build(dist_map_t *const map, uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], rle_t const *const rle, roi_t const *const roi)
+{
+    for (dist_dir_t dir = 0; dir < DIST_DIR_NUM; dir++)
+    {
+        int8_t const dx = dist_dir_dx[dir];
+        int8_t const dy = dist_dir_dy[dir];
+        for (uint16_t row_idx = 0; row_idx < TCO_FRAME_HEIGHT; row_idx++)
+        {
+            /* Rows are filled against the direction. The first row filled is where rays end. */
+            uint16_t const y = dy > 0 ? TCO_FRAME_HEIGHT - 1 - row_idx : row_idx;
+            uint16_t x_start = 0, x_end = TCO_FRAME_WIDTH;
+            if (roi != NULL)
+            {
+                uint8_t const row_inside = y >= roi->y_start && y < roi->y_end;
+                x_start = row_inside ? roi->x_start[y] : 0;
+                x_end = row_inside ? roi->x_end[y] : 0;
+            }
+            uint8_t *const out = map->steps[dir][y];
+            if (dy == 0)
+            {
+                memset(out, 0, TCO_FRAME_WIDTH);
+                dist_row_horiz(out, rle, y, x_start, x_end, dx);
+            }
+            else if (row_idx == 0)
+            {
+                memset(out, 0, TCO_FRAME_WIDTH);
+            }
+            else
+            {
+                dist_row_vert(out, map->steps[dir][y + dy], (*pixels)[y], x_start, x_end, dx);
+            }
+        }
+    }
+}
+
+dist_dir_t dist_dir_from_vec(vec2_t const dir)
+{
+    int8_t const sx = (dir.x > 0) - (dir.x < 0);
+    int8_t const sy = (dir.y > 0) - (dir.y < 0);
+    if ((sx == 0 && sy == 0) || (sx != 0 && sy != 0 && abs(dir.x) != abs(dir.y)))
+    {
+        return DIST_DIR_NUM;
+    }
+    for (dist_dir_t dist_dir = 0; dist_dir < DIST_DIR_NUM; dist_dir++)
+    {
+        if (dist_dir_dx[dist_dir] == sx && dist_dir_dy[dist_dir] == sy)
+        {
+            return dist_dir;
+        }
+    }
+    return DIST_DIR_NUM;
+}
@@ -0,0 +1,92 @@
+#ifndef _DIST_MAP_H_
+#define _DIST_MAP_H_
+
+/**
+ * @brief Directional distance map of a segmented frame. For every pixel and each of the 8 compass
+ * directions it holds how many steps a ray cast from that pixel takes before it stops, so rays
+ * along those directions are found with a single load instead of being traced. Every direction is
+ * filled by one linear pass over the frame, each pixel's count following from that of its
+ * neighbour in the direction, or for the horizontal ones from the runs of the row.
+ */
+
+#include <stdint.h>
+#include "tco_shmem.h"
+#include "tco_linalg.h"
+#include "roi.h"
+#include "rle.h"
+
+#define DIST_MAP_SATURATED UINT8_MAX /* Counts saturate here. The ray goes on for at least this many steps. */
+
+typedef enum dist_dir
+{
+    DIST_DIR_RIGHT = 0,
+    DIST_DIR_DOWN_RIGHT,
+    DIST_DIR_DOWN,
+    DIST_DIR_DOWN_LEFT,
+    DIST_DIR_LEFT,
+    DIST_DIR_UP_LEFT,
+    DIST_DIR_UP,
+    DIST_DIR_UP_RIGHT,
+    DIST_DIR_NUM, /* Also returned for directions which are not compass directions. */
+} dist_dir_t;
+
+typedef struct dist_map
+{
+    uint8_t steps[DIST_DIR_NUM][TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH];
+} dist_map_t;
+
+extern int8_t const dist_dir_dx[DIST_DIR_NUM];
+extern int8_t const dist_dir_dy[DIST_DIR_NUM];
+
+/**
+ * @brief Build the tables maps are filled from. Must be called once before @c dist_map_build .
+ */
+void dist_map_init(void);
+
+/**
+ * @brief Fill the map of a segmented frame.
+ * @param map
+ * @param pixels A segmented frame.
+ * @param rle Runs of @p pixels , which the horizontal directions are filled from.
+ * @param roi See @c raycast . Rays cast on the map end where they would end with this region.
+ */
+void dist_map_build(dist_map_t *const map, uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], rle_t const *const rle, roi_t const *const roi);
+
+/**
+ * @brief Find the compass direction of a vector.
+ * @param dir
+ * @return The direction or @c DIST_DIR_NUM if the vector is not horizontal, vertical or diagonal.
+ */
+dist_dir_t dist_dir_from_vec(vec2_t const dir);
+
+/**
+ * @brief Get the length of a ray which stops at white. It is the same as the length @c raycast
+ * returns for the region the map was built with.
+ * @param map
+ * @param dir
+ * @param start Where the ray begins.
+ * @return Length of the ray.
+ */
+static inline uint16_t dist_map_ray(dist_map_t const *const map, dist_dir_t const dir, point2_t const start)
+{
+    if (start.x >= TCO_FRAME_WIDTH || start.y >= TCO_FRAME_HEIGHT)
+    {
+        return 0;
+    }
+    /* Only rays longer than the saturated count take more than one load. */
+    uint16_t length = 0;
+    point2_t pt = start;
+    for (;;)
+    {
+        uint8_t const steps = map->steps[dir][pt.y][pt.x];
+        length += steps;
+        if (steps != DIST_MAP_SATURATED)
+        {
+            return length;
+        }
+        pt.x += dist_dir_dx[dir] * DIST_MAP_SATURATED;
+        pt.y += dist_dir_dy[dir] * DIST_MAP_SATURATED;
+    }
+}
+
+#endif /* _DIST_MAP_H_ */
@@ -3,44 +3,26 @@
 
 void draw_edges(uint8_t (*pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t const (*left_edges)[NUM_LINE_POINTS],
                 point2_t const (*right_edges)[NUM_LINE_POINTS], line_t const *lines);
-uint8_t diff(uint16_t a, uint16_t b);
 void draw_next_way_point(uint8_t (*pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], line_t const *lines);
 
 /**
  * @brief will perform a line sdcan for left and right points to find track limits. Values are written to left/right_edge
- * @param pixels a segmented image of the track
+ * @param rle the runs of a segmented image of the track
  * @param center_width the pixel value bewteen 0 and TCO_FRAME_WIDTH -1 to search for the left/right edges
  * @param left_edge a pointer to a point_t for the left side of the track
  * @param right_edge a pointer to a point_t for the right side of the track
  */
-void edge_scan(uint8_t (*pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], uint16_t center_width, point2_t *left_edge, point2_t *right_edge)
+void edge_scan(rle_t const *const rle, uint16_t center_width, point2_t *left_edge, point2_t *right_edge)
 {
-    for (uint16_t i = center_width; i < TCO_FRAME_WIDTH - SEGMENTATION_DEADZONE; i++)
-    {
-        if ((*pixels)[left_edge->y][i] == 255)
-        {
-            left_edge->x = i;
-            goto right_edge; /* If the edge was found, do not set to err value */
-        }
-    }
-    left_edge->x = ERR_POINT;
-right_edge:
+    uint16_t const left_x = rle_next_right(rle, left_edge->y, center_width);
+    left_edge->x = left_x < TCO_FRAME_WIDTH - SEGMENTATION_DEADZONE ? left_x : ERR_POINT;
 
-    for (uint16_t i = center_width; i > 0 + SEGMENTATION_DEADZONE; i--)
-    {
-        if ((*pixels)[right_edge->y][i] == 255)
-        {
-            right_edge->x = i;
-            return;
-        }
-    }
-
-    right_edge->y = ERR_POINT;
+    int16_t const right_x = rle_next_left(rle, right_edge->y, center_width);
+    right_edge->x = right_x > SEGMENTATION_DEADZONE ? right_x : ERR_POINT;
 }
 
-void edge_plot(uint8_t (*pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+void edge_plot(uint8_t (*pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], rle_t const *const rle, uint16_t const center_width, line_t lines[2], lane_model_t models[2])
 {
-    uint16_t const center_width = TCO_FRAME_WIDTH / 2;
     point2_t left_edges[NUM_LINE_POINTS], right_edges[NUM_LINE_POINTS];
 
     /* Define scanline points */
@@ -53,66 +35,55 @@ void edge_plot(uint8_t (*pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
     }
 
     /* Find the bottom line */
-    edge_scan(pixels, center_width, &left_edges[0], &right_edges[0]);
+    edge_scan(rle, center_width, &left_edges[0], &right_edges[0]);
 
     /* For the remaining edges, we need to find the new points based on the previous points */
     for (int i = 1; i < NUM_LINE_POINTS; i++)
     {
         for (int j = 0; j < 2; j++)
         {
-            edge_scan(pixels, center_width, &left_edges[i], &right_edges[i]);
+            edge_scan(rle, center_width, &left_edges[i], &right_edges[i]);
         }
     }
 
-    /* Calculate where the line is TODO: Make this return the line*/
-    line_t *lines = edge_calculate(pixels, &left_edges, &right_edges);
+    /* Calculate where the line is */
+    edge_calculate(lines, models, &left_edges, &right_edges);
 
     /* Draw the lines */
     draw_edges(pixels, &left_edges, &right_edges, lines);
     draw_next_way_point(pixels, lines);
-
-    free(lines);
 }
 
-line_t *edge_calculate(uint8_t (*pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t const (*left_edges)[NUM_LINE_POINTS], point2_t const (*right_edges)[NUM_LINE_POINTS])
+void edge_calculate(line_t lines[2], lane_model_t models[2], point2_t const (*left_edges)[NUM_LINE_POINTS], point2_t const (*right_edges)[NUM_LINE_POINTS])
 {
-    line_t *lines = calloc(sizeof(line_t), 2);
     point2_t const(*edges)[NUM_LINE_POINTS] = left_edges;
     for (uint8_t e = 0; e < 2; e++)
     {
-        uint8_t bot_found = 0; /* Keep track if bottom line has been found */
-        for (int8_t i = 0; i < NUM_LINE_POINTS; i++)
+        point2_t points[NUM_LINE_POINTS];
+        uint8_t inliers[NUM_LINE_POINTS];
+        uint16_t point_num = 0;
+        for (uint8_t i = 0; i < NUM_LINE_POINTS; i++)
         {
-            if ((*edges)[i].x == ERR_POINT) /* Skip points that are out of bounds */
+            if ((*edges)[i].x != ERR_POINT) /* Skip points that are out of bounds */
             {
-                continue;
+                points[point_num++] = (*edges)[i];
             }
+        }
 
-            if (bot_found == 0) /* Bottom not (yet) found */
-            {
-                lines[e].bot.x = (*edges)[i].x; /* fill in bot_x */
-                lines[e].bot.y = (*edges)[i].y; /* fill in bot_y */
-                bot_found = 1;
-            }
-            else
-            {
-                /* If the difference in x is < threshold, accept it. Else, save it */
-                if (diff((*edges)[i - 1].x, (*edges)[i].x) < LINE_TOLERANCE) //TODO : Also keep track of the slope (increasing/decreasing). This might let us increase lenience.S
-                {
-                    lines[e].top.x = (*edges)[i].x; /* fill in top_x */
-                    lines[e].top.y = (*edges)[i].y; /* fill in top_y */
-                    lines[e].valid = 1;             /* WE FOUND A LINE! */
-                }
-                else
-                {
-                    break; /* This point is not part of the line! Stop searching */
-                }
-            }
+        memset(&lines[e], 0, sizeof(line_t));
+        /* Center the model on the bottom scan line, where the car is */
+        if (lane_fit(&models[e], points, point_num, (*edges)[0].y, inliers) == EXIT_SUCCESS)
+        {
+            float const bot_x = lane_x(&models[e], models[e].y_max);
+            float const top_x = lane_x(&models[e], models[e].y_min);
+            lines[e].bot.x = bot_x < 0.0f ? 0 : bot_x < TCO_FRAME_WIDTH - 1 ? bot_x + 0.5f : TCO_FRAME_WIDTH - 1;
+            lines[e].bot.y = models[e].y_max;
+            lines[e].top.x = top_x < 0.0f ? 0 : top_x < TCO_FRAME_WIDTH - 1 ? top_x + 0.5f : TCO_FRAME_WIDTH - 1;
+            lines[e].top.y = models[e].y_min;
+            lines[e].valid = 1; /* WE FOUND A LINE! */
         }
         edges = right_edges; /* Swap sides */
     }
-
-    return lines;
 }
 
 /**
@@ -142,17 +113,6 @@ void draw_edges(uint8_t (*pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t c
     }
 }
 
-/**
- * @brief find absolute difference of 2 values
- * @param a value one
- * @param b value two
- * @return read brief
-*/
-uint8_t diff(uint16_t a, uint16_t b)
-{
-    return a < b ? b - a : a - b;
-}
-
 /**
  * @brief Utility function to draw next best point. 
  * @param pixels an image
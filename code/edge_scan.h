@@ -11,6 +11,8 @@
 #include "tco_linalg.h"
 
 #include "draw.h"
+#include "rle.h"
+#include "lane.h"
 
 typedef struct line
 {
@@ -25,20 +27,27 @@ typedef struct line
 
 #define ERR_POINT TCO_FRAME_WIDTH + 10 /* The value to set `points` when they are not found */
 #define SEGMENTATION_DEADZONE 20       /* The segmentation we use can sometimes create a white line inbetween horizontal track lines. This is a search offset. */
-#define LINE_TOLERANCE 20              /* Number of pixels to cut as 'slack'. The higher the values, the longer the the lines but less reliable */
 
 /**
- * @brief will perform 5 line scans and plot the points
+ * @brief will perform the line scans, fit the lines to them and plot both
  * @param pixels A segmented image. See `segmentation.h:segment(...)`
+ * @param rle The runs of the same segmented image, see `pre_proc_rle()`.
+ * @param center_width The column between 0 and TCO_FRAME_WIDTH - 1 to scan for the edges from, e.g.
+ * the frame center or the tracked track center.
+ * @param lines Where the left and right line are written, see `edge_calculate(...)`.
+ * @param models Where the left and right lane models are written, with their heading and curvature.
+ * A model is only set where its line is valid.
  */
-void edge_plot(uint8_t (*pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH]);
+void edge_plot(uint8_t (*pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], rle_t const *const rle, uint16_t const center_width, line_t lines[2], lane_model_t models[2]);
 
 /**
- * @brief will take points and calculate the best suited line for sides 1 and 2 of `edges`
+ * @brief will fit a lane model to the points of each side, see `lane.h:lane_fit(...)`. Points which
+ * do not lie on the fit are left out, so one bad point no longer cuts a line short.
+ * @param lines Where the left and right line are written, from the lowest to the highest inlier.
+ * @param models Where the left and right models are written, with their heading and curvature.
  * @param left_edges a list of points corresponding to left_edges
  * @param right_edges a list of points corresponding to right_edges
- * @return A pointer of heap-reserved memory of type line_t[2]. 
  */
-line_t *edge_calculate(uint8_t (*pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t const (*left_edges)[NUM_LINE_POINTS], point2_t const (*right_edges)[NUM_LINE_POINTS]);
+void edge_calculate(line_t lines[2], lane_model_t models[2], point2_t const (*left_edges)[NUM_LINE_POINTS], point2_t const (*right_edges)[NUM_LINE_POINTS]);
 
 #endif /* _LINE_H_ */
\ No newline at end of file
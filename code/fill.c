@@ -0,0 +1,137 @@
+#include <string.h>
+
+#include "fill.h"
+
+typedef struct fill_span
+{
+    uint16_t y;
+    uint16_t x_start; /* Columns in [x_start, x_end) are filled. */
+    uint16_t x_end;
+} fill_span_t;
+
+static fill_span_t stack[FILL_STACK_MAX]; /* Filled spans whose neighbouring rows still need to be checked. */
+
+/**
+ * @brief Get the pixels of a word which can still be filled.
+ * @param filled
+ * @param walls
+ * @param inside Can be NULL.
+ * @param y Index of the row.
+ * @param word_idx Index of the word in the row.
+ * @return Set bits are open pixels.
+ */
+static inline uint64_t word_open(mask_t const *const filled,
+                                 mask_t const *const walls,
+                                 mask_t const *const inside,
+                                 uint16_t const y,
+                                 uint8_t const word_idx)
+{
+    uint64_t const word_inside = inside != NULL ? inside->rows[y][word_idx] : ~(uint64_t)0;
+    return ~walls->rows[y][word_idx] & ~filled->rows[y][word_idx] & word_inside;
+}
+
+/**
+ * @brief Get the bits of a word which lie in a range of columns.
+ * @param word_idx Index of the word in the row.
+ * @param x_start First column of the range.
+ * @param x_end Column after the last one of the range.
+ * @return Set bits are in the range.
+ */
+static inline uint64_t word_range(uint8_t const word_idx, uint16_t const x_start, uint16_t const x_end)
+{
+    int16_t const bit_start = x_start - word_idx * MASK_WORD_BITS;
+    int16_t const bit_end = x_end - word_idx * MASK_WORD_BITS;
+    uint64_t const from_start = bit_start <= 0 ? ~(uint64_t)0 : ~(uint64_t)0 << bit_start;
+    uint64_t const to_end = bit_end >= MASK_WORD_BITS ? ~(uint64_t)0 : ~(~(uint64_t)0 << bit_end);
+    return from_start & to_end;
+}
+
+/**
+ * @brief Fill the span of open pixels around a pixel and push it onto the stack. Spans get filled
+ * when they are found rather than when they are popped so no span is ever pushed twice.
+ * @param filled
+ * @param walls
+ * @param inside Can be NULL.
+ * @param x Column of an open pixel.
+ * @param y Row of the pixel.
+ * @param top Index of the top of the stack. It gets incremented.
+ * @return Number of filled pixels or -1 if the stack was full, in which case the span is filled but
+ * its neighbouring rows will not be checked.
+ */
+static int32_t span_push(mask_t *const filled,
+                         mask_t const *const walls,
+                         mask_t const *const inside,
+                         uint16_t const x,
+                         uint16_t const y,
+                         uint16_t *const top)
+{
+    uint8_t const bit = x % MASK_WORD_BITS;
+
+    /* Extend the span to the first closed pixels on both sides. */
+    int16_t word_idx = x / MASK_WORD_BITS;
+    uint64_t closed = ~word_open(filled, walls, inside, y, word_idx) & ~(~(uint64_t)0 << bit);
+    while (closed == 0 && word_idx > 0)
+    {
+        closed = ~word_open(filled, walls, inside, y, --word_idx);
+    }
+    uint16_t const x_start = closed == 0 ? 0 : word_idx * MASK_WORD_BITS + MASK_WORD_BITS - __builtin_clzll(closed);
+
+    word_idx = x / MASK_WORD_BITS;
+    closed = bit == MASK_WORD_BITS - 1 ? 0 : ~word_open(filled, walls, inside, y, word_idx) & (~(uint64_t)0 << (bit + 1));
+    while (closed == 0 && word_idx < MASK_WORDS - 1)
+    {
+        closed = ~word_open(filled, walls, inside, y, ++word_idx);
+    }
+    uint16_t const x_end = closed == 0 ? TCO_FRAME_WIDTH : word_idx * MASK_WORD_BITS + __builtin_ctzll(closed);
+
+    for (uint8_t word = x_start / MASK_WORD_BITS; word <= (x_end - 1) / MASK_WORD_BITS; word++)
+    {
+        filled->rows[y][word] |= word_range(word, x_start, x_end);
+    }
+    if (*top == FILL_STACK_MAX)
+    {
+        return -1;
+    }
+    stack[(*top)++] = (fill_span_t){y, x_start, x_end};
+    return x_end - x_start;
+}
+
+int32_t fill_span(mask_t *const filled, mask_t const *const walls, mask_t const *const inside, point2_t const seed)
+{
+    memset(filled, 0, sizeof(mask_t));
+    if (seed.x >= TCO_FRAME_WIDTH || seed.y >= TCO_FRAME_HEIGHT ||
+        ((word_open(filled, walls, inside, seed.y, seed.x / MASK_WORD_BITS) >> (seed.x % MASK_WORD_BITS)) & 1) == 0)
+    {
+        return 0;
+    }
+
+    uint8_t overflow = 0;
+    uint16_t top = 0;
+    int32_t pixel_num = span_push(filled, walls, inside, seed.x, seed.y, &top);
+    while (top > 0)
+    {
+        fill_span_t const span = stack[--top];
+        /* Every run of open pixels touching the span in the rows above and below is a new span. */
+        for (int8_t dy = -1; dy <= 1; dy += 2)
+        {
+            int16_t const y_next = span.y + dy;
+            if (y_next < 0 || y_next >= TCO_FRAME_HEIGHT)
+            {
+                continue;
+            }
+            for (uint8_t word = span.x_start / MASK_WORD_BITS; word <= (span.x_end - 1) / MASK_WORD_BITS; word++)
+            {
+                /* Read after filling the previous words since a span can reach into this one. */
+                uint64_t runs = word_open(filled, walls, inside, y_next, word) & word_range(word, span.x_start, span.x_end);
+                while (runs != 0)
+                {
+                    int32_t const span_pixel_num = span_push(filled, walls, inside, word * MASK_WORD_BITS + __builtin_ctzll(runs), y_next, &top);
+                    overflow |= span_pixel_num < 0;
+                    pixel_num += span_pixel_num < 0 ? -span_pixel_num : span_pixel_num;
+                    runs &= runs + (runs & -runs); /* Drop the lowest run. */
+                }
+            }
+        }
+    }
+    return overflow ? -1 : pixel_num;
+}
@@ -0,0 +1,28 @@
+#ifndef _FILL_H_
+#define _FILL_H_
+
+/**
+ * @brief Scanline flood fill on bit-packed masks. Every span is found and filled a 64 pixel word at
+ * a time and pending spans are kept on a fixed capacity stack, so filling never allocates memory.
+ */
+
+#include <stdint.h>
+#include "tco_shmem.h"
+#include "tco_linalg.h"
+#include "mask.h"
+
+#define FILL_STACK_MAX 8192 /* Filled spans whose neighbours are not checked yet. A fill which needs more is cut short. */
+
+/**
+ * @brief Fill the 4-connected region of open pixels around a seed.
+ * @param filled Where the region is written. It gets cleared first.
+ * @param walls Set pixels stop the fill e.g. a segmented frame.
+ * @param inside Only set pixels can be filled e.g. a region of interest. If NULL, the whole frame
+ * can be filled.
+ * @param seed Where the fill starts. Nothing is filled if it is not open.
+ * @return Number of filled pixels or -1 if the span stack overflowed, in which case the region is
+ * only partially filled.
+ */
+int32_t fill_span(mask_t *const filled, mask_t const *const walls, mask_t const *const inside, point2_t const seed);
+
+#endif /* _FILL_H_ */
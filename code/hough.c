@@ -0,0 +1,118 @@
+#include <string.h>
+#include <math.h>
+
+#include "hough.h"
+
+void hough_init(hough_t *const hough)
+{
+    memset(hough, 0, sizeof(hough_t));
+    float const theta_max = HOUGH_THETA_MAX_DEG * (float)M_PI / 180.0f;
+    for (uint8_t theta_idx = 0; theta_idx < HOUGH_THETA_NUM; theta_idx++)
+    {
+        float const theta = -theta_max + 2.0f * theta_max * theta_idx / HOUGH_THETA_NUM;
+        hough->cos[theta_idx] = lroundf(cosf(theta) * (1 << HOUGH_TRIG_SHIFT));
+        hough->sin[theta_idx] = lroundf(sinf(theta) * (1 << HOUGH_TRIG_SHIFT));
+    }
+}
+
+/**
+ * @brief Vote for every line through a point.
+ * @param hough
+ * @param x
+ * @param y
+ */
+static inline void hough_vote(hough_t *const hough, int32_t const x, int32_t const y)
+{
+    /* The bins are found in a loop of their own, with nothing but multiplies, adds and shifts, so
+    it gets vectorized. Only the increments are done one at a time. */
+    int32_t bins[HOUGH_THETA_NUM];
+    for (uint8_t theta_idx = 0; theta_idx < HOUGH_THETA_NUM; theta_idx++)
+    {
+        bins[theta_idx] = theta_idx * HOUGH_RHO_NUM +
+                          ((x * hough->cos[theta_idx] + y * hough->sin[theta_idx] + (HOUGH_RHO_OFFSET << HOUGH_TRIG_SHIFT)) >> (HOUGH_TRIG_SHIFT + HOUGH_RHO_SHIFT));
+    }
+    uint16_t *const votes = &hough->votes[0][0];
+    for (uint8_t theta_idx = 0; theta_idx < HOUGH_THETA_NUM; theta_idx++)
+    {
+        votes[bins[theta_idx]]++;
+    }
+}
+
+/**
+ * @brief Find the lines with the most votes which are each more than their 8 neighbours. Ties
+ * between neighbours go to the one scanned first. Bins on the edges of the votes are skipped so no
+ * neighbour needs checking against the bounds.
+ * @param hough
+ */
+static void hough_peaks(hough_t *const hough)
+{
+    hough->line_num = 0;
+    uint16_t votes_min = HOUGH_VOTES_MIN;
+    for (uint8_t theta_idx = 1; theta_idx < HOUGH_THETA_NUM - 1; theta_idx++)
+    {
+        uint16_t const *const above = hough->votes[theta_idx - 1];
+        uint16_t const *const row = hough->votes[theta_idx];
+        uint16_t const *const below = hough->votes[theta_idx + 1];
+        /* Most angles have no bin with enough votes. Their maximum is found by a loop which gets
+        vectorized, so only the few others are checked bin by bin. */
+        uint16_t row_max = 0;
+        for (uint16_t rho_idx = 0; rho_idx < HOUGH_RHO_NUM; rho_idx++)
+        {
+            row_max = row[rho_idx] > row_max ? row[rho_idx] : row_max;
+        }
+        if (row_max < votes_min)
+        {
+            continue;
+        }
+        for (uint16_t rho_idx = 1; rho_idx < HOUGH_RHO_NUM - 1; rho_idx++)
+        {
+            uint16_t const votes = row[rho_idx];
+            if (votes < votes_min)
+            {
+                continue;
+            }
+            /* Neighbours scanned before this bin must have fewer votes, later ones may tie. */
+            if (above[rho_idx - 1] >= votes || above[rho_idx] >= votes || above[rho_idx + 1] >= votes || row[rho_idx - 1] >= votes ||
+                row[rho_idx + 1] > votes || below[rho_idx - 1] > votes || below[rho_idx] > votes || below[rho_idx + 1] > votes)
+            {
+                continue;
+            }
+            /* Insert by votes, dropping the last line when full. */
+            uint8_t line_idx = hough->line_num < HOUGH_PEAKS_MAX ? hough->line_num++ : HOUGH_PEAKS_MAX - 1;
+            for (; line_idx > 0 && hough->lines[line_idx - 1].votes < votes; line_idx--)
+            {
+                hough->lines[line_idx] = hough->lines[line_idx - 1];
+            }
+            hough->lines[line_idx] = (hough_line_t){theta_idx, ((rho_idx << HOUGH_RHO_SHIFT) - HOUGH_RHO_OFFSET) + (1 << HOUGH_RHO_SHIFT) / 2, votes};
+            if (hough->line_num == HOUGH_PEAKS_MAX)
+            {
+                votes_min = hough->lines[HOUGH_PEAKS_MAX - 1].votes + 1;
+            }
+        }
+    }
+}
+
+void hough_step(hough_t *const hough, rle_t const *const rle, uint16_t const y_start, uint16_t const y_end, uint16_t const center)
+{
+    memset(hough->votes, 0, sizeof(hough->votes));
+    hough->point_num = 0;
+    for (uint16_t y = y_start; y < y_end && y < TCO_FRAME_HEIGHT; y++)
+    {
+        for (uint16_t run_idx = 0; run_idx < rle->run_num[y]; run_idx++)
+        {
+            rle_run_t const run = rle->runs[y][run_idx];
+            /* Only the ends facing the center lie on the inner side of a border. */
+            if (run.x_end <= center)
+            {
+                hough_vote(hough, run.x_end - 1, y);
+                hough->point_num++;
+            }
+            else if (run.x_start > center)
+            {
+                hough_vote(hough, run.x_start, y);
+                hough->point_num++;
+            }
+        }
+    }
+    hough_peaks(hough);
+}
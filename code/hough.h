@@ -0,0 +1,78 @@
+#ifndef _HOUGH_H_
+#define _HOUGH_H_
+
+/**
+ * @brief Hough transform finding the straight borders of the track in a segmented frame. Every end
+ * of a white run which faces the track center votes for all lines through it,
+ * x * cos(theta) + y * sin(theta) = rho, so a border broken into dashes or with gaps still gathers
+ * its votes in one bin. Only normals within @c HOUGH_THETA_MAX_DEG of the horizontal are voted for
+ * since the borders never lie flatter than that in the camera's view. The sines and cosines are
+ * integer tables and the votes 16-bit, and the distances for every angle are computed in a loop on
+ * their own which the compiler vectorizes. Peaks are found in a single pass over the votes.
+ */
+
+#include <stdint.h>
+#include "tco_shmem.h"
+#include "tco_linalg.h"
+#include "rle.h"
+
+#define HOUGH_THETA_NUM 32     /* Angles voted for, evenly spread over the band, about 4 degrees apart. */
+#define HOUGH_THETA_MAX_DEG 60 /* Normals of the lines lie within this many degrees of the horizontal. */
+#define HOUGH_TRIG_SHIFT 14    /* Sines and cosines are held in 1 / (1 << HOUGH_TRIG_SHIFT) . */
+#define HOUGH_RHO_SHIFT 1      /* Distance bins are (1 << HOUGH_RHO_SHIFT) pixels wide. */
+#define HOUGH_RHO_OFFSET TCO_FRAME_HEIGHT /* Distances in the band are at least -TCO_FRAME_HEIGHT. */
+#define HOUGH_RHO_NUM ((TCO_FRAME_WIDTH + 2 * TCO_FRAME_HEIGHT) >> HOUGH_RHO_SHIFT)
+#define HOUGH_PEAKS_MAX 8  /* Lines kept, the most voted for first. */
+#define HOUGH_VOTES_MIN 40 /* Votes a line needs to be kept. */
+
+typedef struct hough_line
+{
+    uint8_t theta_idx;
+    int16_t rho;     /* Pixels, center of the bin. */
+    uint16_t votes;
+} hough_line_t;
+
+typedef struct hough
+{
+    int32_t cos[HOUGH_THETA_NUM]; /* In 1 / (1 << HOUGH_TRIG_SHIFT) . Kept in 32 bits so the votes' products need no widening. */
+    int32_t sin[HOUGH_THETA_NUM];
+    /* Never more than a few votes per row land in a bin since lines in the band cross every row
+    once, so 16 bits do not overflow. */
+    uint16_t votes[HOUGH_THETA_NUM][HOUGH_RHO_NUM];
+    uint32_t point_num; /* Points which voted in the last step. */
+    uint8_t line_num;
+    hough_line_t lines[HOUGH_PEAKS_MAX];
+} hough_t;
+
+/**
+ * @brief Build the tables of sines and cosines.
+ * @param hough
+ */
+void hough_init(hough_t *const hough);
+
+/**
+ * @brief Vote for the lines through the ends of the white runs on a range of rows and find the
+ * most voted for ones. Runs left of the center vote with their right end and runs right of it with
+ * their left end, runs across it not at all.
+ * @param hough Where the votes and the lines are written.
+ * @param rle Runs of a segmented frame.
+ * @param y_start First row to vote from.
+ * @param y_end Row after the last one to vote from.
+ * @param center Column of the track center.
+ */
+void hough_step(hough_t *const hough, rle_t const *const rle, uint16_t const y_start, uint16_t const y_end, uint16_t const center);
+
+/**
+ * @brief Get the column of a line on a row. The band keeps the cosine at least a half so this never
+ * divides by zero.
+ * @param hough
+ * @param line
+ * @param y
+ * @return Column, which can lie outside the frame.
+ */
+static inline int16_t hough_line_x(hough_t const *const hough, hough_line_t const *const line, int16_t const y)
+{
+    return (((int32_t)line->rho << HOUGH_TRIG_SHIFT) - y * hough->sin[line->theta_idx]) / hough->cos[line->theta_idx];
+}
+
+#endif /* _HOUGH_H_ */
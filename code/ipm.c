@@ -0,0 +1,180 @@
+#include <stdlib.h>
+
+#include <math.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "tco_libd.h"
+
+#include "ipm.h"
+
+void ipm_source(ipm_calib_t const *const calib, uint16_t const u, uint16_t const v, uint32_t *const offset, uint8_t *const frac_x, uint8_t *const frac_y)
+{
+    float const *const h = calib->homography;
+    float const w = h[6] * u + h[7] * v + h[8];
+    float const x = (h[0] * u + h[1] * v + h[2]) / w;
+    float const y = (h[3] * u + h[4] * v + h[5]) / w;
+    if (!(w > 0.0f) || !(x >= 0.0f && x <= TCO_FRAME_WIDTH - 1) || !(y >= 0.0f && y <= TCO_FRAME_HEIGHT - 1))
+    {
+        *offset = IPM_OUTSIDE;
+        *frac_x = 0;
+        *frac_y = 0;
+        return;
+    }
+    /* The block is kept inside the frame by moving it left or up at the last column and row, where
+    the position is then a whole pixel from its origin. */
+    uint32_t const x_fixed = lrintf(x * IPM_FRAC_ONE);
+    uint32_t const y_fixed = lrintf(y * IPM_FRAC_ONE);
+    uint16_t block_x = x_fixed >> IPM_FRAC_BITS;
+    uint16_t block_y = y_fixed >> IPM_FRAC_BITS;
+    block_x = block_x < TCO_FRAME_WIDTH - 1 ? block_x : TCO_FRAME_WIDTH - 2;
+    block_y = block_y < TCO_FRAME_HEIGHT - 1 ? block_y : TCO_FRAME_HEIGHT - 2;
+    *offset = (uint32_t)block_y * TCO_FRAME_WIDTH + block_x;
+    *frac_x = x_fixed - (block_x << IPM_FRAC_BITS);
+    *frac_y = y_fixed - (block_y << IPM_FRAC_BITS);
+}
+
+int ipm_init(ipm_t *const ipm, ipm_calib_t const *const calib)
+{
+    if (calib->magic != IPM_CALIB_MAGIC || !(calib->mm_per_pixel > 0.0f) || !(calib->track_width_mm > 0.0f))
+    {
+        log_error("Calibration is not a valid inverse perspective mapping");
+        return EXIT_FAILURE;
+    }
+    float const track_width = calib->track_width_mm / calib->mm_per_pixel;
+    if (!(track_width >= 1.0f && track_width <= UINT16_MAX))
+    {
+        log_error("Track of the calibration is %.0f bird's-eye pixels wide, not 1 to %u", track_width, UINT16_MAX);
+        return EXIT_FAILURE;
+    }
+    /* Inverse from the adjugate of the homography, divided by its determinant. */
+    float const *const h = calib->homography;
+    float const adj[9] = {h[4] * h[8] - h[5] * h[7], h[2] * h[7] - h[1] * h[8], h[1] * h[5] - h[2] * h[4],
+                          h[5] * h[6] - h[3] * h[8], h[0] * h[8] - h[2] * h[6], h[2] * h[3] - h[0] * h[5],
+                          h[3] * h[7] - h[4] * h[6], h[1] * h[6] - h[0] * h[7], h[0] * h[4] - h[1] * h[3]};
+    float const det = h[0] * adj[0] + h[1] * adj[3] + h[2] * adj[6];
+    if (!(fabsf(det) > 0.0f) || !isfinite(det))
+    {
+        log_error("Homography of the calibration can not be inverted");
+        return EXIT_FAILURE;
+    }
+    for (uint8_t idx = 0; idx < 9; idx++)
+    {
+        ipm->frame_to_bird[idx] = adj[idx] / det;
+    }
+    ipm->mm_per_pixel = calib->mm_per_pixel;
+    ipm->track_width_mm = calib->track_width_mm;
+    uint32_t outside_num = 0;
+    for (uint16_t v = 0; v < TCO_FRAME_HEIGHT; v++)
+    {
+        for (uint16_t u = 0; u < TCO_FRAME_WIDTH; u++)
+        {
+            ipm_source(calib, u, v, &ipm->offsets[v][u], &ipm->frac_x[v][u], &ipm->frac_y[v][u]);
+            uint32_t const offset = ipm->offsets[v][u];
+            ipm->offsets_nearest[v][u] = offset == IPM_OUTSIDE ? IPM_OUTSIDE
+                                                               : offset + (ipm->frac_x[v][u] >= IPM_FRAC_ONE / 2) + (ipm->frac_y[v][u] >= IPM_FRAC_ONE / 2) * TCO_FRAME_WIDTH;
+            outside_num += offset == IPM_OUTSIDE;
+        }
+    }
+    log_info("Bird's-eye view covers %.0f x %.0f mm, %u of %u of its pixels lie outside the frame",
+             TCO_FRAME_WIDTH * ipm->mm_per_pixel, TCO_FRAME_HEIGHT * ipm->mm_per_pixel, outside_num, TCO_FRAME_WIDTH * TCO_FRAME_HEIGHT);
+    return EXIT_SUCCESS;
+}
+
+int ipm_to_bird(ipm_t const *const ipm, point2_t const frame, point2_t *const bird)
+{
+    float const *const h = ipm->frame_to_bird;
+    float const w = h[6] * frame.x + h[7] * frame.y + h[8];
+    float const u = (h[0] * frame.x + h[1] * frame.y + h[2]) / w;
+    float const v = (h[3] * frame.x + h[4] * frame.y + h[5]) / w;
+    if (!(w > 0.0f) || !(u >= 0.0f && u <= TCO_FRAME_WIDTH - 1) || !(v >= 0.0f && v <= TCO_FRAME_HEIGHT - 1))
+    {
+        return EXIT_FAILURE;
+    }
+    *bird = (point2_t){lrintf(u), lrintf(v)};
+    return EXIT_SUCCESS;
+}
+
+int ipm_load(ipm_t *const ipm, char const *const path)
+{
+    int const fd = open(path, O_RDONLY);
+    if (fd == -1)
+    {
+        log_error("Failed to open calibration at '%s': %s", path, strerror(errno));
+        return EXIT_FAILURE;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1 || file_stat.st_size != sizeof(ipm_calib_t))
+    {
+        log_error("Calibration at '%s' is not %zu bytes long", path, sizeof(ipm_calib_t));
+        close(fd);
+        return EXIT_FAILURE;
+    }
+    void *const calib = mmap(NULL, sizeof(ipm_calib_t), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (calib == MAP_FAILED)
+    {
+        log_error("Failed to map calibration at '%s': %s", path, strerror(errno));
+        return EXIT_FAILURE;
+    }
+    int const status = ipm_init(ipm, (ipm_calib_t const *)calib);
+    munmap(calib, sizeof(ipm_calib_t));
+    return status;
+}
+
+void ipm_remap(ipm_t const *const ipm,
+               uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+               uint8_t (*const out)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+               ipm_sample_t const sample)
+{
+    uint8_t const *const src = &(*pixels)[0][0];
+    for (uint16_t v = 0; v < TCO_FRAME_HEIGHT; v++)
+    {
+        uint32_t const *const offsets = ipm->offsets[v];
+        uint8_t const *const frac_x = ipm->frac_x[v];
+        uint8_t const *const frac_y = ipm->frac_y[v];
+        uint8_t *const row = (*out)[v];
+        if (sample == IPM_SAMPLE_NEAREST)
+        {
+            uint32_t const *const offsets_nearest = ipm->offsets_nearest[v];
+            for (uint16_t u = 0; u < TCO_FRAME_WIDTH; u++)
+            {
+                row[u] = offsets_nearest[u] != IPM_OUTSIDE ? src[offsets_nearest[u]] : 0;
+            }
+        }
+        else
+        {
+            for (uint16_t u = 0; u < TCO_FRAME_WIDTH; u++)
+            {
+                row[u] = ipm_sample(src, offsets[u], frac_x[u], frac_y[u], IPM_SAMPLE_BILINEAR);
+            }
+        }
+    }
+}
+
+uint16_t ipm_ray_cast(ipm_t const *const ipm,
+                      ray_tmpl_t const *const tmpl,
+                      uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+                      point2_t const origin)
+{
+    if (origin.x >= TCO_FRAME_WIDTH || origin.y >= TCO_FRAME_HEIGHT)
+    {
+        return 0;
+    }
+    uint16_t const step_num = ray_tmpl_steps_inside(tmpl, origin);
+    uint32_t const *const start = &ipm->offsets_nearest[origin.y][origin.x];
+    uint8_t const *const src = &(*pixels)[0][0];
+    int32_t const *const offsets = tmpl->offsets;
+    uint16_t step = 0;
+    /* Pixels seen outside the frame are black, as 'ipm_remap' makes them. */
+    while (step < step_num && (start[offsets[step]] == IPM_OUTSIDE || src[start[offsets[step]]] != 255))
+    {
+        step++;
+    }
+    /* A ray which reaches the border ends on its last pixel inside, like 'ray_tmpl_cast'. */
+    return step < step_num ? step : step_num - 1;
+}
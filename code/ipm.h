@@ -0,0 +1,140 @@
+#ifndef _IPM_H_
+#define _IPM_H_
+
+/**
+ * @brief Inverse perspective mapping which remaps frames to a bird's-eye view where a pixel covers
+ * the same distance on the ground everywhere. The bird's-eye view has the size of a frame so every
+ * function working on frames works on it too. Where every output pixel samples the input is
+ * computed once from a calibrated homography and kept in a lookup table of fixed-point
+ * coordinates, so remapping a frame does no float math.
+ */
+
+#include <stdint.h>
+#include "tco_shmem.h"
+#include "ray_tmpl.h"
+
+#define IPM_CALIB_MAGIC 0x314D5049 /* "IPM1" read as a little-endian 32 bit integer. */
+#define IPM_FRAC_BITS 7            /* Fraction bits of the sampling coordinates. */
+#define IPM_FRAC_ONE (1 << IPM_FRAC_BITS)
+#define IPM_OUTSIDE UINT32_MAX /* Offset of output pixels which sample outside the frame. They are black. */
+
+/* Layout of a calibration file, as written by the calibration tool. All values are little-endian. */
+typedef struct ipm_calib
+{
+    uint32_t magic;        /* Must be IPM_CALIB_MAGIC. */
+    float mm_per_pixel;    /* Ground distance covered by a bird's-eye pixel. */
+    float track_width_mm;  /* Width of the track measured when calibrating. */
+    float homography[9];   /* Row-major 3x3 matrix from bird's-eye to frame coordinates. */
+} ipm_calib_t;
+
+typedef enum ipm_sample
+{
+    IPM_SAMPLE_NEAREST = 0, /* Keeps the values of binary frames e.g. segmented frames. */
+    IPM_SAMPLE_BILINEAR,    /* Smoother remap of grayscale frames. */
+} ipm_sample_t;
+
+typedef struct ipm
+{
+    float mm_per_pixel;
+    float track_width_mm;
+    float frame_to_bird[9]; /* Row-major inverse of the homography, to find frame points in the bird's-eye view. */
+    /* Frame pixel whose 2x2 block every output pixel samples, as an offset from the first pixel. */
+    uint32_t offsets[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH];
+    /* Position inside the block in 1 / IPM_FRAC_ONE pixels, from 0 to IPM_FRAC_ONE inclusive. */
+    uint8_t frac_x[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH];
+    uint8_t frac_y[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH];
+    uint32_t offsets_nearest[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH]; /* Frame pixel closest to every output pixel, for remapping binary frames with a single read. */
+} ipm_t;
+
+/**
+ * @brief Find where a bird's-eye pixel samples the frame with the homography of a calibration.
+ * This is the float math the lookup table saves.
+ * @param calib
+ * @param u Horizontal bird's-eye coordinate.
+ * @param v Vertical bird's-eye coordinate.
+ * @param offset Where the offset of the sampled 2x2 block is written, or @c IPM_OUTSIDE .
+ * @param frac_x Where the horizontal position inside the block is written.
+ * @param frac_y Where the vertical position inside the block is written.
+ */
+void ipm_source(ipm_calib_t const *const calib, uint16_t const u, uint16_t const v, uint32_t *const offset, uint8_t *const frac_x, uint8_t *const frac_y);
+
+/**
+ * @brief Build the lookup table of a calibration. Calibrations whose homography cannot be inverted
+ * or whose track is not 1 to @c UINT16_MAX bird's-eye pixels wide are rejected.
+ * @param ipm
+ * @param calib
+ * @return 0 on success, 1 on failure.
+ */
+int ipm_init(ipm_t *const ipm, ipm_calib_t const *const calib);
+
+/**
+ * @brief Map a calibration file into memory and build its lookup table.
+ * @param ipm
+ * @param path Path to a file holding an @c ipm_calib_t .
+ * @return 0 on success, 1 on failure.
+ */
+int ipm_load(ipm_t *const ipm, char const *const path);
+
+/**
+ * @brief Find the bird's-eye pixel a frame point is seen on.
+ * @param ipm
+ * @param frame Point of the frame.
+ * @param bird Where the bird's-eye pixel is written.
+ * @return 0 on success, 1 if the point is not seen inside the bird's-eye view.
+ */
+int ipm_to_bird(ipm_t const *const ipm, point2_t const frame, point2_t *const bird);
+
+/**
+ * @brief Sample a single pixel of the bird's-eye view.
+ * @param pixels Frame to sample.
+ * @param offset Offset of the sampled 2x2 block or @c IPM_OUTSIDE .
+ * @param frac_x
+ * @param frac_y
+ * @param sample
+ * @return Value of the bird's-eye pixel.
+ */
+static inline uint8_t ipm_sample(uint8_t const *const pixels, uint32_t const offset, uint8_t const frac_x, uint8_t const frac_y, ipm_sample_t const sample)
+{
+    if (offset == IPM_OUTSIDE)
+    {
+        return 0;
+    }
+    if (sample == IPM_SAMPLE_NEAREST)
+    {
+        return pixels[offset + (frac_x >= IPM_FRAC_ONE / 2) + (frac_y >= IPM_FRAC_ONE / 2) * TCO_FRAME_WIDTH];
+    }
+    uint8_t const *const block = &pixels[offset];
+    uint32_t const top = block[0] * (IPM_FRAC_ONE - frac_x) + block[1] * frac_x;
+    uint32_t const bot = block[TCO_FRAME_WIDTH] * (IPM_FRAC_ONE - frac_x) + block[TCO_FRAME_WIDTH + 1] * frac_x;
+    return (top * (IPM_FRAC_ONE - frac_y) + bot * frac_y + (1 << (2 * IPM_FRAC_BITS - 1))) >> (2 * IPM_FRAC_BITS);
+}
+
+/**
+ * @brief Remap a frame to the bird's-eye view through the lookup table.
+ * @param ipm
+ * @param pixels Frame to remap, raw or segmented.
+ * @param out Where the bird's-eye view is written. Must not be @p pixels .
+ * @param sample
+ */
+void ipm_remap(ipm_t const *const ipm,
+               uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+               uint8_t (*const out)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+               ipm_sample_t const sample);
+
+/**
+ * @brief Cast a ray which stops at white along a template on the bird's-eye view of a frame without
+ * remapping the frame. Every step the template takes is looked up in the lookup table, so only the
+ * pixels the ray visits get remapped. Lengths are the same as of @c ray_tmpl_cast on the view which
+ * @c ipm_remap makes with @c IPM_SAMPLE_NEAREST .
+ * @param ipm
+ * @param tmpl
+ * @param pixels A segmented frame.
+ * @param origin Where the raycast will begin, on the bird's-eye view.
+ * @return Length of the ray in bird's-eye pixels.
+ */
+uint16_t ipm_ray_cast(ipm_t const *const ipm,
+                      ray_tmpl_t const *const tmpl,
+                      uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+                      point2_t const origin);
+
+#endif /* _IPM_H_ */
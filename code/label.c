@@ -0,0 +1,250 @@
+#include "label.h"
+
+static label_region_t components[LABEL_COMPONENTS_MAX]; /* Statistics of all components before filtering. */
+static uint32_t component_sum_x[LABEL_COMPONENTS_MAX];   /* Sums of the pixel coordinates for the centroids. */
+static uint32_t component_sum_y[LABEL_COMPONENTS_MAX];
+static uint16_t component_region[LABEL_COMPONENTS_MAX]; /* Region every component became or LABEL_NONE. */
+
+/**
+ * @brief Find the root run of a component while halving the path to it.
+ * @param runs
+ * @param run_idx
+ * @return Index of the root run. It is the lowest index in the component.
+ */
+static inline uint16_t run_find(label_run_t *const runs, uint16_t run_idx)
+{
+    while (runs[run_idx].label != run_idx)
+    {
+        runs[run_idx].label = runs[runs[run_idx].label].label;
+        run_idx = runs[run_idx].label;
+    }
+    return run_idx;
+}
+
+/**
+ * @brief Merge the components of two runs. The root with the higher index gets attached to the
+ * other one so every run's parent comes before it.
+ * @param runs
+ * @param run_a
+ * @param run_b
+ */
+static inline void run_union(label_run_t *const runs, uint16_t const run_a, uint16_t const run_b)
+{
+    uint16_t const root_a = run_find(runs, run_a);
+    uint16_t const root_b = run_find(runs, run_b);
+    if (root_a < root_b)
+    {
+        runs[root_b].label = root_a;
+    }
+    else if (root_b < root_a)
+    {
+        runs[root_a].label = root_b;
+    }
+}
+
+/**
+ * @brief Add a run to the table and join it with the runs of the row above which it touches.
+ * @param table
+ * @param y Row of the run.
+ * @param x_start
+ * @param x_end
+ * @param above Index of the first run of the row above which can still touch the runs of this
+ * row. It gets moved forward past runs which end before this one.
+ * @return 0 on success or -1 if the run table is full.
+ */
+static int run_add(label_table_t *const table, uint16_t const y, uint16_t const x_start, uint16_t const x_end, uint16_t *const above)
+{
+    uint16_t const run_idx = table->row_run_start[y + 1];
+    if (run_idx == LABEL_RUNS_MAX)
+    {
+        return -1;
+    }
+    table->runs[run_idx] = (label_run_t){x_start, x_end, run_idx};
+    table->row_run_start[y + 1]++;
+
+    if (y == 0)
+    {
+        return 0;
+    }
+    /* Runs touch diagonally too so a run of the row above ending right before this one connects. */
+    uint16_t const above_end = table->row_run_start[y];
+    while (*above < above_end && table->runs[*above].x_end < x_start)
+    {
+        (*above)++;
+    }
+    for (uint16_t above_idx = *above; above_idx < above_end && table->runs[above_idx].x_start <= x_end; above_idx++)
+    {
+        run_union(table->runs, above_idx, run_idx);
+    }
+    return 0;
+}
+
+/**
+ * @brief Find the runs of a row and join them with the row above.
+ * @param table
+ * @param mask
+ * @param y
+ * @return 0 on success or -1 if the run table is full.
+ */
+static int row_label(label_table_t *const table, mask_t const *const mask, uint16_t const y)
+{
+    table->row_run_start[y + 1] = table->row_run_start[y];
+    uint16_t above = y > 0 ? table->row_run_start[y - 1] : 0;
+    uint16_t x_start = 0;
+    uint8_t in_run = 0;
+    uint64_t carry = 0; /* Last pixel of the previous word. */
+    for (uint8_t word_idx = 0; word_idx < MASK_WORDS; word_idx++)
+    {
+        uint64_t const word = mask->rows[y][word_idx];
+        /* Set bits mark pixels which differ from the pixel on their left i.e. where runs start or end. */
+        uint64_t edges = word ^ ((word << 1) | carry);
+        carry = word >> (MASK_WORD_BITS - 1);
+        for (; edges != 0; edges &= edges - 1)
+        {
+            uint16_t const x = word_idx * MASK_WORD_BITS + __builtin_ctzll(edges);
+            if (!in_run)
+            {
+                x_start = x;
+            }
+            else if (run_add(table, y, x_start, x, &above) != 0)
+            {
+                return -1;
+            }
+            in_run = !in_run;
+        }
+    }
+    if (in_run)
+    {
+        return run_add(table, y, x_start, TCO_FRAME_WIDTH, &above);
+    }
+    return 0;
+}
+
+int32_t label_mask(label_table_t *const table, mask_t const *const mask, uint32_t const area_min)
+{
+    table->overflow = 0;
+    table->row_run_start[0] = 0;
+    for (uint16_t y = 0; y < TCO_FRAME_HEIGHT; y++)
+    {
+        if (table->overflow)
+        {
+            table->row_run_start[y + 1] = table->row_run_start[y];
+        }
+        else if (row_label(table, mask, y) != 0)
+        {
+            table->overflow = 1;
+        }
+    }
+
+    /* Every run's parent comes before it, so runs resolve in order once their parent has. */
+    uint16_t component_num = 0;
+    for (uint16_t y = 0; y < TCO_FRAME_HEIGHT; y++)
+    {
+        for (uint16_t run_idx = table->row_run_start[y]; run_idx < table->row_run_start[y + 1]; run_idx++)
+        {
+            label_run_t *const run = &table->runs[run_idx];
+            uint16_t const len = run->x_end - run->x_start;
+            uint16_t component_idx;
+            if (run->label == run_idx)
+            {
+                if (component_num == LABEL_COMPONENTS_MAX)
+                {
+                    table->overflow = 1;
+                    run->label = LABEL_NONE;
+                    continue;
+                }
+                component_idx = component_num++;
+                components[component_idx] = (label_region_t){
+                    .area = 0,
+                    .x_min = run->x_start,
+                    .x_max = run->x_end - 1,
+                    .y_min = y,
+                    .y_max = y,
+                    .top_x_start = run->x_start,
+                    .top_x_end = run->x_end,
+                    .bot_x_start = run->x_start,
+                    .bot_x_end = run->x_end,
+                };
+                component_sum_x[component_idx] = 0;
+                component_sum_y[component_idx] = 0;
+            }
+            else
+            {
+                component_idx = table->runs[run->label].label;
+            }
+            run->label = component_idx;
+            if (component_idx == LABEL_NONE)
+            {
+                continue;
+            }
+
+            label_region_t *const component = &components[component_idx];
+            component->area += len;
+            component_sum_x[component_idx] += (uint32_t)len * (run->x_start + run->x_end - 1) / 2;
+            component_sum_y[component_idx] += (uint32_t)len * y;
+            component->x_min = run->x_start < component->x_min ? run->x_start : component->x_min;
+            component->x_max = run->x_end - 1 > component->x_max ? run->x_end - 1 : component->x_max;
+            if (y == component->y_min)
+            {
+                component->top_x_end = run->x_end;
+            }
+            if (y > component->y_max)
+            {
+                component->y_max = y;
+                component->bot_x_start = run->x_start;
+            }
+            component->bot_x_end = run->x_end;
+        }
+    }
+    table->component_num = component_num;
+
+    table->region_num = 0;
+    for (uint16_t component_idx = 0; component_idx < component_num; component_idx++)
+    {
+        label_region_t *const component = &components[component_idx];
+        component_region[component_idx] = LABEL_NONE;
+        if (component->area < area_min)
+        {
+            continue;
+        }
+        if (table->region_num == LABEL_REGIONS_MAX)
+        {
+            table->overflow = 1;
+            continue;
+        }
+        component->centroid = (point2_t){(component_sum_x[component_idx] + component->area / 2) / component->area,
+                                         (component_sum_y[component_idx] + component->area / 2) / component->area};
+        component_region[component_idx] = table->region_num;
+        table->regions[table->region_num++] = *component;
+    }
+    for (uint16_t run_idx = 0; run_idx < table->row_run_start[TCO_FRAME_HEIGHT]; run_idx++)
+    {
+        label_run_t *const run = &table->runs[run_idx];
+        run->label = run->label == LABEL_NONE ? LABEL_NONE : component_region[run->label];
+    }
+    return table->overflow ? -1 : table->region_num;
+}
+
+uint16_t label_at(label_table_t const *const table, uint16_t const x, uint16_t const y)
+{
+    /* Find the last run of the row starting at or before the pixel. */
+    uint16_t lo = table->row_run_start[y];
+    uint16_t hi = table->row_run_start[y + 1];
+    while (lo < hi)
+    {
+        uint16_t const mid = lo + (hi - lo) / 2;
+        if (table->runs[mid].x_start <= x)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    if (lo == table->row_run_start[y] || x >= table->runs[lo - 1].x_end)
+    {
+        return LABEL_NONE;
+    }
+    return table->runs[lo - 1].label;
+}
@@ -0,0 +1,76 @@
+#ifndef _LABEL_H_
+#define _LABEL_H_
+
+/**
+ * @brief Connected-component labelling of bit-packed masks. The blocks which get labelled are the
+ * horizontal runs of set pixels, found a 64 pixel word at a time. The first pass joins runs which
+ * touch a run of the row above with union-find and the second pass resolves every run to its
+ * component and gathers the statistics of the components from the runs, so pixels are read once.
+ * Everything is kept in fixed size tables and nothing gets allocated.
+ */
+
+#include <stdint.h>
+#include "tco_shmem.h"
+#include "tco_linalg.h"
+#include "mask.h"
+
+#define LABEL_RUNS_MAX 16384       /* Runs of set pixels in a frame. Rows past the one which overflows are not labelled. */
+#define LABEL_COMPONENTS_MAX 4096  /* Components before filtering by area. Later ones are dropped. */
+#define LABEL_REGIONS_MAX 256      /* Components which passed the area filter. Later ones are dropped. */
+#define LABEL_NONE UINT16_MAX      /* Label of pixels which do not belong to a region. */
+
+_Static_assert(LABEL_RUNS_MAX < LABEL_NONE, "Run indices must fit the labels");
+
+/* A connected group of set pixels (8-connectivity). */
+typedef struct label_region
+{
+    uint32_t area;     /* Number of pixels. */
+    point2_t centroid; /* Rounded mean of the pixel coordinates. */
+    uint16_t x_min;    /* Bounding box, all bounds inclusive. */
+    uint16_t x_max;
+    uint16_t y_min;
+    uint16_t y_max;
+    uint16_t top_x_start; /* Columns in [top_x_start, top_x_end) span the pixels of the top row. */
+    uint16_t top_x_end;
+    uint16_t bot_x_start; /* Columns in [bot_x_start, bot_x_end) span the pixels of the bottom row. */
+    uint16_t bot_x_end;
+} label_region_t;
+
+/* A horizontal run of set pixels. */
+typedef struct label_run
+{
+    uint16_t x_start; /* Columns in [x_start, x_end) are set. */
+    uint16_t x_end;
+    uint16_t label; /* Parent run while labelling, index of the region or LABEL_NONE after. */
+} label_run_t;
+
+typedef struct label_table
+{
+    uint16_t region_num;
+    uint16_t component_num; /* Components found including the ones filtered out or dropped. */
+    uint8_t overflow;       /* Set if runs, components or regions did not fit their tables. */
+    label_region_t regions[LABEL_REGIONS_MAX]; /* Ordered by their first pixel in raster order. */
+    uint16_t row_run_start[TCO_FRAME_HEIGHT + 1]; /* Runs of row 'y' are [row_run_start[y], row_run_start[y + 1]). */
+    label_run_t runs[LABEL_RUNS_MAX];
+} label_table_t;
+
+/**
+ * @brief Find the connected components of a mask and their statistics.
+ * @param table Where the components are written.
+ * @param mask Set pixels get labelled.
+ * @param area_min Components with fewer pixels are treated as noise and not stored as regions.
+ * @return Number of regions or -1 if a table overflowed, in which case the regions are incomplete.
+ */
+int32_t label_mask(label_table_t *const table, mask_t const *const mask, uint32_t const area_min);
+
+/**
+ * @brief Get the region a pixel belongs to by searching the runs of its row.
+ * @param table Labelled by @c label_mask .
+ * @param x Horizontal coordinate.
+ * @param y Vertical coordinate.
+ * @return Index of the region in @c table->regions or @c LABEL_NONE if the pixel is not set or
+ * belongs to a component which is not a region.
+ */
+uint16_t label_at(label_table_t const *const table, uint16_t const x, uint16_t const y);
+
+#endif /* _LABEL_H_ */
@@ -0,0 +1,201 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "lane.h"
+
+/**
+ * @brief Find the quadratic through three points.
+ * @param u Rows of the points, relative to the reference row.
+ * @param x Columns of the points.
+ * @param coeffs Where a, b and c are written.
+ * @return 0 on success, 1 if two of the points share a row.
+ */
+static int lane_through(float const u[3], float const x[3], float coeffs[3])
+{
+    float const d0 = (u[0] - u[1]) * (u[0] - u[2]);
+    float const d1 = (u[1] - u[0]) * (u[1] - u[2]);
+    float const d2 = (u[2] - u[0]) * (u[2] - u[1]);
+    if (d0 == 0.0f || d1 == 0.0f || d2 == 0.0f)
+    {
+        return EXIT_FAILURE;
+    }
+    /* Lagrange interpolation, expanded. */
+    float const w0 = x[0] / d0, w1 = x[1] / d1, w2 = x[2] / d2;
+    coeffs[0] = w0 + w1 + w2;
+    coeffs[1] = -(w0 * (u[1] + u[2]) + w1 * (u[0] + u[2]) + w2 * (u[0] + u[1]));
+    coeffs[2] = w0 * u[1] * u[2] + w1 * u[0] * u[2] + w2 * u[0] * u[1];
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Determinant of a 3x3 matrix.
+ * @param m Rows of the matrix.
+ * @return
+ */
+static double lane_det3(double const m[3][3])
+{
+    return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+           m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+           m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+}
+
+/**
+ * @brief Least squares fit of the inliers, by Cramer's rule on the normal equations. Falls back to
+ * a straight line when the inliers lie on only two rows.
+ * @param model Where a, b and c are written.
+ * @param points
+ * @param point_num
+ * @param inliers
+ * @return 0 on success, 1 if the inliers lie on a single row.
+ */
+static int lane_least_squares(lane_model_t *const model, point2_t const *const points, uint16_t const point_num, uint8_t const *const inliers)
+{
+    /* Sums of powers of the rows and of the columns times them, in double since the fourth powers
+    of rows grow past what a float holds exactly. */
+    double s[5] = {0.0, 0.0, 0.0, 0.0, 0.0};
+    double t[3] = {0.0, 0.0, 0.0};
+    for (uint16_t point_idx = 0; point_idx < point_num; point_idx++)
+    {
+        if (!inliers[point_idx])
+        {
+            continue;
+        }
+        double const u = (double)points[point_idx].y - model->y_ref;
+        double const x = points[point_idx].x;
+        double u_pow = 1.0;
+        for (uint8_t pow = 0; pow < 5; pow++)
+        {
+            s[pow] += u_pow;
+            if (pow < 3)
+            {
+                t[pow] += x * u_pow;
+            }
+            u_pow *= u;
+        }
+    }
+
+    double const m[3][3] = {{s[4], s[3], s[2]}, {s[3], s[2], s[1]}, {s[2], s[1], s[0]}};
+    double const det = lane_det3(m);
+    if (fabs(det) > 1e-6)
+    {
+        double const ma[3][3] = {{t[2], s[3], s[2]}, {t[1], s[2], s[1]}, {t[0], s[1], s[0]}};
+        double const mb[3][3] = {{s[4], t[2], s[2]}, {s[3], t[1], s[1]}, {s[2], t[0], s[0]}};
+        double const mc[3][3] = {{s[4], s[3], t[2]}, {s[3], s[2], t[1]}, {s[2], s[1], t[0]}};
+        model->a = lane_det3(ma) / det;
+        model->b = lane_det3(mb) / det;
+        model->c = lane_det3(mc) / det;
+        return EXIT_SUCCESS;
+    }
+    double const det_line = s[2] * s[0] - s[1] * s[1];
+    if (fabs(det_line) > 1e-6)
+    {
+        model->a = 0.0f;
+        model->b = (t[1] * s[0] - t[0] * s[1]) / det_line;
+        model->c = (s[2] * t[0] - s[1] * t[1]) / det_line;
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
+
+/**
+ * @brief Mark the points close to a model.
+ * @param model
+ * @param points
+ * @param point_num
+ * @param inliers Where 1 is written for points close to the model and 0 for the rest. Can be NULL
+ * to only count them.
+ * @return Number of inliers.
+ */
+static uint16_t lane_inliers(lane_model_t const *const model, point2_t const *const points, uint16_t const point_num, uint8_t *const inliers)
+{
+    uint16_t inlier_num = 0;
+    for (uint16_t point_idx = 0; point_idx < point_num; point_idx++)
+    {
+        uint8_t const inlier = fabsf(lane_x(model, points[point_idx].y) - points[point_idx].x) <= LANE_INLIER_DISTANCE;
+        if (inliers != NULL)
+        {
+            inliers[point_idx] = inlier;
+        }
+        inlier_num += inlier;
+    }
+    return inlier_num;
+}
+
+int lane_fit(lane_model_t *const model,
+             point2_t const *const points,
+             uint16_t const point_num,
+             uint16_t const y_ref,
+             uint8_t *const inliers)
+{
+    memset(model, 0, sizeof(lane_model_t));
+    model->y_ref = y_ref;
+    if (point_num < LANE_POINTS_MIN)
+    {
+        return EXIT_FAILURE;
+    }
+
+    /* Triples come from a fixed seed so a frame always fits the same way. */
+    uint32_t rand_state = 0x9E3779B9;
+    lane_model_t candidate = *model;
+    uint16_t inlier_num_best = 0;
+    for (uint8_t iteration = 0; iteration < LANE_RANSAC_ITERATIONS; iteration++)
+    {
+        float u[3], x[3];
+        for (uint8_t sample = 0; sample < 3; sample++)
+        {
+            /* xorshift32 */
+            rand_state ^= rand_state << 13;
+            rand_state ^= rand_state >> 17;
+            rand_state ^= rand_state << 5;
+            point2_t const point = points[rand_state % point_num];
+            u[sample] = (float)point.y - y_ref;
+            x[sample] = point.x;
+        }
+        float coeffs[3];
+        if (lane_through(u, x, coeffs) != EXIT_SUCCESS)
+        {
+            continue;
+        }
+        candidate.a = coeffs[0];
+        candidate.b = coeffs[1];
+        candidate.c = coeffs[2];
+        uint16_t const inlier_num = lane_inliers(&candidate, points, point_num, NULL);
+        if (inlier_num > inlier_num_best)
+        {
+            inlier_num_best = inlier_num;
+            *model = candidate;
+        }
+    }
+    if (inlier_num_best < LANE_POINTS_MIN)
+    {
+        /* No triple worked, e.g. all points share a few rows. Let least squares try all of them. */
+        memset(inliers, 1, point_num);
+    }
+    else
+    {
+        lane_inliers(model, points, point_num, inliers);
+    }
+    if (lane_least_squares(model, points, point_num, inliers) != EXIT_SUCCESS)
+    {
+        return EXIT_FAILURE;
+    }
+
+    /* The fit may have moved, so count again with it. */
+    model->inlier_num = lane_inliers(model, points, point_num, inliers);
+    model->y_min = TCO_FRAME_HEIGHT;
+    model->y_max = 0;
+    for (uint16_t point_idx = 0; point_idx < point_num; point_idx++)
+    {
+        if (inliers[point_idx])
+        {
+            model->y_min = points[point_idx].y < model->y_min ? points[point_idx].y : model->y_min;
+            model->y_max = points[point_idx].y > model->y_max ? points[point_idx].y : model->y_max;
+        }
+    }
+    /* Going up the frame is towards smaller rows, so the slope along the edge is -b. */
+    float const slope = -model->b;
+    model->heading = atanf(slope);
+    model->curvature = 2.0f * model->a / powf(1.0f + slope * slope, 1.5f);
+    return model->inlier_num >= LANE_POINTS_MIN ? EXIT_SUCCESS : EXIT_FAILURE;
+}
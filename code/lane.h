@@ -0,0 +1,61 @@
+#ifndef _LANE_H_
+#define _LANE_H_
+
+/**
+ * @brief Fits a lane edge with a quadratic x = a * y^2 + b * y + c through the edge points found on
+ * scan rows. Points which do not belong to the edge, such as where a scan hit something else on the
+ * track, are rejected by RANSAC: quadratics through random triples of points are scored by how many
+ * points lie close to them, for at most @c LANE_RANSAC_ITERATIONS triples, so the worst case time
+ * is fixed. The best one's inliers are then fit by least squares. Nothing is allocated, all storage
+ * is the caller's.
+ */
+
+#include <stdint.h>
+#include "tco_shmem.h"
+#include "tco_linalg.h"
+
+#define LANE_RANSAC_ITERATIONS 32 /* Triples tried, the hard cap on the work of a fit. */
+#define LANE_INLIER_DISTANCE 3.0f /* Pixels a point may lie from the quadratic horizontally to count as on it. */
+#define LANE_POINTS_MIN 3         /* A quadratic needs this many points. */
+
+typedef struct lane_model
+{
+    float a; /* x = a * (y - y_ref)^2 + b * (y - y_ref) + c */
+    float b;
+    float c;
+    uint16_t y_ref;     /* Row the model is centered on, where heading and curvature are taken. */
+    float heading;      /* Radians from straight up the frame, positive when the edge leans right. */
+    float curvature;    /* 1 / radius in pixels, positive when the edge bends right going up. */
+    uint16_t inlier_num;
+    uint16_t y_min;     /* Rows the inliers span. */
+    uint16_t y_max;
+} lane_model_t;
+
+/**
+ * @brief Fit a quadratic to points of an edge.
+ * @param model Where the fit is written.
+ * @param points Edge points, at most one per row works best.
+ * @param point_num
+ * @param y_ref Row to center the model on, usually the bottom scan row.
+ * @param inliers Scratch space of @p point_num entries. Set to 1 for the points the final fit used.
+ * @return 0 on success, 1 if there are fewer than @c LANE_POINTS_MIN inliers.
+ */
+int lane_fit(lane_model_t *const model,
+             point2_t const *const points,
+             uint16_t const point_num,
+             uint16_t const y_ref,
+             uint8_t *const inliers);
+
+/**
+ * @brief Get the column of an edge on a row.
+ * @param model
+ * @param y
+ * @return Column, which can lie outside the frame.
+ */
+static inline float lane_x(lane_model_t const *const model, float const y)
+{
+    float const dy = y - model->y_ref;
+    return (model->a * dy + model->b) * dy + model->c;
+}
+
+#endif /* _LANE_H_ */
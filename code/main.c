@@ -10,16 +10,39 @@
 #include "pre_proc.h"
 #include "planner.h"
 #include "draw.h"
+#include "bench.h"
+#include "roi.h"
+#include "pool.h"
+#include "segment.h"
+#include "pyramid.h"
 
 const int log_level = LOG_INFO | LOG_ERROR | LOG_DEBUG;
+#ifndef DRAW_DISABLED
 int draw_enabled = 1;
+#endif
 
 void usage()
 {
-  printf("Usage: ./tco_pland.bin <[--proc-test | -pr] | [--proc-real | -pr] | [--camera | -c] | [--help | -h]>\n"
+  printf("Usage: ./tco_pland.bin <[--proc-test | -pr] [options] | [--proc-real | -pr] [options] | [--camera | -c] | [--bench | -b] [frames] | [--help | -h]>\n"
          "'-pt': Runs the processing pipeline and shows the debug window with procesessed frames\n"
          "'-pr': Runs the processing pipeline without the debug window. This is the one that should be running on the target board.\n"
-         "'-c': Runs the camera reading pipeline.");
+         "tco_pland.bin is built without any debug drawing, so it shows frames with nothing drawn on them under '-pt'. Use tco_pland_debug.bin to see the drawing.\n"
+         "'-c': Runs the camera reading pipeline.\n"
+         "'-b': Checks the optimized kernels against their reference implementations and times them on raw frames read from the 'frames' file (or on synthetic frames if not given).\n"
+         "Options for '-pt' and '-pr':\n"
+         "'--roi | -r <file>': Only process pixels inside the region of interest described in 'file' (see roi.h for the format).\n"
+         "'--workers | -w <count>': Number of threads frame processing is split across. Defaults to one per core.\n"
+         "'--segment | -s <delta | adaptive>': Segment by a fixed threshold on the difference to nearby pixels (default) or by the local mean brightness.\n"
+         "'--pyramid | -py <levels>': Downsample segmented frames 'levels' times by 2 (at most %d) and find the planner's rays on the smallest one before tracing them on the full frame.\n"
+         "'--dist-map | -dm': Build a map of the distance to the next white pixel in the 8 compass directions of every segmented frame, which the planner's rays in those directions are read from.\n"
+         "'--label | -lb': Label the connected components of every segmented frame and report how many are large enough to be regions.\n"
+         "'--blocks | -bk': Build a map of which 8x8 and 32x32 blocks of every segmented frame hold any white, so the planner's rays jump over the empty ones.\n"
+         "'--subpix | -sx': Keep the grayscale frames and refine where the planner's rays end to a fraction of a pixel along their gradient. Not done on the bird's-eye view.\n"
+         "'--track | -tk': Follow the track edges from frame to frame, searching for them only around where they are predicted to be. The planner's rays, the search for the track borders and the fill of the track then start from the tracked track center instead of the frame center.\n"
+         "'--polar | -po <rays>': Cast 'rays' rays (at most %d) spread evenly over the directions of the planner's fan of 12 from its far origin instead of the fan.\n"
+         "'--edges | -e <scan | hough>': Also find the track borders on every frame by fitting lanes to edges scanned on rows or with the Hough transform, and report the time it takes.\n"
+         "'--ipm | -i <file>': Plan on the bird's-eye view of frames described by the calibration in 'file' (see ipm.h for the format).",
+         PYRAMID_LEVELS_MAX, PLNR_POLAR_RAYS_MAX);
 }
 
 void user_proc_func(uint8_t (*pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], int length, void *args)
@@ -42,24 +65,172 @@ int main(int argc, char *argv[])
     return EXIT_FAILURE;
   }
 
-  if (plnr_init() != 0)
+  if ((argc == 2 || argc == 3) && (strcmp(argv[1], "--bench") == 0 || strcmp(argv[1], "-b") == 0))
+  {
+    return bench_run(argc == 3 ? argv[2] : NULL);
+  }
+
+  static roi_t roi_loaded;
+  roi_t const *roi = NULL;
+  uint8_t worker_num = 0;
+  segment_mode_t segment_mode = SEGMENT_MODE_DELTA;
+  uint8_t pyramid_level_num = 0;
+  uint8_t dist_map_enabled = 0;
+  uint8_t subpix_enabled = 0;
+  uint8_t track_enabled = 0;
+  plnr_edges_t edges_mode = PLNR_EDGES_NONE;
+  uint16_t polar_angle_num = 0;
+  uint8_t block_map_enabled = 0;
+  uint8_t label_enabled = 0;
+  char const *ipm_path = NULL;
+  for (int arg_idx = 2; arg_idx < argc; arg_idx++)
+  {
+    if ((strcmp(argv[arg_idx], "--roi") == 0 || strcmp(argv[arg_idx], "-r") == 0) && arg_idx + 1 < argc)
+    {
+      if (roi_load(&roi_loaded, argv[++arg_idx]) != 0)
+      {
+        log_error("Failed to load the region of interest");
+        return EXIT_FAILURE;
+      }
+      roi = &roi_loaded;
+    }
+    else if ((strcmp(argv[arg_idx], "--workers") == 0 || strcmp(argv[arg_idx], "-w") == 0) && arg_idx + 1 < argc)
+    {
+      int const worker_num_arg = atoi(argv[++arg_idx]);
+      if (worker_num_arg < 1 || worker_num_arg > POOL_WORKERS_MAX)
+      {
+        log_error("Worker count must be between 1 and %d", POOL_WORKERS_MAX);
+        return EXIT_FAILURE;
+      }
+      worker_num = worker_num_arg;
+    }
+    else if ((strcmp(argv[arg_idx], "--ipm") == 0 || strcmp(argv[arg_idx], "-i") == 0) && arg_idx + 1 < argc)
+    {
+      ipm_path = argv[++arg_idx];
+    }
+    else if ((strcmp(argv[arg_idx], "--pyramid") == 0 || strcmp(argv[arg_idx], "-py") == 0) && arg_idx + 1 < argc)
+    {
+      int const pyramid_level_num_arg = atoi(argv[++arg_idx]);
+      if (pyramid_level_num_arg < 0 || pyramid_level_num_arg > PYRAMID_LEVELS_MAX)
+      {
+        log_error("Pyramid levels must be between 0 and %d", PYRAMID_LEVELS_MAX);
+        return EXIT_FAILURE;
+      }
+      pyramid_level_num = pyramid_level_num_arg;
+    }
+    else if (strcmp(argv[arg_idx], "--dist-map") == 0 || strcmp(argv[arg_idx], "-dm") == 0)
+    {
+      dist_map_enabled = 1;
+    }
+    else if (strcmp(argv[arg_idx], "--label") == 0 || strcmp(argv[arg_idx], "-lb") == 0)
+    {
+      label_enabled = 1;
+    }
+    else if (strcmp(argv[arg_idx], "--blocks") == 0 || strcmp(argv[arg_idx], "-bk") == 0)
+    {
+      block_map_enabled = 1;
+    }
+    else if (strcmp(argv[arg_idx], "--subpix") == 0 || strcmp(argv[arg_idx], "-sx") == 0)
+    {
+      subpix_enabled = 1;
+    }
+    else if (strcmp(argv[arg_idx], "--track") == 0 || strcmp(argv[arg_idx], "-tk") == 0)
+    {
+      track_enabled = 1;
+    }
+    else if ((strcmp(argv[arg_idx], "--polar") == 0 || strcmp(argv[arg_idx], "-po") == 0) && arg_idx + 1 < argc)
+    {
+      int const polar_angle_num_arg = atoi(argv[++arg_idx]);
+      if (polar_angle_num_arg < 2 || polar_angle_num_arg > PLNR_POLAR_RAYS_MAX)
+      {
+        log_error("Polar rays must be between 2 and %d", PLNR_POLAR_RAYS_MAX);
+        return EXIT_FAILURE;
+      }
+      polar_angle_num = polar_angle_num_arg;
+    }
+    else if ((strcmp(argv[arg_idx], "--edges") == 0 || strcmp(argv[arg_idx], "-e") == 0) && arg_idx + 1 < argc)
+    {
+      arg_idx++;
+      if (strcmp(argv[arg_idx], "scan") == 0)
+      {
+        edges_mode = PLNR_EDGES_SCAN;
+      }
+      else if (strcmp(argv[arg_idx], "hough") == 0)
+      {
+        edges_mode = PLNR_EDGES_HOUGH;
+      }
+      else
+      {
+        log_error("Unknown edge detector '%s'", argv[arg_idx]);
+        return EXIT_FAILURE;
+      }
+    }
+    else if ((strcmp(argv[arg_idx], "--segment") == 0 || strcmp(argv[arg_idx], "-s") == 0) && arg_idx + 1 < argc)
+    {
+      arg_idx++;
+      if (strcmp(argv[arg_idx], "delta") == 0)
+      {
+        segment_mode = SEGMENT_MODE_DELTA;
+      }
+      else if (strcmp(argv[arg_idx], "adaptive") == 0)
+      {
+        segment_mode = SEGMENT_MODE_ADAPTIVE;
+      }
+      else
+      {
+        log_error("Unknown segmentation mode '%s'", argv[arg_idx]);
+        return EXIT_FAILURE;
+      }
+    }
+    else
+    {
+      usage();
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (plnr_init(ipm_path) != 0)
   {
     log_error("Failed to init planner");
     return EXIT_FAILURE;
   }
+  plnr_track_set(track_enabled);
+  plnr_edges_set(edges_mode);
+  if (plnr_polar_set(polar_angle_num) != 0)
+  {
+    log_error("Failed to set up the free-space profile");
+    return EXIT_FAILURE;
+  }
+
+  if (pre_proc_init(roi) != 0)
+  {
+    log_error("Failed to init pre-processing");
+    return EXIT_FAILURE;
+  }
+  pre_proc_segment_mode_set(segment_mode);
+  pre_proc_pyramid_set(pyramid_level_num);
+  pre_proc_dist_map_set(dist_map_enabled);
+  pre_proc_gray_set(subpix_enabled);
+  pre_proc_block_map_set(block_map_enabled);
+  pre_proc_label_set(label_enabled);
 
-  if (argc == 2 && (strcmp(argv[1], "--proc-test") == 0 || strcmp(argv[1], "-pt") == 0))
+  if (argc >= 2 && (strcmp(argv[1], "--proc-test") == 0 || strcmp(argv[1], "-pt") == 0))
   {
-    return pl_mgr_run(1, 0, &user_proc_func, NULL, &user_deinit);
+#ifdef DRAW_DISABLED
+    log_info("Built without debug drawing, nothing will be drawn on the frames");
+#endif
+    return pl_mgr_run(1, 0, &user_proc_func, NULL, &user_deinit, worker_num);
   }
-  else if (argc == 2 && (strcmp(argv[1], "--proc-real") == 0 || strcmp(argv[1], "-pr") == 0))
+  else if (argc >= 2 && (strcmp(argv[1], "--proc-real") == 0 || strcmp(argv[1], "-pr") == 0))
   {
+#ifndef DRAW_DISABLED
     draw_enabled = 0;
-    return pl_mgr_run(0, 0, &user_proc_func, NULL, &user_deinit);
+#endif
+    return pl_mgr_run(0, 0, &user_proc_func, NULL, &user_deinit, worker_num);
   }
   else if (argc == 2 && (strcmp(argv[1], "--camera") == 0 || strcmp(argv[1], "-c") == 0))
   {
-    return pl_mgr_run(0, 1, NULL, NULL, NULL);
+    return pl_mgr_run(0, 1, NULL, NULL, NULL, 0);
   }
   else
   {
@@ -0,0 +1,193 @@
+#include <string.h>
+
+#include "mask.h"
+#include "simd.h"
+
+void mask_pack_row(uint64_t *const words, uint8_t const *const row)
+{
+    for (uint16_t word_idx = 0; word_idx < MASK_WORDS; word_idx++)
+    {
+        uint8_t const *const bytes = &row[word_idx * MASK_WORD_BITS];
+        uint64_t word = 0;
+#if defined(SIMD_NEON)
+        /* There is no NEON movemask so move every MSB to its bit position and add up the lanes. */
+        int8_t const shift_data[SIMD_WIDTH] = {0, 1, 2, 3, 4, 5, 6, 7, 0, 1, 2, 3, 4, 5, 6, 7};
+        int8x16_t const shift = vld1q_s8(shift_data);
+        for (uint8_t chunk = 0; chunk < MASK_WORD_BITS / SIMD_WIDTH; chunk++)
+        {
+            uint8x16_t const bits = vshlq_u8(vshrq_n_u8(vld1q_u8(&bytes[chunk * SIMD_WIDTH]), 7), shift);
+            uint64x2_t const sums = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(bits)));
+            uint64_t const bits16 = vgetq_lane_u64(sums, 0) | (vgetq_lane_u64(sums, 1) << 8);
+            word |= bits16 << (chunk * SIMD_WIDTH);
+        }
+#elif defined(SIMD_SSE2)
+        for (uint8_t chunk = 0; chunk < MASK_WORD_BITS / SIMD_WIDTH; chunk++)
+        {
+            uint64_t const bits16 = (uint16_t)_mm_movemask_epi8(_mm_loadu_si128((__m128i const *)&bytes[chunk * SIMD_WIDTH]));
+            word |= bits16 << (chunk * SIMD_WIDTH);
+        }
+#else
+        for (uint8_t bit = 0; bit < MASK_WORD_BITS; bit++)
+        {
+            word |= (uint64_t)(bytes[bit] >> 7) << bit;
+        }
+#endif
+        words[word_idx] = word;
+    }
+}
+
+void mask_unpack_row(uint8_t *const row, uint64_t const *const words)
+{
+    for (uint16_t word_idx = 0; word_idx < MASK_WORDS; word_idx++)
+    {
+        uint8_t *const bytes = &row[word_idx * MASK_WORD_BITS];
+        uint64_t const word = words[word_idx];
+#if defined(SIMD_NEON)
+        uint8_t const select_data[SIMD_WIDTH] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+        uint8x16_t const select = vld1q_u8(select_data);
+        for (uint8_t chunk = 0; chunk < MASK_WORD_BITS / SIMD_WIDTH; chunk++)
+        {
+            uint16_t const bits16 = word >> (chunk * SIMD_WIDTH);
+            uint8x16_t const bits = vcombine_u8(vdup_n_u8(bits16 & 0xFF), vdup_n_u8(bits16 >> 8));
+            vst1q_u8(&bytes[chunk * SIMD_WIDTH], vtstq_u8(bits, select));
+        }
+#elif defined(SIMD_SSE2)
+        __m128i const select = _mm_set_epi8(-128, 64, 32, 16, 8, 4, 2, 1, -128, 64, 32, 16, 8, 4, 2, 1);
+        for (uint8_t chunk = 0; chunk < MASK_WORD_BITS / SIMD_WIDTH; chunk++)
+        {
+            uint16_t const bits16 = word >> (chunk * SIMD_WIDTH);
+            __m128i const bits = _mm_set_epi64x((bits16 >> 8) * 0x0101010101010101ULL, (bits16 & 0xFF) * 0x0101010101010101ULL);
+            _mm_storeu_si128((__m128i *)&bytes[chunk * SIMD_WIDTH], _mm_cmpeq_epi8(_mm_and_si128(bits, select), select));
+        }
+#else
+        for (uint8_t bit = 0; bit < MASK_WORD_BITS; bit++)
+        {
+            bytes[bit] = (word >> bit) & 1 ? 255 : 0;
+        }
+#endif
+    }
+}
+
+void mask_from_row(mask_t *const mask, uint16_t const y, uint8_t const *const row)
+{
+    mask_pack_row(mask->rows[y], row);
+}
+
+void mask_from_frame(mask_t *const mask, uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+{
+    for (uint16_t y = 0; y < TCO_FRAME_HEIGHT; y++)
+    {
+        mask_from_row(mask, y, (*pixels)[y]);
+    }
+}
+
+void mask_to_frame(mask_t const *const mask, uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+{
+    for (uint16_t y = 0; y < TCO_FRAME_HEIGHT; y++)
+    {
+        mask_unpack_row((*pixels)[y], mask->rows[y]);
+    }
+}
+
+/**
+ * @brief Combine every pixel of a row with its left and right neighbour.
+ * @param row Row to combine.
+ * @param out Where the combined row is written.
+ * @param dilate_or_erode If 1 the pixels are OR-ed (dilation), if 0 they are AND-ed (erosion).
+ */
+static void row_horiz(uint64_t const *const row, uint64_t *const out, uint8_t const dilate_or_erode)
+{
+    for (uint8_t word_idx = 0; word_idx < MASK_WORDS; word_idx++)
+    {
+        uint64_t const prev = word_idx > 0 ? row[word_idx - 1] : 0;
+        uint64_t const next = word_idx < MASK_WORDS - 1 ? row[word_idx + 1] : 0;
+        uint64_t const left = (row[word_idx] << 1) | (prev >> (MASK_WORD_BITS - 1));  /* Bit x holds pixel x - 1. */
+        uint64_t const right = (row[word_idx] >> 1) | (next << (MASK_WORD_BITS - 1)); /* Bit x holds pixel x + 1. */
+        out[word_idx] = dilate_or_erode ? row[word_idx] | left | right : row[word_idx] & left & right;
+    }
+}
+
+/**
+ * @brief Shared implementation of 3x3 dilation and erosion.
+ * @param dst Where the result is written. It may be the same mask as @p src .
+ * @param src Mask to process.
+ * @param dilate_or_erode If 1 a dilation is done, if 0 an erosion.
+ */
+static void mask_morph(mask_t *const dst, mask_t const *const src, uint8_t const dilate_or_erode)
+{
+    /* Horizontal results of the row above, the current one and the one below. A source row is only
+    read before the matching destination row is written so the operation can be done in-place. */
+    uint64_t horiz[3][MASK_WORDS];
+    uint64_t const col_first = 1;
+    uint64_t const col_last = (uint64_t)1 << (MASK_WORD_BITS - 1);
+
+    row_horiz(src->rows[0], horiz[0], dilate_or_erode);
+    row_horiz(src->rows[1], horiz[1], dilate_or_erode);
+    for (uint16_t y = 1; y < TCO_FRAME_HEIGHT - 1; y++)
+    {
+        uint64_t const *const above = horiz[(y - 1) % 3];
+        uint64_t const *const now = horiz[y % 3];
+        uint64_t *const below = horiz[(y + 1) % 3];
+        row_horiz(src->rows[y + 1], below, dilate_or_erode);
+
+        for (uint8_t word_idx = 0; word_idx < MASK_WORDS; word_idx++)
+        {
+            uint64_t word = dilate_or_erode ? above[word_idx] | now[word_idx] | below[word_idx] : above[word_idx] & now[word_idx] & below[word_idx];
+            /* Keep the outermost columns unchanged. */
+            if (word_idx == 0)
+            {
+                word = (word & ~col_first) | (src->rows[y][word_idx] & col_first);
+            }
+            if (word_idx == MASK_WORDS - 1)
+            {
+                word = (word & ~col_last) | (src->rows[y][word_idx] & col_last);
+            }
+            dst->rows[y][word_idx] = word;
+        }
+    }
+    if (dst != src)
+    {
+        memcpy(dst->rows[0], src->rows[0], sizeof(dst->rows[0]));
+        memcpy(dst->rows[TCO_FRAME_HEIGHT - 1], src->rows[TCO_FRAME_HEIGHT - 1], sizeof(dst->rows[0]));
+    }
+}
+
+void mask_dilate(mask_t *const dst, mask_t const *const src)
+{
+    mask_morph(dst, src, 1);
+}
+
+void mask_erode(mask_t *const dst, mask_t const *const src)
+{
+    mask_morph(dst, src, 0);
+}
+
+uint16_t mask_scan_right(mask_t const *const mask, uint16_t const y, uint16_t const x)
+{
+    uint16_t word_idx = x / MASK_WORD_BITS;
+    uint64_t word = mask->rows[y][word_idx] & (~(uint64_t)0 << (x % MASK_WORD_BITS));
+    while (word == 0)
+    {
+        if (++word_idx == MASK_WORDS)
+        {
+            return TCO_FRAME_WIDTH;
+        }
+        word = mask->rows[y][word_idx];
+    }
+    return word_idx * MASK_WORD_BITS + __builtin_ctzll(word);
+}
+
+int16_t mask_scan_left(mask_t const *const mask, uint16_t const y, uint16_t const x)
+{
+    uint16_t word_idx = x / MASK_WORD_BITS;
+    uint64_t word = mask->rows[y][word_idx] & (~(uint64_t)0 >> (MASK_WORD_BITS - 1 - (x % MASK_WORD_BITS)));
+    while (word == 0)
+    {
+        if (word_idx-- == 0)
+        {
+            return -1;
+        }
+        word = mask->rows[y][word_idx];
+    }
+    return word_idx * MASK_WORD_BITS + (MASK_WORD_BITS - 1) - __builtin_clzll(word);
+}
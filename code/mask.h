@@ -0,0 +1,103 @@
+#ifndef _MASK_H_
+#define _MASK_H_
+
+/**
+ * @brief Bit-packed binary frames. A pixel takes one bit instead of a byte so a whole segmented
+ * frame fits in L1 and rows can be scanned a 64 pixel word at a time. Bit 'x % 64' of word 'x / 64'
+ * holds pixel 'x' of a row.
+ */
+
+#include <stdint.h>
+#include "tco_shmem.h"
+
+#define MASK_WORD_BITS 64
+#define MASK_WORDS (TCO_FRAME_WIDTH / MASK_WORD_BITS) /* Words in a row. */
+
+_Static_assert(TCO_FRAME_WIDTH % MASK_WORD_BITS == 0, "Mask rows must be a whole number of words");
+
+typedef struct mask
+{
+    uint64_t rows[TCO_FRAME_HEIGHT][MASK_WORDS];
+} mask_t;
+
+/**
+ * @brief Pack a segmented row into words.
+ * @param words Where the @c MASK_WORDS packed words are written.
+ * @param row A segmented row. Pixels at or above 128 are set, the rest are cleared.
+ */
+void mask_pack_row(uint64_t *const words, uint8_t const *const row);
+
+/**
+ * @brief Unpack words into a segmented row of 0s and 255s.
+ * @param row Where the row is written.
+ * @param words The @c MASK_WORDS packed words.
+ */
+void mask_unpack_row(uint8_t *const row, uint64_t const *const words);
+
+/**
+ * @brief Pack a single segmented row into a row of the mask.
+ * @param mask Where the row is written.
+ * @param y Index of the row in @p mask .
+ * @param row A segmented row. Pixels at or above 128 are set, the rest are cleared.
+ */
+void mask_from_row(mask_t *const mask, uint16_t const y, uint8_t const *const row);
+
+/**
+ * @brief Pack a segmented frame into a mask.
+ * @param mask Where the packed frame is written.
+ * @param pixels A segmented frame.
+ */
+void mask_from_frame(mask_t *const mask, uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH]);
+
+/**
+ * @brief Unpack a mask into a segmented frame of 0s and 255s.
+ * @param mask Mask to unpack.
+ * @param pixels Where the segmented frame is written.
+ */
+void mask_to_frame(mask_t const *const mask, uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH]);
+
+/**
+ * @brief Dilate with a 3x3 kernel. The outermost rows and columns are copied unchanged.
+ * @param dst Where the result is written. It may be the same mask as @p src .
+ * @param src Mask to dilate.
+ */
+void mask_dilate(mask_t *const dst, mask_t const *const src);
+
+/**
+ * @brief Erode with a 3x3 kernel. The outermost rows and columns are copied unchanged.
+ * @param dst Where the result is written. It may be the same mask as @p src .
+ * @param src Mask to erode.
+ */
+void mask_erode(mask_t *const dst, mask_t const *const src);
+
+/**
+ * @brief Find the first set pixel at or to the right of @p x .
+ * @param mask Mask to search.
+ * @param y Row to search in.
+ * @param x Where the search starts.
+ * @return Horizontal coordinate of the set pixel or TCO_FRAME_WIDTH if there is none.
+ */
+uint16_t mask_scan_right(mask_t const *const mask, uint16_t const y, uint16_t const x);
+
+/**
+ * @brief Find the first set pixel at or to the left of @p x .
+ * @param mask Mask to search.
+ * @param y Row to search in.
+ * @param x Where the search starts.
+ * @return Horizontal coordinate of the set pixel or -1 if there is none.
+ */
+int16_t mask_scan_left(mask_t const *const mask, uint16_t const y, uint16_t const x);
+
+/**
+ * @brief Read a single pixel.
+ * @param mask Mask to read from.
+ * @param x Horizontal coordinate.
+ * @param y Vertical coordinate.
+ * @return 1 if the pixel is set, 0 if not.
+ */
+static inline uint8_t mask_get(mask_t const *const mask, uint16_t const x, uint16_t const y)
+{
+    return (mask->rows[y][x / MASK_WORD_BITS] >> (x % MASK_WORD_BITS)) & 1;
+}
+
+#endif /* _MASK_H_ */
@@ -0,0 +1,327 @@
+#include <string.h>
+
+#include "morph.h"
+
+static void stage_push(morph_t *const morph, uint8_t const stage_idx, uint16_t const y, uint64_t const *const row);
+
+void morph_reset(morph_t *const morph)
+{
+    morph->stage_num = 0;
+    morph->clip = NULL;
+}
+
+void morph_clip(morph_t *const morph, mask_t const *const clip)
+{
+    morph->clip = clip;
+}
+
+int morph_add(morph_t *const morph, morph_op_t const op, uint8_t const width, uint8_t const height)
+{
+    if (morph->stage_num >= MORPH_STAGES_MAX ||
+        width % 2 == 0 || width > MORPH_KERNEL_MAX ||
+        height % 2 == 0 || height > MORPH_KERNEL_MAX)
+    {
+        return -1;
+    }
+    morph_stage_t *const stage = &morph->stages[morph->stage_num++];
+    stage->op = op;
+    stage->radius_x = width / 2;
+    stage->radius_y = height / 2;
+    memset(stage->cols_inner, 0, sizeof(stage->cols_inner));
+    for (uint16_t x = stage->radius_x; x < TCO_FRAME_WIDTH - stage->radius_x; x++)
+    {
+        stage->cols_inner[x / MASK_WORD_BITS] |= (uint64_t)1 << (x % MASK_WORD_BITS);
+    }
+    return 0;
+}
+
+int morph_close(morph_t *const morph, uint8_t const width, uint8_t const height)
+{
+    if (morph->stage_num + 2 > MORPH_STAGES_MAX ||
+        morph_add(morph, MORPH_DILATE, width, height) != 0 ||
+        morph_add(morph, MORPH_ERODE, width, height) != 0)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+int morph_open(morph_t *const morph, uint8_t const width, uint8_t const height)
+{
+    if (morph->stage_num + 2 > MORPH_STAGES_MAX ||
+        morph_add(morph, MORPH_ERODE, width, height) != 0 ||
+        morph_add(morph, MORPH_DILATE, width, height) != 0)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+uint16_t morph_halo(morph_t const *const morph)
+{
+    uint16_t halo = 0;
+    for (uint8_t stage_idx = 0; stage_idx < morph->stage_num; stage_idx++)
+    {
+        halo += morph->stages[stage_idx].radius_y;
+    }
+    return halo;
+}
+
+/**
+ * @brief Combine a packed row into another one.
+ * @param op Dilation combines with OR and erosion with AND.
+ * @param acc Row the result is written to.
+ * @param row Row to combine into @p acc .
+ */
+static void row_combine(morph_op_t const op, uint64_t *const acc, uint64_t const *const row)
+{
+    if (op == MORPH_DILATE)
+    {
+        for (uint8_t word_idx = 0; word_idx < MASK_WORDS; word_idx++)
+        {
+            acc[word_idx] |= row[word_idx];
+        }
+    }
+    else
+    {
+        for (uint8_t word_idx = 0; word_idx < MASK_WORDS; word_idx++)
+        {
+            acc[word_idx] &= row[word_idx];
+        }
+    }
+}
+
+/**
+ * @brief Set a packed row to the identity of the operation (empty for dilation, full for erosion).
+ * @param op
+ * @param row
+ */
+static void row_identity(morph_op_t const op, uint64_t *const row)
+{
+    memset(row, op == MORPH_DILATE ? 0x00 : 0xFF, MASK_WORDS * sizeof(uint64_t));
+}
+
+/**
+ * @brief Shift a packed row so pixel x gets the value of pixel x + @p shift . Pixels shifted in past
+ * the end of the row are cleared.
+ * @param in
+ * @param out
+ * @param shift Must be between 1 and 63.
+ */
+static void row_shift_down(uint64_t const *const in, uint64_t *const out, uint8_t const shift)
+{
+    for (uint8_t word_idx = 0; word_idx < MASK_WORDS; word_idx++)
+    {
+        uint64_t const next = word_idx + 1 < MASK_WORDS ? in[word_idx + 1] : 0;
+        out[word_idx] = (in[word_idx] >> shift) | (next << (MASK_WORD_BITS - shift));
+    }
+}
+
+/**
+ * @brief Shift a packed row so pixel x gets the value of pixel x - @p shift . Pixels shifted in
+ * before the start of the row are cleared.
+ * @param in
+ * @param out
+ * @param shift Must be between 1 and 63.
+ */
+static void row_shift_up(uint64_t const *const in, uint64_t *const out, uint8_t const shift)
+{
+    for (uint8_t word_idx = 0; word_idx < MASK_WORDS; word_idx++)
+    {
+        uint64_t const prev = word_idx > 0 ? in[word_idx - 1] : 0;
+        out[word_idx] = (in[word_idx] << shift) | (prev >> (MASK_WORD_BITS - shift));
+    }
+}
+
+/**
+ * @brief Horizontal pass. Combines each pixel with the 'radius_x' pixels on either side by doubling
+ * the combined span every step, i.e. log2 of the kernel width word operations per 64 pixels.
+ * Results within 'radius_x' of the row ends are garbage and get masked out by 'cols_inner'.
+ * @param stage
+ * @param row Packed input row.
+ * @param horiz Where the packed result is written.
+ */
+static void stage_horiz(morph_stage_t const *const stage, uint64_t const *const row, uint64_t *const horiz)
+{
+    uint8_t const kernel_width = stage->radius_x * 2 + 1;
+    uint64_t span[MASK_WORDS]; /* Pixel x holds the combination of pixels [x, x + span_width). */
+    uint64_t shifted[MASK_WORDS];
+    uint8_t span_width = 1;
+
+    if (kernel_width == 1)
+    {
+        memcpy(horiz, row, sizeof(span));
+        return;
+    }
+    memcpy(span, row, sizeof(span));
+    while (span_width * 2 <= kernel_width)
+    {
+        row_shift_down(span, shifted, span_width);
+        row_combine(stage->op, span, shifted);
+        span_width *= 2;
+    }
+    if (span_width < kernel_width)
+    {
+        /* Overlapping spans are fine since both operations are idempotent. */
+        row_shift_down(span, shifted, kernel_width - span_width);
+        row_combine(stage->op, span, shifted);
+    }
+    row_shift_up(span, horiz, stage->radius_x);
+}
+
+/**
+ * @brief Pass an output row of a stage to the next stage or write it to the destinations.
+ * @param morph
+ * @param stage_idx_next Index of the stage which receives the row.
+ * @param y Index of the row.
+ * @param row The packed row.
+ */
+static void stage_forward(morph_t *const morph, uint8_t const stage_idx_next, uint16_t const y, uint64_t const *row)
+{
+    if (stage_idx_next < morph->stage_num)
+    {
+        stage_push(morph, stage_idx_next, y, row);
+        return;
+    }
+    if (y >= morph->y_out_start && y < morph->y_out_end)
+    {
+        uint64_t row_clipped[MASK_WORDS];
+        if (morph->clip != NULL)
+        {
+            for (uint8_t word_idx = 0; word_idx < MASK_WORDS; word_idx++)
+            {
+                row_clipped[word_idx] = row[word_idx] & morph->clip->rows[y][word_idx];
+            }
+            row = row_clipped;
+        }
+        if (morph->dst != NULL)
+        {
+            mask_unpack_row((*morph->dst)[y], row);
+        }
+        if (morph->dst_mask != NULL)
+        {
+            memcpy(morph->dst_mask->rows[y], row, sizeof(morph->dst_mask->rows[y]));
+        }
+        morph->y_done = y + 1;
+    }
+}
+
+/**
+ * @brief Feed a row to a stage and forward every row the stage completes as a result.
+ * @param morph
+ * @param stage_idx Index of the stage which receives the row.
+ * @param y Index of the row.
+ * @param row The packed row.
+ */
+static void stage_push(morph_t *const morph, uint8_t const stage_idx, uint16_t const y, uint64_t const *const row)
+{
+    morph_stage_t *const stage = &morph->stages[stage_idx];
+    uint8_t const kernel_height = stage->radius_y * 2 + 1;
+    uint16_t const y_rel = y - morph->y_in_start;
+    uint8_t const slot = y_rel % kernel_height;
+
+    if (y_rel == 0)
+    {
+        stage->win_mid = 0;
+        row_identity(stage->op, stage->win_back);
+    }
+    memcpy(stage->rows_in[slot], row, sizeof(stage->rows_in[slot]));
+    stage_horiz(stage, row, stage->rows_horiz[slot]);
+    row_combine(stage->op, stage->win_back, stage->rows_horiz[slot]);
+
+    if (y_rel < stage->radius_y)
+    {
+        /* Rows closer to the start of the input than the kernel radius are passed on unchanged. */
+        stage->y_emit = y + 1;
+        stage_forward(morph, stage_idx + 1, y, stage->rows_in[slot]);
+    }
+    else if (y_rel >= stage->radius_y * 2)
+    {
+        uint16_t const win_start = y_rel - stage->radius_y * 2;
+        if (stage->win_mid <= win_start)
+        {
+            /* The older part of the window ran out so the whole window becomes the older part. This
+            happens once every kernel height rows which keeps the cost per row constant. */
+            for (int16_t win_idx = y_rel; win_idx >= win_start; win_idx--)
+            {
+                uint64_t *const front = stage->win_front[win_idx % kernel_height];
+                memcpy(front, stage->rows_horiz[win_idx % kernel_height], sizeof(stage->win_front[0]));
+                if (win_idx < y_rel)
+                {
+                    row_combine(stage->op, front, stage->win_front[(win_idx + 1) % kernel_height]);
+                }
+            }
+            stage->win_mid = y_rel + 1;
+            row_identity(stage->op, stage->win_back);
+        }
+
+        uint16_t const y_out = y - stage->radius_y;
+        uint64_t const *const row_in = stage->rows_in[(y_out - morph->y_in_start) % kernel_height];
+        uint64_t const *const front = stage->win_front[win_start % kernel_height];
+        for (uint8_t word_idx = 0; word_idx < MASK_WORDS; word_idx++)
+        {
+            uint64_t const vert = stage->op == MORPH_DILATE ? front[word_idx] | stage->win_back[word_idx]
+                                                            : front[word_idx] & stage->win_back[word_idx];
+            /* Pixels within the horizontal radius of the frame border are passed on unchanged. */
+            stage->row_out[word_idx] = (vert & stage->cols_inner[word_idx]) | (row_in[word_idx] & ~stage->cols_inner[word_idx]);
+        }
+        stage->y_emit = y_out + 1;
+        stage_forward(morph, stage_idx + 1, y_out, stage->row_out);
+    }
+
+    /* Rows closer to the end of the input than the kernel radius are passed on unchanged. */
+    if (y + 1 == morph->y_in_end)
+    {
+        for (uint16_t y_tail = stage->y_emit; y_tail < morph->y_in_end; y_tail++)
+        {
+            stage_forward(morph, stage_idx + 1, y_tail, stage->rows_in[(y_tail - morph->y_in_start) % kernel_height]);
+        }
+        stage->y_emit = morph->y_in_end;
+    }
+}
+
+void morph_begin(morph_t *const morph,
+                 uint8_t (*const dst)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+                 mask_t *const dst_mask,
+                 uint16_t const y_start,
+                 uint16_t const y_end)
+{
+    uint16_t const halo = morph_halo(morph);
+    morph->dst = dst;
+    morph->dst_mask = dst_mask;
+    morph->y_out_start = y_start;
+    morph->y_out_end = y_end;
+    morph->y_in_start = y_start > halo ? y_start - halo : 0;
+    morph->y_in_end = y_end + halo < TCO_FRAME_HEIGHT ? y_end + halo : TCO_FRAME_HEIGHT;
+    morph->y_in = morph->y_in_start;
+    morph->y_done = y_start;
+}
+
+void morph_push(morph_t *const morph, uint8_t const *const row)
+{
+    uint64_t row_packed[MASK_WORDS];
+    uint16_t const y = morph->y_in++;
+    mask_pack_row(row_packed, row);
+    if (morph->stage_num == 0)
+    {
+        stage_forward(morph, 0, y, row_packed);
+    }
+    else
+    {
+        stage_push(morph, 0, y, row_packed);
+    }
+}
+
+void morph_run(morph_t *const morph,
+               uint8_t (*const src)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+               uint8_t (*const dst)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+               mask_t *const dst_mask,
+               uint16_t const y_start,
+               uint16_t const y_end)
+{
+    morph_begin(morph, dst, dst_mask, y_start, y_end);
+    while (morph->y_in < morph->y_in_end)
+    {
+        morph_push(morph, (*src)[morph->y_in]);
+    }
+}
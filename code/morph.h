@@ -0,0 +1,146 @@
+#ifndef _MORPH_H_
+#define _MORPH_H_
+
+/**
+ * @brief Binary morphology on segmented frames with rectangular kernels of any odd size up to
+ * @c MORPH_KERNEL_MAX . Rows are bit-packed on entry so the horizontal pass works on 64 pixels per
+ * word operation and the vertical pass is a van Herk/Gil-Werman style sliding window which costs a
+ * constant number of word operations per row regardless of the kernel height. Several operations
+ * (e.g. a dilation followed by an erosion) are chained into stages which all run in a single sweep
+ * over the frame, keeping only a ring of kernel-height packed rows per stage.
+ */
+
+#include <stdint.h>
+#include "tco_shmem.h"
+#include "mask.h"
+
+#define MORPH_RADIUS_MAX 7
+#define MORPH_KERNEL_MAX (MORPH_RADIUS_MAX * 2 + 1)
+#define MORPH_STAGES_MAX 4
+
+typedef enum morph_op
+{
+    MORPH_DILATE = 0,
+    MORPH_ERODE = 1,
+} morph_op_t;
+
+typedef struct morph_stage
+{
+    morph_op_t op;
+    uint8_t radius_x;
+    uint8_t radius_y;
+    uint16_t y_emit;                                   /* Next row this stage will output. */
+    uint16_t win_mid;                                  /* Rows of the window before this one are in 'win_front', the rest in 'win_back'. */
+    uint64_t cols_inner[MASK_WORDS];                   /* Columns further than 'radius_x' from the frame border. */
+    uint64_t rows_in[MORPH_KERNEL_MAX][MASK_WORDS];    /* Ring of the last input rows. */
+    uint64_t rows_horiz[MORPH_KERNEL_MAX][MASK_WORDS]; /* Ring of horizontal pass results. */
+    uint64_t win_front[MORPH_KERNEL_MAX][MASK_WORDS];  /* Suffix aggregates of the older part of the window. */
+    uint64_t win_back[MASK_WORDS];                     /* Aggregate of the newer part of the window. */
+    uint64_t row_out[MASK_WORDS];                      /* Output row passed to the next stage. */
+} morph_stage_t;
+
+typedef struct morph
+{
+    uint8_t stage_num;
+    morph_stage_t stages[MORPH_STAGES_MAX];
+    uint8_t (*dst)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH];
+    mask_t *dst_mask;
+    mask_t const *clip;   /* Output pixels outside this mask are cleared. NULL to keep all. */
+    uint16_t y_out_start; /* Rows in [y_out_start, y_out_end) get written to the destination. */
+    uint16_t y_out_end;
+    uint16_t y_in_start; /* Rows in [y_in_start, y_in_end) must be pushed in order. */
+    uint16_t y_in_end;
+    uint16_t y_in;   /* Next row expected by 'morph_push'. */
+    uint16_t y_done; /* All output rows above this one are final. */
+} morph_t;
+
+/**
+ * @brief Remove all stages and the clip mask.
+ * @param morph
+ */
+void morph_reset(morph_t *const morph);
+
+/**
+ * @brief Clear all output pixels outside a mask e.g. a region of interest. Removed by
+ * @c morph_reset .
+ * @param morph
+ * @param clip The mask which has to stay valid while the chain is used, or NULL to keep all pixels.
+ */
+void morph_clip(morph_t *const morph, mask_t const *const clip);
+
+/**
+ * @brief Append an operation to the chain.
+ * @param morph
+ * @param op Dilation or erosion.
+ * @param width Kernel width. Must be odd and at most @c MORPH_KERNEL_MAX .
+ * @param height Kernel height. Must be odd and at most @c MORPH_KERNEL_MAX .
+ * @return 0 on success and -1 on failure.
+ */
+int morph_add(morph_t *const morph, morph_op_t const op, uint8_t const width, uint8_t const height);
+
+/**
+ * @brief Append a closing (dilation followed by erosion) to the chain.
+ * @param morph
+ * @param width Kernel width. Must be odd and at most @c MORPH_KERNEL_MAX .
+ * @param height Kernel height. Must be odd and at most @c MORPH_KERNEL_MAX .
+ * @return 0 on success and -1 on failure.
+ */
+int morph_close(morph_t *const morph, uint8_t const width, uint8_t const height);
+
+/**
+ * @brief Append an opening (erosion followed by dilation) to the chain.
+ * @param morph
+ * @param width Kernel width. Must be odd and at most @c MORPH_KERNEL_MAX .
+ * @param height Kernel height. Must be odd and at most @c MORPH_KERNEL_MAX .
+ * @return 0 on success and -1 on failure.
+ */
+int morph_open(morph_t *const morph, uint8_t const width, uint8_t const height);
+
+/**
+ * @brief Get how many rows above and below an output band are needed to compute it.
+ * @param morph
+ * @return Sum of the vertical kernel radii of all stages.
+ */
+uint16_t morph_halo(morph_t const *const morph);
+
+/**
+ * @brief Start streaming rows through the chain. After this, rows from @c y_in_start up to
+ * @c y_in_end must be passed to @c morph_push in order. Output rows get written to @p dst as soon as
+ * they are final. Pixels within a kernel radius of the frame border are left unchanged.
+ * @param morph
+ * @param dst Where the output rows are written. Only rows in [ @p y_start , @p y_end ) are written.
+ * Can be NULL.
+ * @param dst_mask Where the output rows are written in packed form. Can be NULL.
+ * @param y_start First row of the output band.
+ * @param y_end Row after the last row of the output band.
+ */
+void morph_begin(morph_t *const morph,
+                 uint8_t (*const dst)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+                 mask_t *const dst_mask,
+                 uint16_t const y_start,
+                 uint16_t const y_end);
+
+/**
+ * @brief Push the next input row (with index @c y_in ) through the chain.
+ * @param morph
+ * @param row A segmented row.
+ */
+void morph_push(morph_t *const morph, uint8_t const *const row);
+
+/**
+ * @brief Run the chain over a band of a frame in a single sweep.
+ * @param morph
+ * @param src A segmented frame. Rows up to @c morph_halo outside the band get read.
+ * @param dst Where the output band is written. It may be the same frame as @p src . Can be NULL.
+ * @param dst_mask Where the output band is written in packed form. Can be NULL.
+ * @param y_start First row of the output band.
+ * @param y_end Row after the last row of the output band.
+ */
+void morph_run(morph_t *const morph,
+               uint8_t (*const src)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+               uint8_t (*const dst)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+               mask_t *const dst_mask,
+               uint16_t const y_start,
+               uint16_t const y_end);
+
+#endif /* _MORPH_H_ */
@@ -14,6 +14,7 @@
 #include "pipeline.h"
 #include "pipeline_mgr.h"
 #include "draw.h"
+#include "pool.h"
 
 /* A user defined function which receives pointer to frame data and does anything it wants with it.
 */
@@ -443,9 +444,10 @@ static int run_pl_camera()
  * @param proc_func_args Pointer to arguments which will be passed to proc_fucn when it is called.
  * @param user_deinit User defined deinit function that will be run before closing.
  * @param win_debug If a debug window showing the processed frames should be shown.
+ * @param worker_num Number of workers in the pool @p proc_func can split its work across.
  * @return 0 on success and 1 on failure
  */
-static int run_pl_proc(void (*const proc_func)(uint8_t (*const)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], int const, void *const), void *const proc_func_args, int (*const user_deinit)(void), uint8_t const win_debug)
+static int run_pl_proc(void (*const proc_func)(uint8_t (*const)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], int const, void *const), void *const proc_func_args, int (*const user_deinit)(void), uint8_t const win_debug, uint8_t const worker_num)
 {
     register_signal_handler();
 
@@ -479,6 +481,14 @@ static int run_pl_proc(void (*const proc_func)(uint8_t (*const)[TCO_FRAME_HEIGHT
         }
     }
 
+    /* The pool threads are never cancelled. They park on a barrier between frames and end with the
+    process. */
+    if (pool_init(worker_num) != 0)
+    {
+        log_error("Failed to start the worker pool");
+        return EXIT_FAILURE;
+    }
+
     compute_user_data.f = proc_func;
     compute_user_data.args = proc_func_args;
     if (pthread_create(&thread_proc, NULL, &thread_job_proc_pipeline, &compute_user_data) != 0)
@@ -491,7 +501,7 @@ static int run_pl_proc(void (*const proc_func)(uint8_t (*const)[TCO_FRAME_HEIGHT
     return EXIT_SUCCESS;
 }
 
-int pl_mgr_run(uint8_t const win_debug, uint8_t const cam_or_proc, void (*const proc_func)(uint8_t (*const)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], int const, void *const), void *const proc_func_args, int (*const user_deinit)(void))
+int pl_mgr_run(uint8_t const win_debug, uint8_t const cam_or_proc, void (*const proc_func)(uint8_t (*const)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], int const, void *const), void *const proc_func_args, int (*const user_deinit)(void), uint8_t const worker_num)
 {
     if (cam_or_proc)
     {
@@ -499,6 +509,6 @@ int pl_mgr_run(uint8_t const win_debug, uint8_t const cam_or_proc, void (*const
     }
     else
     {
-        return run_pl_proc(proc_func, proc_func_args, user_deinit, win_debug);
+        return run_pl_proc(proc_func, proc_func_args, user_deinit, win_debug, worker_num);
     }
 }
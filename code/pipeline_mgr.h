@@ -13,8 +13,11 @@
  * @param proc_func A function which will process a frame and use its data in any way it wants.
  * @param proc_func_args Pointer to arguments which will be passed to proc_fucn when it is called.
  * @param user_deinit Pointer to a function which gets run when daemon exit is requested.
+ * @param worker_num Number of workers (including the processing thread) in the worker pool which
+ * @p proc_func can split its work across. If 0, one worker per online core is used. Only used when
+ * @p cam_or_proc is set to 0.
  * @return 0 on success, 1 on failure
  */
-int pl_mgr_run(uint8_t const win_debug, uint8_t const cam_or_proc, void (*const proc_func)(uint8_t (*const)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], int const, void *const), void *const proc_func_args, int (*const user_deinit)(void));
+int pl_mgr_run(uint8_t const win_debug, uint8_t const cam_or_proc, void (*const proc_func)(uint8_t (*const)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], int const, void *const), void *const proc_func_args, int (*const user_deinit)(void), uint8_t const worker_num);
 
 #endif /* _PIPELINE_MGR_H_ */
\ No newline at end of file
@@ -14,7 +14,16 @@
 #include "draw.h"
 #include "sort.h"
 #include "misc.h"
-#include "buf_circ.h"
+#include "pre_proc.h"
+#include "pyramid.h"
+#include "ipm.h"
+#include "ray_tmpl.h"
+#include "subpix.h"
+#include "tracker.h"
+#include "contour.h"
+#include "edge_scan.h"
+#include "hough.h"
+#include "timing.h"
 
 static struct tco_shmem_data_state *shmem_state;
 static sem_t *shmem_sem_state;
@@ -23,49 +32,71 @@ static sem_t *shmem_sem_plan;
 static uint8_t shmem_state_open = 0;
 static uint8_t shmem_plan_open = 0;
 
-static uint16_t const track_width = 300; /* Pixels */
-
-/* Generated with "tco_circle_vector_gen" for a radius 6 circle. */
-/* Up -> Q1 -> Right -> Q4 -> Down -> Q3 -> Left -> Q2 -> (wrap-around to Up) */
-static vec2_t const circ_data[] = {
-    {0, -6},
-    {1, -6},
-    {2, -6},
-    {3, -5},
-    {4, -5},
-    {5, -4},
-    {5, -3},
-    {6, -2},
-    {6, -1},
-    {6, 0},
+#define PLNR_STAT_FRAMES 300 /* Timings are reported after this many frames. */
+
+static timing_stat_t stat_plan = {.name = "planner"};
+static timing_stat_t stat_fan = {.name = "planner ray fan"};
+static timing_stat_t stat_track = {.name = "planner tracker"};
+static timing_stat_t stat_edges = {.name = "planner edges"};
+
+static ipm_t ipm;
+static uint8_t ipm_loaded = 0;
+
+static uint16_t track_width = 300; /* Pixels, of the bird's-eye view when planning on it. */
+
+vec2_t const plnr_fan_dirs[] = {
+    {2, -1},
+    {3, -1},
+    {1, 0},
     {6, 1},
-    {6, 2},
-    {5, 3},
-    {5, 4},
-    {4, 5},
-    {3, 5},
-    {2, 6},
-    {1, 6},
-    {0, 6},
-    {-1, 6},
-    {-2, 6},
-    {-3, 5},
-    {-4, 5},
-    {-5, 4},
-    {-5, 3},
-    {-6, 2},
+    {5, -1},
+    {12, 1},
+    {-2, -1},
+    {-3, -1},
+    {-1, 0},
     {-6, 1},
-    {-6, 0},
-    {-6, -1},
-    {-6, -2},
-    {-5, -3},
-    {-5, -4},
-    {-4, -5},
-    {-3, -5},
-    {-2, -6},
-    {-1, -6},
+    {-5, -1},
+    {-12, 1},
 };
-static const uint16_t circ_data_len = sizeof(circ_data) / sizeof(vec2_t);
+_Static_assert(sizeof(plnr_fan_dirs) / sizeof(plnr_fan_dirs[0]) == PLNR_FAN_DIR_NUM, "The fan must hold PLNR_FAN_DIR_NUM rays");
+static uint8_t const fan_dir_num = PLNR_FAN_DIR_NUM;
+static vec2_t const straight_dir = {0, -1};
+static ray_tmpl_t tmpl_fan[PLNR_FAN_DIR_NUM]; /* Built from the directions above by 'plnr_init'. */
+static ray_tmpl_t tmpl_straight;
+static point2_t const origin_frame = {TCO_FRAME_WIDTH / 2, 200}; /* Close origin on the frame, where the tracker and the Hough detector work. */
+static point2_t origin_car; /* Where the car is, 'origin_frame' seen on the view rays are cast on. Rays start here unless the track center is tracked. */
+static uint8_t const origin_far_rise = 3; /* The far origin lies this fraction of the straight ray above the close one. */
+
+/* Edges of the track followed on rows from the close origin up. When enabled, the center of the
+track between them on the first row is where the rays and the searches for edges start. */
+#define PLNR_TRACK_ROWS 8
+#define PLNR_TRACK_ROW_SPACING 20
+static tracker_t tracker;
+static uint8_t track_enabled = 0;
+
+/* Borders of the track are traced this many pixels between the points 'segment_track' finds. */
+#define PLNR_CONTOUR_SPACING 48
+#define PLNR_CONTOUR_POINTS 4
+#define PLNR_CONTOUR_NORMAL_SCALE 8 /* Normals to the borders get this many times shorter than the border between points. */
+static contour_t contours[2]; /* Left and right border of the track. */
+
+/* Borders of the track found as lines by a detector of their own, to compare detectors. */
+#define PLNR_HOUGH_ROWS 160 /* Rows from the close origin up which vote for lines. */
+static plnr_edges_t edges_mode = PLNR_EDGES_NONE;
+static hough_t hough;
+static uint16_t edges_found_num = 0; /* Frames since the last report where both borders were found. */
+static lane_model_t lanes[2];             /* Left and right border of the last frame as lanes, when scanned for. */
+static uint8_t lanes_valid[2] = {0, 0};
+
+/* Rays of a free-space profile cast from the far origin instead of the fan, when enabled. They are
+spread evenly over the fan's directions, from just below the horizontal on the left over straight up
+to just below it on the right. */
+#define PLNR_POLAR_BELOW (5.0f * (float)M_PI / 180.0f) /* Radians the outermost rays point below the horizontal. */
+#define PLNR_POLAR_TMPL_SCALE 64 /* Directions of the profile's templates are this long. */
+static ray_tmpl_t *tmpl_polar = NULL; /* One per ray, allocated by 'plnr_polar_set' since there can be hundreds. */
+static uint16_t polar_num = 0;        /* Rays of the profile, 0 when the fan is cast instead. */
+static float polar_sideways[PLNR_POLAR_RAYS_MAX]; /* Pixels every step of a template moves rightwards. */
+static float polar_weight = 0.0f;                 /* Sum of how far every ray points sideways, see 'plan_profile'. */
 
 /**
  * @brief Given a list of uint16_t values, finds the median and returns it.
@@ -94,62 +125,30 @@ static uint16_t listu16_median(uint16_t *const list, uint16_t const length)
 
 /**
  * @brief Find an edge of the track.
- * @param pixels A segmented frame where to search.
+ * @param rle Runs of the segmented frame where to search.
  * @param center_black Where to start searching. This must be the track center and must lie on top
  * of a black pixel.
  * @param left_or_right If 1 then left edge is returned, if 0 then right edge is returned.
- * @return Edge of the track.
- */
-static point2_t track_edge(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t const center, uint8_t const left_or_right)
-{
-    int8_t search_delta = left_or_right ? -1 : 1;
-    uint16_t edge_x = center.x;
-    while (edge_x > 0 && edge_x < TCO_FRAME_WIDTH)
-    {
-        if ((*pixels)[center.y][edge_x] == 255 || abs(center.x - edge_x) > (track_width / 2))
-        {
-            break;
-        }
-        edge_x += search_delta;
-    }
-    return (point2_t){edge_x, center.y};
-}
-
-/**
- * @brief Given a vector, this function determines the sweep start fraction based on the angle by
- * finding where the vector intersects with a unit circle then finding the fraction of perimeter
- * from the 0 point (up) where that intersection lies. 
- * @note It boils down to converting from a range of arctan ((0 deg) 0-Pi (180 deg) -Pi-0 (0 deg))
- * to a range of 0-1 i.e. 90 deg at 0 to wrapping around to 90 deg at 1.
- * @param vec
- * @return Sweep start fraction.
+ * @return Edge of the track. It is at most half the track width and one pixel from the center.
  */
-static float vec_to_sweep_start(vec2_t const vec)
+static point2_t track_edge(rle_t const *const rle, point2_t const center, uint8_t const left_or_right)
 {
-    float vec_inv_len;
-    vec2_inv_length(&vec, &vec_inv_len);
-    float sweep_start = (atan2f(vec.y * vec_inv_len, vec.x * vec_inv_len) / M_PI);
-
-    if (isnan(sweep_start))
-    {
-        sweep_start = 0.0f;
-    }
-
-    /* Converts the 0-Pi -Pi-0 range to 0-1 as required by radial sweep. */
-    if (sweep_start >= 0) /* 0 to Pi */
+    int16_t edge_x;
+    if (left_or_right)
     {
-        sweep_start = 0.25 + (sweep_start * 0.5f);
+        int16_t const edge_x_max = center.x - track_width / 2 - 1;
+        edge_x = rle_next_left(rle, center.y, center.x);
+        edge_x = edge_x > edge_x_max ? edge_x : edge_x_max;
+        edge_x = edge_x > 0 ? edge_x : 0;
     }
-    else if (sweep_start <= -0.5f) /* -Pi/2 to -Pi */
-    {
-        sweep_start = 0.75f + (0.25f * (1.0f - ((-sweep_start - 0.5f) * 2.0f)));
-    }
-    else /* 0 to -Pi/2 */
+    else
     {
-        sweep_start = 0.25f * (1.0f - (-sweep_start * 2.0f));
+        int16_t const edge_x_max = center.x + track_width / 2 + 1;
+        edge_x = rle_next_right(rle, center.y, center.x);
+        edge_x = edge_x < edge_x_max ? edge_x : edge_x_max;
+        edge_x = edge_x < TCO_FRAME_WIDTH ? edge_x : TCO_FRAME_WIDTH;
     }
-
-    return sweep_start;
+    return (point2_t){edge_x, center.y};
 }
 
 /**
@@ -160,7 +159,13 @@ static float vec_to_sweep_start(vec2_t const vec)
  */
 static point2_t track_line_midpoint(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], line2_t const line)
 {
-    uint16_t ray_len = raycast(pixels, (point2_t){line.orig.x + line.dir.x, line.orig.y + line.dir.y}, line.dir, &cb_draw_no_stop_white);
+    point2_t const start = {line.orig.x + line.dir.x, line.orig.y + line.dir.y};
+    dist_map_t const *const dist_map = pre_proc_dist_map();
+    dist_dir_t const dist_dir = dist_dir_from_vec(line.dir);
+    pyramid_t const *const pyramid = pre_proc_pyramid();
+    uint16_t ray_len = dist_map != NULL && dist_dir != DIST_DIR_NUM
+                           ? dist_map_ray(dist_map, dist_dir, start)
+                           : pyramid_raycast_refine(pyramid, pyramid->level_num, pixels, pre_proc_roi(), start, line.dir, &raycast_draw_no_stop_white);
     if (ray_len > track_width / 2)
     {
         ray_len = track_width / 2;
@@ -171,82 +176,63 @@ static point2_t track_line_midpoint(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TC
     return (point2_t){line.orig.x + hit_vec.x, line.orig.y + hit_vec.y};
 }
 
+/**
+ * @brief Trace the left and right borders of the track up from its center and mark the midpoints
+ * of the track along them. Where only one border could be followed, the midpoint is found across
+ * the track from it.
+ * @param pixels A segmented frame.
+ * @param center_black Center of the track on a black pixel.
+ */
 static void segment_track(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t const center_black)
 {
-    float const sweep_start_offset = 0.1f;
-    point2_t edge[2] = {track_edge(pixels, center_black, 1), track_edge(pixels, center_black, 0)};
-    float edge_sweep_start[2] = {0.25f, 0.75f};
+    point2_t edge[2] = {track_edge(pre_proc_rle(), center_black, 1), track_edge(pre_proc_rle(), center_black, 0)};
+    /* The left border is walked up with the line on the left, the right one with it on the right.
+    The track lies on the other side so the first sweeps start there. */
+    contour_trace(&contours[0], pixels, edge[0], CONTOUR_DIR_RIGHT, 0, PLNR_CONTOUR_POINTS * PLNR_CONTOUR_SPACING);
+    contour_trace(&contours[1], pixels, edge[1], CONTOUR_DIR_LEFT, 1, PLNR_CONTOUR_POINTS * PLNR_CONTOUR_SPACING);
     uint8_t edge_stop[2] = {0, 0};
-    uint8_t edge_diverged[2] = {0, 0};
+    vec2_t edge_normal[2] = {{0, 0}, {0, 0}};
 
-    uint8_t const pt_num = 4;
-    for (uint16_t pt_i = 0; pt_i < pt_num; pt_i++)
+    for (uint16_t pt_i = 0; pt_i < PLNR_CONTOUR_POINTS; pt_i++)
     {
-        uint8_t sweep_status;
+        uint16_t const step_start = pt_i * PLNR_CONTOUR_SPACING;
+        uint16_t const step_end = step_start + PLNR_CONTOUR_SPACING;
         /* Repeat the same for left and right. */
         for (uint8_t edge_idx = 0; edge_idx < 2; edge_idx++)
         {
-            if (!edge_stop[edge_idx] && !edge_diverged[edge_idx])
+            if (edge_stop[edge_idx])
             {
-                point2_t const edge_last = edge[edge_idx];
-                if (edge_idx == 0)
-                {
-                    edge[0] = radial_sweep(pixels, (vec2_t *)&circ_data, circ_data_len, edge[0], 8, 0, edge_sweep_start[0], 1.0f, &sweep_status);
-                }
-                else
-                {
-                    edge[1] = radial_sweep(pixels, (vec2_t *)&circ_data, circ_data_len, edge[1], 8, 1, edge_sweep_start[1], 1.0f, &sweep_status);
-                }
-                /* If something abnormal happened e.g. reached frame edge, etc... */
-                if (sweep_status != 0)
-                {
-                    edge_stop[edge_idx] = 1;
-                }
-                else if (abs(edge[edge_idx].x - center_black.x) > track_width * 0.7f)
-                {
-                    edge_diverged[edge_idx] = 1;
-                }
-
-                /* Using vector between old and new edge point, find the ideal sweep start fraction
-                for radial sweep. */
-                if (edge_idx == 0)
-                {
-                    vec2_t const edge_sweep_start_vec = {-(edge[0].y - edge_last.y), edge[0].x - edge_last.x}; /* Normal to delta vector. */
-                    edge_sweep_start[0] = vec_to_sweep_start(edge_sweep_start_vec);
-                    edge_sweep_start[0] -= sweep_start_offset;
-                    if (edge_sweep_start[0] < 0.0f)
-                    {
-                        edge_sweep_start[0] = 0.0f;
-                    }
-                }
-                else
-                {
-                    vec2_t const edge_sweep_start_vec = {edge[1].y - edge_last.y, -(edge[1].x - edge_last.x)}; /* Normal to delta vector. */
-                    edge_sweep_start[1] = vec_to_sweep_start(edge_sweep_start_vec);
-                    edge_sweep_start[1] += sweep_start_offset;
-                    if (edge_sweep_start[1] > 1.0f)
-                    {
-                        edge_sweep_start[1] = 1.0f;
-                    }
-                }
+                continue;
+            }
+            contour_t const *const contour = &contours[edge_idx];
+            point2_t const edge_last = edge[edge_idx];
+            /* A border which ended early or strayed too far from the center is not followed further. */
+            edge_stop[edge_idx] = contour->length < step_end;
+            edge[edge_idx] = contour_walk(contour, edge_last, step_start, step_end < contour->length ? step_end : contour->length);
+            if (abs(edge[edge_idx].x - center_black.x) > track_width * 0.7f)
+            {
+                edge_stop[edge_idx] = 1;
+            }
+            /* Normal to the border, pointing into the track, scaled down to a few pixels since
+            rays across the track begin one normal away from the border. */
+            int16_t const dx = (edge[edge_idx].x - edge_last.x) / PLNR_CONTOUR_NORMAL_SCALE;
+            int16_t const dy = (edge[edge_idx].y - edge_last.y) / PLNR_CONTOUR_NORMAL_SCALE;
+            edge_normal[edge_idx] = edge_idx == 0 ? (vec2_t){-dy, dx} : (vec2_t){dy, -dx};
+            if (dx == 0 && dy == 0)
+            {
+                edge_normal[edge_idx] = (vec2_t){edge_idx == 0 ? 1 : -1, 0};
             }
         }
         if (!edge_stop[1] || !edge_stop[0])
         {
-            /* The sweep start dir vector can be used directly since its length is known to be the
-            circle radius which is negligible and does not need to be normalized to 1. */
             point2_t midpoint;
             if (!edge_stop[0] && edge_stop[1])
             {
-                float const sweep_start = edge_sweep_start[0] + sweep_start_offset > 1.0f ? 1.0f : edge_sweep_start[0] + sweep_start_offset;
-                vec2_t const sweep_start_dir = circ_data[(uint16_t)((circ_data_len - 1) * sweep_start)];
-                midpoint = track_line_midpoint(pixels, (line2_t){edge[0], sweep_start_dir});
+                midpoint = track_line_midpoint(pixels, (line2_t){edge[0], edge_normal[0]});
             }
             else if (edge_stop[0] && !edge_stop[1])
             {
-                float const sweep_start = edge_sweep_start[1] - sweep_start_offset < 0.0f ? 0.0f : edge_sweep_start[1] - sweep_start_offset;
-                vec2_t const sweep_start_dir = circ_data[(uint16_t)((circ_data_len - 1) * sweep_start)];
-                midpoint = track_line_midpoint(pixels, (line2_t){edge[1], sweep_start_dir});
+                midpoint = track_line_midpoint(pixels, (line2_t){edge[1], edge_normal[1]});
             }
             else
             {
@@ -261,8 +247,176 @@ static void segment_track(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WI
     }
 }
 
-int plnr_init()
+/**
+ * @brief Cast a ray which draws the pixels it passes and stops at white. The ray is found on the
+ * coarsest level of the pyramid @c pre_proc built first and only refined on the full frame.
+ * @param pixels A segmented frame.
+ * @param start Where the raycast will begin.
+ * @param dir In what direction the ray will be cast.
+ * @return Length of the ray.
+ */
+static uint16_t plan_raycast(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t const start, vec2_t const dir)
+{
+    pyramid_t const *const pyramid = pre_proc_pyramid();
+    return pyramid_raycast_refine(pyramid, pyramid->level_num, pixels, pre_proc_roi(), start, dir, &raycast_draw_light_stop_white);
+}
+
+/**
+ * @brief Cast a ray along its template, which draws the pixels it passes and stops at white. Rays
+ * in compass directions are read from the distance map when @c pre_proc built one. Otherwise
+ * horizontal rays are found in the runs of their row. Otherwise, when @c pre_proc built a pyramid,
+ * the ray is found coarse to fine by @c plan_raycast . Otherwise, when @c pre_proc built a block
+ * map, the ray jumps over empty blocks. With a bird's-eye view the template is looked up in its
+ * lookup table instead and nothing gets drawn.
+ * @param pixels A segmented frame.
+ * @param tmpl
+ * @param origin Where the ray begins, on the bird's-eye view when there is one.
+ * @return Length of the ray.
+ */
+static uint16_t plan_ray(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], ray_tmpl_t const *const tmpl, point2_t const origin)
+{
+    if (ipm_loaded)
+    {
+        return ipm_ray_cast(&ipm, tmpl, pixels, origin);
+    }
+    dist_map_t const *const dist_map = pre_proc_dist_map();
+    dist_dir_t const dist_dir = dist_dir_from_vec(tmpl->dir);
+    uint8_t const dist_mapped = dist_map != NULL && dist_dir != DIST_DIR_NUM;
+    if (!dist_mapped && tmpl->dir.y != 0 && pre_proc_pyramid()->level_num > 0)
+    {
+        return plan_raycast(pixels, origin, tmpl->dir);
+    }
+    block_map_t const *const block_map = pre_proc_block_map();
+    uint16_t ray_len;
+    if (dist_mapped)
+    {
+        ray_len = dist_map_ray(dist_map, dist_dir, origin);
+    }
+    else if (tmpl->dir.y == 0)
+    {
+        ray_len = rle_raycast_row(pre_proc_rle(), pre_proc_roi(), origin, tmpl->dir.x < 0);
+    }
+    else if (block_map != NULL)
+    {
+        ray_len = ray_tmpl_cast_blocks(tmpl, pixels, pre_proc_roi(), block_map, origin);
+    }
+    else
+    {
+        ray_len = ray_tmpl_cast(tmpl, pixels, pre_proc_roi(), origin);
+    }
+    if (draw_enabled)
+    {
+        for (uint16_t step = 0; step < ray_len; step++)
+        {
+            draw_q_pixel((point2_t){origin.x + tmpl->x[step], origin.y + tmpl->y[step]}, 120);
+        }
+    }
+    return ray_len;
+}
+
+/**
+ * @brief Find the borders of the track with the Hough transform. Of the most voted for lines, the
+ * first to cross the row of the close origin left of the track center is the left border and the
+ * first to cross it right of it is the right border.
+ * @param rle Runs of the segmented frame.
+ * @param center Center of the track on the close origin's row of the frame.
+ * @param lines Where the left and right border are written, from the close origin's row up.
+ */
+static void plan_edges_hough(rle_t const *const rle, point2_t const center, line_t lines[2])
+{
+    uint16_t const y_top = origin_frame.y > PLNR_HOUGH_ROWS ? origin_frame.y - PLNR_HOUGH_ROWS : 0;
+    hough_step(&hough, rle, y_top, origin_frame.y + 1, center.x);
+    memset(lines, 0, 2 * sizeof(line_t));
+    for (uint8_t line_idx = 0; line_idx < hough.line_num; line_idx++)
+    {
+        hough_line_t const *const line = &hough.lines[line_idx];
+        int16_t const bot_x = hough_line_x(&hough, line, origin_frame.y);
+        line_t *const edge = &lines[bot_x < center.x ? 0 : 1];
+        if (edge->valid)
+        {
+            continue;
+        }
+        int16_t const top_x = hough_line_x(&hough, line, y_top);
+        edge->bot = (point2_t){bot_x < 0 ? 0 : bot_x < TCO_FRAME_WIDTH ? bot_x : TCO_FRAME_WIDTH - 1, origin_frame.y};
+        edge->top = (point2_t){top_x < 0 ? 0 : top_x < TCO_FRAME_WIDTH ? top_x : TCO_FRAME_WIDTH - 1, y_top};
+        edge->valid = 1;
+        if (draw_enabled)
+        {
+            for (int16_t y = y_top; y <= origin_frame.y; y += 4)
+            {
+                int16_t const x = hough_line_x(&hough, line, y);
+                if (x >= 0 && x < TCO_FRAME_WIDTH)
+                {
+                    draw_q_pixel((point2_t){x, y}, 200);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Get the center of the track on the close origin's row of the frame.
+ * @return The tracked center when tracking found both edges of the row, the close origin otherwise.
+ */
+static point2_t plan_center(void)
+{
+    if (track_enabled && tracker.left[0].valid && tracker.right[0].valid)
+    {
+        return tracker_center(&tracker, 0);
+    }
+    return origin_frame;
+}
+
+/**
+ * @brief Cast the rays of the free-space profile from the far origin along their templates and sum
+ * their sideways parts, rightwards positive, scaled as if summed over the fan's rays so it replaces
+ * their sum.
+ * @param pixels A segmented frame.
+ * @param origin_far Where the rays begin, on the bird's-eye view when there is one.
+ * @return Sum in pixels.
+ */
+static float plan_profile(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t const origin_far)
+{
+    float sideways = 0.0f;
+    for (uint16_t ray_idx = 0; ray_idx < polar_num; ray_idx++)
+    {
+        sideways += plan_ray(pixels, &tmpl_polar[ray_idx], origin_far) * polar_sideways[ray_idx];
+    }
+    return sideways / polar_weight * fan_dir_num;
+}
+
+int plnr_init(char const *const ipm_path)
 {
+    for (uint8_t dir_idx = 0; dir_idx < fan_dir_num; dir_idx++)
+    {
+        ray_tmpl_build(&tmpl_fan[dir_idx], plnr_fan_dirs[dir_idx]);
+    }
+    ray_tmpl_build(&tmpl_straight, straight_dir);
+    uint16_t track_rows[PLNR_TRACK_ROWS];
+    for (uint8_t row_idx = 0; row_idx < PLNR_TRACK_ROWS; row_idx++)
+    {
+        track_rows[row_idx] = origin_frame.y - row_idx * PLNR_TRACK_ROW_SPACING;
+    }
+    tracker_init(&tracker, track_rows, PLNR_TRACK_ROWS);
+    hough_init(&hough);
+    origin_car = origin_frame;
+    if (ipm_path != NULL)
+    {
+        if (ipm_load(&ipm, ipm_path) != 0)
+        {
+            log_error("Failed to load the inverse perspective mapping");
+            return EXIT_FAILURE;
+        }
+        if (ipm_to_bird(&ipm, origin_frame, &origin_car) != EXIT_SUCCESS)
+        {
+            log_error("Close origin (%d, %d) is not seen in the bird's-eye view", origin_frame.x, origin_frame.y);
+            return EXIT_FAILURE;
+        }
+        ipm_loaded = 1;
+        track_width = lrintf(ipm.track_width_mm / ipm.mm_per_pixel); /* 'ipm_load' checked it fits. */
+        log_info("Planning on the bird's-eye view where the track is %u pixels wide and the close origin is (%d, %d)",
+                 track_width, origin_car.x, origin_car.y);
+    }
     if (shmem_map(TCO_SHMEM_NAME_STATE, TCO_SHMEM_SIZE_STATE, TCO_SHMEM_NAME_SEM_STATE, O_RDONLY, (void **)&shmem_state, &shmem_sem_state) != 0)
     {
         log_error("Failed to map state shmem into process memory");
@@ -279,41 +433,57 @@ int plnr_init()
 /**
  * @brief Calculate the best position to be in according to the current *segmented* frame
  * @param pixels is passed as a ptr
+ * @param center is the center of the track on the close origin's row of the frame, which the rays
+ * are cast from. How far it lies from the close origin, which is where the car is, is added to
+ * @p target_pos so it is 1 at the edge of the track.
  * @param target_pos is the desired position (-1 left edge, 1 right edge, 0 center) of current frame
  * @param target_speed is the speed to go at (m/s). NOTE This unit can easily be changed
  * @return void. values are passed through @p target_pos and @p target_speed pointers. 
  */
-void calculate_next_position( uint8_t (* pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], float *target_pos, float *target_speed) {
+void calculate_next_position( uint8_t (* pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t const center, float *target_pos, float *target_speed) {
     *target_pos = 0.0f; 
     *target_speed = 0.0f;
+    point2_t origin_close = center;
+    if (ipm_loaded && ipm_to_bird(&ipm, center, &origin_close) != EXIT_SUCCESS)
+    {
+        origin_close = origin_car;
+    }
 
-    point2_t const center_track = (point2_t){TCO_FRAME_WIDTH/2, 210}; //track_center(pixels, 200);
-    const point2_t start_close = {center_track.x, 200};
-
-    uint16_t straight = raycast(pixels, start_close, (vec2_t){0,-1}, &cb_draw_light_stop_white);
-    const point2_t start_far = {center_track.x, 200 - (straight/3)};
-    uint16_t rays_left[6], rays_right[6];
-
-    /* TODO: Make function */
-    rays_left[0] = raycast(pixels, start_far, (vec2_t){2,-1}, &cb_draw_light_stop_white);
-    rays_left[1] = raycast(pixels, start_far, (vec2_t){3,-1}, &cb_draw_light_stop_white);
-    rays_left[2] = raycast(pixels, start_far, (vec2_t){1, 0}, &cb_draw_light_stop_white);
-    rays_left[3] = raycast(pixels, start_far, (vec2_t){6, 1}, &cb_draw_light_stop_white);
-    rays_left[4] = raycast(pixels, start_far, (vec2_t){5, -1}, &cb_draw_light_stop_white);
-    rays_left[5] = raycast(pixels, start_far, (vec2_t){12, 1}, &cb_draw_light_stop_white);
-
-    rays_right[0] = raycast(pixels, start_far, (vec2_t){-2,-1}, &cb_draw_light_stop_white);
-    rays_right[1] = raycast(pixels, start_far, (vec2_t){-3,-1}, &cb_draw_light_stop_white);
-    rays_right[2] = raycast(pixels, start_far, (vec2_t){-1, 0}, &cb_draw_light_stop_white);
-    rays_right[3] = raycast(pixels, start_far, (vec2_t){-6, 1}, &cb_draw_light_stop_white);
-    rays_right[4] = raycast(pixels, start_far, (vec2_t){-5, -1}, &cb_draw_light_stop_white);
-    rays_right[5] = raycast(pixels, start_far, (vec2_t){-12, 1}, &cb_draw_light_stop_white);
-
-    /* TODO: Make summation function */
-    *target_pos = (rays_left[0] + rays_left[1] + rays_left[2] + rays_left[3] + rays_left[4] + rays_left[5]) - (rays_right[0] + rays_right[1] + rays_right[2] + rays_right[3] + rays_right[4] + rays_right[5]);
-    *target_pos /= 400; /* Normalize the sums */
-
-    *target_speed = (straight) / 250.0f; /* Speed is determined by distance to edge of track */
+    uint16_t straight = plan_ray(pixels, &tmpl_straight, origin_close);
+    const point2_t origin_far = {origin_close.x, origin_close.y - (straight / origin_far_rise)};
+    uint16_t rays[PLNR_FAN_DIR_NUM];
+
+    /* Lengths are in 1 / SUBPIX_ONE pixels. They are refined on the grayscale frame when there is
+    one, which there is not for the bird's-eye view. */
+    uint8_t (*const gray)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH] = ipm_loaded ? NULL : pre_proc_gray();
+    int32_t const straight_fine = gray != NULL ? subpix_ray(&tmpl_straight, pixels, pre_proc_roi(), gray, origin_close, straight) : (int32_t)straight << SUBPIX_SHIFT;
+
+    uint64_t const fan_start = timing_now_ns();
+    if (polar_num > 0)
+    {
+        *target_pos = plan_profile(pixels, origin_far);
+        timing_stat_add(&stat_fan, timing_now_ns() - fan_start);
+    }
+    else
+    {
+        for (uint8_t dir_idx = 0; dir_idx < fan_dir_num; dir_idx++)
+        {
+            rays[dir_idx] = plan_ray(pixels, &tmpl_fan[dir_idx], origin_far);
+        }
+        timing_stat_add(&stat_fan, timing_now_ns() - fan_start);
+
+        int32_t ray_sum = 0;
+        for (uint8_t dir_idx = 0; dir_idx < fan_dir_num; dir_idx++)
+        {
+            int32_t const ray = gray != NULL ? subpix_ray(&tmpl_fan[dir_idx], pixels, pre_proc_roi(), gray, origin_far, rays[dir_idx]) : (int32_t)rays[dir_idx] << SUBPIX_SHIFT;
+            ray_sum += dir_idx < fan_dir_num / 2 ? ray : -ray;
+        }
+        *target_pos = ray_sum / (float)SUBPIX_ONE;
+    }
+    *target_pos /= track_width * 4 / 3.0f; /* Normalize the sums */
+    *target_pos += (origin_close.x - origin_car.x) / (track_width / 2.0f);
+
+    *target_speed = (straight_fine / (float)SUBPIX_ONE) / (track_width * 5 / 6.0f); /* Speed is determined by distance to edge of track */
 }
 
 
@@ -321,7 +491,80 @@ int plnr_step(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
 {
     /* Calculate the next coordinate */
     float target_pos = 0, target_speed = 0;
-    calculate_next_position(pixels, &target_pos, &target_speed);
+    if (track_enabled)
+    {
+        uint64_t const track_start = timing_now_ns();
+        tracker_step(&tracker, pre_proc_rle());
+        timing_stat_add(&stat_track, timing_now_ns() - track_start);
+        if (draw_enabled)
+        {
+            for (uint8_t row_idx = 0; row_idx < tracker.row_num; row_idx++)
+            {
+                draw_q_square(tracker_center(&tracker, row_idx), 4, 200);
+            }
+        }
+    }
+    point2_t const center = plan_center();
+    pre_proc_center_set(center.x);
+    uint64_t const start = timing_now_ns();
+    calculate_next_position(pixels, center, &target_pos, &target_speed);
+    timing_stat_add(&stat_plan, timing_now_ns() - start);
+    if (edges_mode != PLNR_EDGES_NONE)
+    {
+        line_t lines[2];
+        uint64_t const edges_start = timing_now_ns();
+        if (edges_mode == PLNR_EDGES_SCAN)
+        {
+            edge_plot(pixels, pre_proc_rle(), center.x, lines, lanes);
+        }
+        else
+        {
+            plan_edges_hough(pre_proc_rle(), center, lines);
+        }
+        timing_stat_add(&stat_edges, timing_now_ns() - edges_start);
+        edges_found_num += lines[0].valid && lines[1].valid;
+        for (uint8_t side = 0; side < 2; side++)
+        {
+            lanes_valid[side] = edges_mode == PLNR_EDGES_SCAN && lines[side].valid;
+        }
+    }
+    if (stat_plan.sample_num >= PLNR_STAT_FRAMES)
+    {
+        uint8_t const level_num = pre_proc_pyramid()->level_num;
+        char note[48];
+        snprintf(note, sizeof(note), level_num > 0 ? "rays found on the %ux level first" : "rays traced on the full frame",
+                 1 << level_num);
+        timing_stat_report(&stat_plan, note);
+    }
+    if (stat_fan.sample_num >= PLNR_STAT_FRAMES)
+    {
+        char note[32];
+        snprintf(note, sizeof(note), polar_num > 0 ? "%u rays of the profile" : "%u rays", polar_num > 0 ? polar_num : fan_dir_num);
+        timing_stat_report(&stat_fan, note);
+    }
+    if (stat_edges.sample_num >= PLNR_STAT_FRAMES)
+    {
+        char note[160];
+        int note_len = snprintf(note, sizeof(note), "both borders found in %u frames", edges_found_num);
+        for (uint8_t side = 0; side < 2 && note_len > 0 && (size_t)note_len < sizeof(note); side++)
+        {
+            if (lanes_valid[side])
+            {
+                note_len += snprintf(&note[note_len], sizeof(note) - note_len, ", %s heading %.3f rad curvature %.5f / px",
+                                     side == 0 ? "left" : "right", lanes[side].heading, lanes[side].curvature);
+            }
+        }
+        timing_stat_report(&stat_edges, note);
+        edges_found_num = 0;
+    }
+    if (stat_track.sample_num >= PLNR_STAT_FRAMES)
+    {
+        char note[64];
+        snprintf(note, sizeof(note), "%u edges found in their window, %u scanned for", tracker.window_num, tracker.scan_num);
+        timing_stat_report(&stat_track, note);
+        tracker.window_num = 0;
+        tracker.scan_num = 0;
+    }
 
     if (sem_wait(shmem_sem_plan) == -1)
     {
@@ -343,8 +586,79 @@ int plnr_step(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
     return EXIT_SUCCESS;
 }
 
+void plnr_track_set(uint8_t const enabled)
+{
+    track_enabled = enabled;
+    if (enabled)
+    {
+        log_info("Tracking the track edges on %u rows and starting the rays from the tracked center", tracker.row_num);
+    }
+}
+
+void plnr_edges_set(plnr_edges_t const mode)
+{
+    edges_mode = mode;
+    if (mode == PLNR_EDGES_SCAN)
+    {
+        stat_edges.name = "planner edges edge_plot";
+        log_info("Finding the track borders by scanning rows and fitting lanes to the edges");
+    }
+    else if (mode == PLNR_EDGES_HOUGH)
+    {
+        stat_edges.name = "planner edges hough";
+        log_info("Finding the track borders with the Hough transform over %u angles", HOUGH_THETA_NUM);
+    }
+}
+
+lane_model_t const *plnr_lane(uint8_t const left_or_right)
+{
+    uint8_t const side = left_or_right ? 0 : 1;
+    return lanes_valid[side] ? &lanes[side] : NULL;
+}
+
+int plnr_polar_set(uint16_t const angle_num)
+{
+    free(tmpl_polar);
+    tmpl_polar = NULL;
+    polar_num = 0;
+    if (angle_num == 0)
+    {
+        return EXIT_SUCCESS;
+    }
+    if (angle_num < 2 || angle_num > PLNR_POLAR_RAYS_MAX)
+    {
+        log_error("The free-space profile needs between 2 and %d rays", PLNR_POLAR_RAYS_MAX);
+        return EXIT_FAILURE;
+    }
+    /* Templates are aligned to cache lines, which plain malloc does not promise. Their size is a
+    multiple of it as aligned_alloc needs. */
+    tmpl_polar = aligned_alloc(RAY_TMPL_CACHE_LINE, angle_num * sizeof(ray_tmpl_t));
+    if (tmpl_polar == NULL)
+    {
+        log_error("Failed to allocate memory for the templates of the free-space profile");
+        return EXIT_FAILURE;
+    }
+    float const angle_start = -(float)M_PI - PLNR_POLAR_BELOW, angle_end = PLNR_POLAR_BELOW;
+    polar_weight = 0.0f;
+    for (uint16_t ray_idx = 0; ray_idx < angle_num; ray_idx++)
+    {
+        float const angle = angle_start + (angle_end - angle_start) * ray_idx / (angle_num - 1);
+        vec2_t const dir = {lroundf(cosf(angle) * PLNR_POLAR_TMPL_SCALE), lroundf(sinf(angle) * PLNR_POLAR_TMPL_SCALE)};
+        ray_tmpl_build(&tmpl_polar[ray_idx], dir);
+        /* Every step moves a whole pixel along the longer axis. */
+        polar_sideways[ray_idx] = (float)dir.x / (abs(dir.x) > abs(dir.y) ? abs(dir.x) : abs(dir.y));
+        polar_weight += fabsf(cosf(angle));
+    }
+    polar_num = angle_num;
+    log_info("Casting %u rays from the far origin along templates spread over the fan's directions", angle_num);
+    return EXIT_SUCCESS;
+}
+
 int plnr_deinit()
 {
+    free(tmpl_polar);
+    tmpl_polar = NULL;
+    polar_num = 0;
     if (shmem_plan_open)
     {
         if (sem_post(shmem_sem_plan) == -1)
@@ -2,12 +2,31 @@
 #define _PLANNER_H_
 
 #include <stdint.h>
+#include "lane.h"
+
+/* Rays cast from the far origin. Rays of the first half count towards a positive target position
+and rays of the second half, which mirror them, towards a negative one. */
+#define PLNR_FAN_DIR_NUM 12
+extern vec2_t const plnr_fan_dirs[];
+
+#define PLNR_POLAR_RAYS_MAX 256 /* Rays of the free-space profile, see 'plnr_polar_set'. */
+
+/* Detectors of the track borders. */
+typedef enum plnr_edges
+{
+    PLNR_EDGES_NONE = 0, /* Only the planner's rays. */
+    PLNR_EDGES_SCAN,     /* Lanes fit to edges scanned on rows, see 'edge_scan.h'. */
+    PLNR_EDGES_HOUGH,    /* Lines voted for by the ends of white runs, see 'hough.h'. */
+} plnr_edges_t;
 
 /**
  * @brief Initialize the planner module.
+ * @param ipm_path Path to the calibration of the inverse perspective mapping (see ipm.h). If given,
+ * planning happens on the bird's-eye view of every frame where distances are the same everywhere.
+ * If NULL, planning happens on the frame itself.
  * @return 0 on success, 1 on failure.
  */
-int plnr_init();
+int plnr_init(char const *const ipm_path);
 
 /**
  * @brief Runs the planner for a given frame. Planner expected to be called on every frame.
@@ -16,6 +35,42 @@ int plnr_init();
  */
 int plnr_step(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH]);
 
+/**
+ * @brief Follow the edges of the track from frame to frame with @c tracker , searching for them
+ * only around where they are predicted to be. The center of the track between them is where the
+ * rays are cast from and where the borders and the fill of the track are searched out from, instead
+ * of the frame center. The time taken and how often edges had to be scanned for are reported. Must
+ * be called after @c plnr_init .
+ * @param enabled 0 to not track, which is the default.
+ */
+void plnr_track_set(uint8_t const enabled);
+
+/**
+ * @brief Find the borders of the track on every frame with a detector, which draws them and
+ * reports the time it takes and how often it found both. Must be called after @c plnr_init .
+ * @param mode @c PLNR_EDGES_NONE to not run one, which is the default.
+ */
+void plnr_edges_set(plnr_edges_t const mode);
+
+/**
+ * @brief Get a border of the track as a lane, with its heading and curvature at the bottom scan
+ * row, as found in the last frame. Only @c PLNR_EDGES_SCAN fits lanes. The heading and curvature of
+ * the last frame are also logged with the detector's timing.
+ * @param left_or_right If 1 the left border is returned, if 0 the right one.
+ * @return The lane, or NULL if it was not found. It gets overwritten on every @c plnr_step call.
+ */
+lane_model_t const *plnr_lane(uint8_t const left_or_right);
+
+/**
+ * @brief Replace the fan of rays from the far origin by a free-space profile of many rays spread
+ * evenly over the same directions, each cast along a ray template like the fan's. Rays of the
+ * profile are not refined to a fraction of a pixel. Must be called after @c plnr_init .
+ * @param angle_num Number of rays, between 2 and @c PLNR_POLAR_RAYS_MAX , or 0 to cast the fan,
+ * which is the default.
+ * @return 0 on success, 1 on failure.
+ */
+int plnr_polar_set(uint16_t const angle_num);
+
 /**
  * @brief Deinitializes the planner module.
  * @return 0 on success, 1 on failure.
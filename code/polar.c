@@ -0,0 +1,123 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "tco_libd.h"
+
+#include "polar.h"
+
+int polar_init(polar_t *const polar, float const angle_start, float const angle_end, uint16_t const angle_num)
+{
+    if (angle_num < 2 || angle_num > POLAR_ANGLES_MAX)
+    {
+        log_error("Polar resampling needs between 2 and %d angles", POLAR_ANGLES_MAX);
+        return EXIT_FAILURE;
+    }
+    polar->angle_num = angle_num;
+    for (uint16_t angle_idx = 0; angle_idx < angle_num; angle_idx++)
+    {
+        float const angle = angle_start + (angle_end - angle_start) * angle_idx / (angle_num - 1);
+        polar->cos[angle_idx] = cosf(angle);
+        polar->sin[angle_idx] = sinf(angle);
+        for (uint16_t radius = 0; radius < POLAR_RADII_MAX; radius++)
+        {
+            polar->x[angle_idx][radius] = lroundf(radius * polar->cos[angle_idx]);
+            polar->y[angle_idx][radius] = lroundf(radius * polar->sin[angle_idx]);
+            polar->offsets[angle_idx][radius] = (int32_t)polar->y[angle_idx][radius] * TCO_FRAME_WIDTH + polar->x[angle_idx][radius];
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Count the radii of an angle which lie inside the frame from an origin. Coordinates only
+ * ever grow or only ever shrink along a ray, so the radii outside are a suffix which is found by a
+ * binary search.
+ * @param polar
+ * @param angle_idx
+ * @param origin Must be inside the frame.
+ * @return Number of radii inside, at least 1.
+ */
+static uint16_t polar_radii_inside(polar_t const *const polar, uint16_t const angle_idx, point2_t const origin)
+{
+    uint16_t lo = 1;
+    uint16_t hi = POLAR_RADII_MAX;
+    while (lo < hi)
+    {
+        uint16_t const mid = lo + (hi - lo) / 2;
+        int16_t const x = origin.x + polar->x[angle_idx][mid];
+        int16_t const y = origin.y + polar->y[angle_idx][mid];
+        if (x >= 0 && x < TCO_FRAME_WIDTH && y >= 0 && y < TCO_FRAME_HEIGHT)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+void polar_resample(polar_t *const polar, uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t const origin)
+{
+    polar->origin = origin;
+    uint8_t const *const start = &(*pixels)[origin.y][origin.x];
+    for (uint16_t angle_idx = 0; angle_idx < polar->angle_num; angle_idx++)
+    {
+        uint16_t const radius_num = polar_radii_inside(polar, angle_idx, origin);
+        int32_t const *const offsets = polar->offsets[angle_idx];
+        uint8_t *const row = polar->samples[angle_idx];
+        /* Samples are gathered a word at a time and the row stops after the first word holding
+        white, since nothing past it is ever scanned. */
+        uint16_t radius = 0;
+        uint8_t white = 0;
+        for (; radius + sizeof(uint64_t) <= radius_num && !white; radius += sizeof(uint64_t))
+        {
+            for (uint8_t lane = 0; lane < sizeof(uint64_t); lane++)
+            {
+                row[radius + lane] = start[offsets[radius + lane]];
+                white |= row[radius + lane];
+            }
+        }
+        for (; radius < radius_num && !white; radius++)
+        {
+            row[radius] = start[offsets[radius]];
+            white |= row[radius];
+        }
+        row[radius_num] = 255;
+        polar->radius_num[angle_idx] = radius_num;
+    }
+}
+
+/**
+ * @brief Find the first white sample of a row, 8 at a time. Any sample which is not 0 is white, the
+ * same as for the gathering. Adding 0x7f to the low 7 bits of a byte carries into its top bit
+ * unless they are all 0, and never past the byte, so the top bit of a byte is set exactly when the
+ * byte is not 0. Words are read little-endian, as on every target.
+ * @param row Must hold a white sample less than @c POLAR_ROW_PAD samples before its end.
+ * @return Index of the sample.
+ */
+static inline uint16_t polar_row_scan(uint8_t const *const row)
+{
+    for (uint16_t radius = 0;; radius += sizeof(uint64_t))
+    {
+        uint64_t word;
+        memcpy(&word, &row[radius], sizeof(uint64_t));
+        uint64_t const white = (((word & 0x7f7f7f7f7f7f7f7full) + 0x7f7f7f7f7f7f7f7full) | word) & 0x8080808080808080ull;
+        if (white != 0)
+        {
+            return radius + (__builtin_ctzll(white) >> 3);
+        }
+    }
+}
+
+void polar_profile(polar_t const *const polar, uint16_t *const lengths)
+{
+    for (uint16_t angle_idx = 0; angle_idx < polar->angle_num; angle_idx++)
+    {
+        uint16_t const white = polar_row_scan(polar->samples[angle_idx]);
+        /* Hitting the sentinel means the ray reached the border. */
+        lengths[angle_idx] = white < polar->radius_num[angle_idx] ? white : polar->radius_num[angle_idx] - 1;
+    }
+}
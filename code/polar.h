@@ -0,0 +1,64 @@
+#ifndef _POLAR_H_
+#define _POLAR_H_
+
+/**
+ * @brief Polar resampling of a segmented frame around an origin into a grid of angles by radii, one
+ * row per angle and one pixel per radius, so every ray from the origin becomes a contiguous row. The
+ * pixels of the grid are read through a table of offsets from the origin built once, which serves
+ * every origin since only where the rays leave the frame depends on it. Rays are then found by
+ * scanning their rows 8 pixels at a time. Without gathers in hardware this stays slower than ray
+ * templates, so the planner casts its profile along templates and this is only benched against them.
+ */
+
+#include <stdint.h>
+#include "tco_shmem.h"
+#include "tco_linalg.h"
+
+#define POLAR_ANGLES_MAX 256
+#define POLAR_RADII_MAX 512   /* Pixels. Longer rays end here as if at the frame border. */
+#define POLAR_ROW_PAD 8       /* Samples past the end of every row, so scans may read a whole word past a sentinel. */
+#define POLAR_CACHE_LINE 64
+
+typedef struct polar
+{
+    _Alignas(POLAR_CACHE_LINE) int32_t offsets[POLAR_ANGLES_MAX][POLAR_RADII_MAX]; /* Into a frame, from the origin. */
+    _Alignas(POLAR_CACHE_LINE) int16_t x[POLAR_ANGLES_MAX][POLAR_RADII_MAX];       /* Columns from the origin, to find where the frame border cuts the rays. */
+    _Alignas(POLAR_CACHE_LINE) int16_t y[POLAR_ANGLES_MAX][POLAR_RADII_MAX];       /* Rows from the origin. */
+    _Alignas(POLAR_CACHE_LINE) uint8_t samples[POLAR_ANGLES_MAX][POLAR_RADII_MAX + POLAR_ROW_PAD];
+    float cos[POLAR_ANGLES_MAX];
+    float sin[POLAR_ANGLES_MAX];
+    uint16_t angle_num;
+    point2_t origin;                       /* Of the last resampling. */
+    uint16_t radius_num[POLAR_ANGLES_MAX]; /* Radii of every row inside the frame in the last resampling, at least 1. */
+} polar_t;
+
+/**
+ * @brief Build the table of offsets for angles spread evenly over a range.
+ * @param polar
+ * @param angle_start First angle in radians. Angles grow clockwise on the frame since rows grow
+ * downwards, 0 points right and -pi/2 straight up.
+ * @param angle_end Last angle in radians.
+ * @param angle_num Number of angles, at least 2 and at most @c POLAR_ANGLES_MAX .
+ * @return 0 on success, 1 if the number of angles is out of range.
+ */
+int polar_init(polar_t *const polar, float const angle_start, float const angle_end, uint16_t const angle_num);
+
+/**
+ * @brief Resample a frame around an origin. Every row ends with a white sentinel just past its last
+ * radius inside the frame.
+ * @param polar
+ * @param pixels A segmented frame.
+ * @param origin Must be inside the frame.
+ */
+void polar_resample(polar_t *const polar, uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t const origin);
+
+/**
+ * @brief Cast every ray of the last resampling, each stopping at the first sample which is not 0.
+ * Lengths are in pixels and end the same way as @c raycast , so a ray which reaches the frame
+ * border ends on its last pixel inside.
+ * @param polar
+ * @param lengths Where the length of the ray of every angle is written.
+ */
+void polar_profile(polar_t const *const polar, uint16_t *const lengths);
+
+#endif /* _POLAR_H_ */
@@ -1,3 +1,4 @@
+#include <stdio.h>
 #include <stdlib.h>
 
 #include <string.h>
@@ -9,169 +10,596 @@
 #include "pre_proc.h"
 #include "draw.h"
 #include "misc.h"
-#include "stack_dyna.h"
+#include "segment.h"
+#include "mask.h"
+#include "morph.h"
+#include "roi.h"
+#include "timing.h"
+#include "pool.h"
+#include "fill.h"
+#include "label.h"
+#include "pyramid.h"
+#include "rle.h"
+#include "dist_map.h"
 
-typedef struct region
+static uint16_t const frame_bot = 210; /* Where the usable frame ends in the y direction from the top. */
+static uint16_t center_x = TCO_FRAME_WIDTH / 2; /* Column the track center is searched out from. */
+
+#define PRE_PROC_STAT_FRAMES 300   /* Timings are reported after this many frames. */
+#define PRE_PROC_REGION_AREA_MIN 16 /* Smaller components of the segmented frame are noise. */
+
+static mask_t mask_segmented; /* Bit-packed copy of the last segmented frame. */
+static morph_t morph_denoise;  /* Closes gaps in the segmented lines. */
+static roi_t roi;              /* Only pixels inside get processed. */
+static mask_t mask_track;      /* Black region of the track around its center, filled every frame. */
+static int32_t track_pixel_num = 0;
+static label_table_t regions;  /* Connected components of the segmented frame. */
+static uint8_t label_enabled = 0;
+static rle_t rle_segmented;    /* Runs of the rows of the segmented frame. */
+static pyramid_t pyramid;      /* Downsampled copies of the segmented frame. */
+static uint8_t pyramid_level_num = 0;
+static dist_map_t dist_map;    /* Steps to the next white pixel in the compass directions. */
+static uint8_t dist_map_enabled = 0;
+static uint8_t frame_gray[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH]; /* The last frame before it was segmented. */
+static uint8_t gray_enabled = 0;
+static block_map_t block_map;  /* Blocks of the segmented frame which hold any white. */
+static uint8_t block_map_enabled = 0;
+
+/* Grayscale rows needed to segment a row. */
+#define PRE_PROC_RING_ROWS ((SEGMENT_LOOK_AHEAD > SEGMENT_ADAPTIVE_RADIUS ? SEGMENT_LOOK_AHEAD : SEGMENT_ADAPTIVE_RADIUS) + 1)
+
+/* State of a band of rows which gets segmented and denoised independently of the other bands. */
+typedef struct pre_proc_band
 {
-    line2_t region;
-    uint16_t size;
-} region_t;
+    uint16_t y_start; /* Rows in [y_start, y_end) get written. */
+    uint16_t y_end;
+    uint16_t y_read;           /* Rows above this one are in the ring or not needed. */
+    uint16_t integral_y_start; /* Row the integral image in the ring was started from. */
+    morph_t morph;
+    uint8_t rows_gray[PRE_PROC_RING_ROWS][TCO_FRAME_WIDTH]; /* Ring of border filled grayscale rows. */
+    uint32_t rows_integral[SEGMENT_ADAPTIVE_RING][TCO_FRAME_WIDTH + 1]; /* Ring of integral rows for the adaptive mode. */
+    uint8_t row_segmented[TCO_FRAME_WIDTH];
+} pre_proc_band_t;
 
-static uint16_t const frame_bot = 210; /* Where the usable frame ends in the y direction from the top. */
+static pre_proc_band_t bands[POOL_WORKERS_MAX];
+static uint8_t frame_bands[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH]; /* Output of the parallel bands before it is copied back. */
+static uint32_t const integral_zero[TCO_FRAME_WIDTH + 1] = {0};
+static segment_mode_t segment_mode = SEGMENT_MODE_DELTA;
+static timing_stat_t stat_segment = {.name = "pre_proc segment"};
+static timing_stat_t stat_fill = {.name = "pre_proc fill"};
+static timing_stat_t stat_label = {.name = "pre_proc label"};
+static timing_stat_t stat_pyramid[PYRAMID_LEVELS_MAX] = {{.name = "pre_proc pyramid 2x"}, {.name = "pre_proc pyramid 4x"}};
+static timing_stat_t stat_dist_map = {.name = "pre_proc distance map"};
+static timing_stat_t stat_block_map = {.name = "pre_proc block map"};
 
-/**
- * @brief algo_segment the image to lines (white (255)) and not-lines (black (0))
- * @param image a grayscale image which algo_segments the image. 
- * @return the image is passed by reference. This reference is modified. 
- */
-static void algo_segment(uint8_t (*pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+static void algo_grating(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
 {
-    uint8_t const delta_threshold = 60;
-    uint8_t const look_ahead_length = 6;
-    for (uint16_t height_idx = 0; height_idx < TCO_FRAME_HEIGHT; height_idx++)
+    for (uint16_t y = 30; y < 211 - 10; y += 10)
     {
-        for (uint16_t width_idx = 0; width_idx < TCO_FRAME_WIDTH; width_idx++)
+        if (y < roi.y_start || y >= roi.y_end)
         {
-            if (width_idx + look_ahead_length < TCO_FRAME_WIDTH &&
-                abs((*pixels)[height_idx][width_idx] - (*pixels)[height_idx][width_idx + look_ahead_length]) > delta_threshold)
+            continue;
+        }
+        uint8_t ray_num = 0;
+        rle_run_t const *const runs = rle_segmented.runs[y];
+        uint16_t const run_num = rle_segmented.run_num[y];
+        uint16_t run_idx = rle_run_find(&rle_segmented, y, roi.x_start[y]);
+        /* Walk the black runs inside the region of interest, each after the white run before it. */
+        for (uint16_t x = roi.x_start[y]; x < roi.x_end[y];)
+        {
+            uint16_t border_size = 0;
+            if (run_idx < run_num && runs[run_idx].x_start <= x)
             {
-                (*pixels)[height_idx][width_idx] = 255;
-                continue;
+                uint16_t const white_end = runs[run_idx].x_end < roi.x_end[y] ? runs[run_idx].x_end : roi.x_end[y];
+                border_size = white_end - x;
+                for (; x < white_end; x++)
+                {
+                    draw_q_pixel((point2_t){x, y}, 60);
+                }
+                run_idx++;
+                if (x == roi.x_end[y])
+                {
+                    break;
+                }
             }
-
-            if (height_idx + look_ahead_length < TCO_FRAME_HEIGHT &&
-                abs((*pixels)[height_idx][width_idx] - (*pixels)[height_idx + look_ahead_length][width_idx]) > delta_threshold)
+            uint16_t const black_end = run_idx < run_num && runs[run_idx].x_start < roi.x_end[y] ? runs[run_idx].x_start : roi.x_end[y];
+            uint16_t const ray_len = black_end - x;
+            point2_t const start = {x, y};
+            point2_t const end = {black_end < TCO_FRAME_WIDTH ? black_end : TCO_FRAME_WIDTH - 1, y};
+            if (ray_len > 16 && border_size > 4 && border_size < 150)
             {
-                (*pixels)[height_idx][width_idx] = 255;
-                continue;
+                if (draw_enabled && !((ray_num + 1) % 2 == 0))
+                {
+                    draw_q_square(start, 4, 120);
+                    draw_q_square(end, 4, 100);
+                    draw_q_square((point2_t){(end.x + start.x) / 2, (end.y + start.y) / 2}, 4, 200);
+                    bresenham_draw_light_stop_no(pixels, start, end);
+                }
+                ray_num++;
             }
-
-            (*pixels)[height_idx][width_idx] = 0;
+            x = black_end;
         }
     }
 }
 
-static void morph_primitive(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], uint8_t const dilate_or_erode, uint8_t const three_or_five)
+int pre_proc_init(roi_t const *const roi_init)
 {
-    uint8_t const row_tmp_count = (three_or_five * 2 + !three_or_five * 3);
-    uint8_t row_tmp[row_tmp_count][TCO_FRAME_WIDTH - 2];
-    uint8_t row_tmp_idx = 0;
+    if (roi_init != NULL)
+    {
+        memcpy(&roi, roi_init, sizeof(roi_t));
+    }
+    else
+    {
+        roi_set_full(&roi);
+    }
+    log_info("Region of interest covers rows %u to %u and %u of %u pixels",
+             roi.y_start, roi.y_end, roi.pixel_num, TCO_FRAME_WIDTH * TCO_FRAME_HEIGHT);
 
-    for (uint16_t y = 1; y < TCO_FRAME_HEIGHT - 1; y++)
+    morph_reset(&morph_denoise);
+    if (morph_close(&morph_denoise, 3, 3) != 0)
     {
-        if (y >= row_tmp_count)
+        log_error("Failed to configure the morphology stages");
+        return EXIT_FAILURE;
+    }
+    morph_clip(&morph_denoise, &roi.inside);
+    for (uint8_t band_idx = 0; band_idx < POOL_WORKERS_MAX; band_idx++)
+    {
+        memcpy(&bands[band_idx].morph, &morph_denoise, sizeof(morph_t));
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Overwrite the frame border of a row with the adaptive floor color so it does not get
+ * segmented as an edge.
+ * @param row
+ * @param y Index of the row in the frame.
+ */
+static void border_fill_row(uint8_t *const row, uint16_t const y)
+{
+    uint8_t const color_floor = 120; /* 0 - 255 */
+    uint8_t const border_size = 6;
+    uint8_t const color_floor_adaptive = color_floor - ((y / (float)TCO_FRAME_HEIGHT) * color_floor);
+    if (y < border_size || y > frame_bot)
+    {
+        memset(row, color_floor_adaptive, TCO_FRAME_WIDTH);
+    }
+    else
+    {
+        memset(row, color_floor_adaptive, border_size);
+        memset(&row[TCO_FRAME_WIDTH - border_size], color_floor_adaptive, border_size);
+    }
+}
+
+/**
+ * @brief Paint the pixels of a row which lie outside the region of interest black.
+ * @param row
+ * @param y Index of the row in the frame.
+ */
+static void roi_clear_outside(uint8_t *const row, uint16_t const y)
+{
+    if (roi.x_end[y] <= roi.x_start[y])
+    {
+        memset(row, 0, TCO_FRAME_WIDTH);
+        return;
+    }
+    memset(row, 0, roi.x_start[y]);
+    memset(&row[roi.x_end[y]], 0, TCO_FRAME_WIDTH - roi.x_end[y]);
+}
+
+/**
+ * @brief Clear the rows of the segmented mask which lie outside the region of interest since the
+ * morphology does not write them.
+ */
+static void roi_clear_mask(void)
+{
+    memset(mask_segmented.rows, 0, roi.y_start * sizeof(mask_segmented.rows[0]));
+    memset(&mask_segmented.rows[roi.y_end], 0, (TCO_FRAME_HEIGHT - roi.y_end) * sizeof(mask_segmented.rows[0]));
+}
+
+void pre_proc_segment_chain(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+{
+    for (uint16_t y = 0; y < TCO_FRAME_HEIGHT; y++)
+    {
+        border_fill_row((*pixels)[y], y);
+    }
+    if (segment_mode == SEGMENT_MODE_ADAPTIVE)
+    {
+        segment_adaptive(pixels);
+    }
+    else
+    {
+        segment_delta(pixels);
+    }
+    for (uint16_t y = 0; y < TCO_FRAME_HEIGHT; y++)
+    {
+        roi_clear_outside((*pixels)[y], y);
+    }
+    morph_run(&morph_denoise, pixels, pixels, &mask_segmented, roi.y_start, roi.y_end); /* Dilate and erode 3x3 in one sweep. */
+    roi_clear_mask();
+    rle_encode_rows(&rle_segmented, &mask_segmented, 0, TCO_FRAME_HEIGHT);
+}
+
+/**
+ * @brief Read a grayscale row of the frame into the ring of a band and fill its border.
+ * @param band
+ * @param src A grayscale frame.
+ * @param y Index of the row.
+ */
+static void band_read_row(pre_proc_band_t *const band, uint8_t (*const src)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], uint16_t const y)
+{
+    memcpy(band->rows_gray[y % PRE_PROC_RING_ROWS], (*src)[y], TCO_FRAME_WIDTH);
+    border_fill_row(band->rows_gray[y % PRE_PROC_RING_ROWS], y);
+}
+
+/**
+ * @brief Segment a row of a band with the delta threshold, reading the rows it needs.
+ * @param band
+ * @param src A grayscale frame.
+ * @param y Index of the row.
+ */
+static void band_segment_delta(pre_proc_band_t *const band, uint8_t (*const src)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], uint16_t const y)
+{
+    uint16_t const y_ahead = y + SEGMENT_LOOK_AHEAD < TCO_FRAME_HEIGHT ? y + SEGMENT_LOOK_AHEAD : y;
+    for (band->y_read = band->y_read > y ? band->y_read : y; band->y_read <= y_ahead; band->y_read++)
+    {
+        band_read_row(band, src, band->y_read);
+    }
+    segment_delta_row(band->rows_gray[y % PRE_PROC_RING_ROWS],
+                      y_ahead != y ? band->rows_gray[y_ahead % PRE_PROC_RING_ROWS] : NULL,
+                      band->row_segmented,
+                      roi.x_start[y],
+                      roi.x_end[y]);
+}
+
+/**
+ * @brief Read the rows the adaptive threshold window of a row needs into the ring of a band and
+ * add them to the integral image. Rows have to be read in order even when they are not segmented
+ * since rows above the one being segmented may already be overwritten when segmenting in-place.
+ * The integral image of a band starts from the top of its first window. Window sums are
+ * differences of two integral rows so they match the ones of an integral image over the whole frame.
+ * @param band
+ * @param src A grayscale frame.
+ * @param y Index of the row.
+ */
+static void band_read_adaptive(pre_proc_band_t *const band, uint8_t (*const src)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], uint16_t const y)
+{
+    uint16_t const y_top = y > SEGMENT_ADAPTIVE_RADIUS ? y - SEGMENT_ADAPTIVE_RADIUS : 0;
+    uint16_t const y_bot = y + SEGMENT_ADAPTIVE_RADIUS < TCO_FRAME_HEIGHT ? y + SEGMENT_ADAPTIVE_RADIUS : TCO_FRAME_HEIGHT - 1;
+    if (band->y_read < y_top)
+    {
+        band->y_read = y_top;
+        band->integral_y_start = y_top;
+    }
+    for (; band->y_read <= y_bot; band->y_read++)
+    {
+        band_read_row(band, src, band->y_read);
+        segment_integral_row(band->rows_integral[band->y_read % SEGMENT_ADAPTIVE_RING],
+                             band->y_read > band->integral_y_start ? band->rows_integral[(band->y_read - 1) % SEGMENT_ADAPTIVE_RING] : integral_zero,
+                             band->rows_gray[band->y_read % PRE_PROC_RING_ROWS]);
+    }
+}
+
+/**
+ * @brief Segment a row of a band with the adaptive threshold, reading the rows it needs.
+ * @param band
+ * @param src A grayscale frame.
+ * @param y Index of the row.
+ */
+static void band_segment_adaptive(pre_proc_band_t *const band, uint8_t (*const src)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], uint16_t const y)
+{
+    uint16_t const y_top = y > SEGMENT_ADAPTIVE_RADIUS ? y - SEGMENT_ADAPTIVE_RADIUS : 0;
+    uint16_t const y_bot = y + SEGMENT_ADAPTIVE_RADIUS < TCO_FRAME_HEIGHT ? y + SEGMENT_ADAPTIVE_RADIUS : TCO_FRAME_HEIGHT - 1;
+    band_read_adaptive(band, src, y);
+    segment_adaptive_row(band->rows_gray[y % PRE_PROC_RING_ROWS],
+                         y_top > band->integral_y_start ? band->rows_integral[(y_top - 1) % SEGMENT_ADAPTIVE_RING] : integral_zero,
+                         band->rows_integral[y_bot % SEGMENT_ADAPTIVE_RING],
+                         y_bot - y_top + 1,
+                         band->row_segmented,
+                         roi.x_start[y],
+                         roi.x_end[y]);
+}
+
+/**
+ * @brief Segment and denoise a band of rows in a single sweep. Only the rows between the look-ahead
+ * row and the oldest row in the morphology ring are live at any time so the working set stays in
+ * cache. Grayscale rows are read into a private ring where their border gets filled, so @p src is
+ * never written and bands which share halo rows can run in parallel. Rows and columns outside the
+ * region of interest are never segmented, only painted black.
+ * @param band
+ * @param src A grayscale frame.
+ * @param dst Where the rows of the band are written. It can be @p src only when the band covers the
+ * whole frame since the morphology writes rows above the row being segmented.
+ */
+static void segment_band(pre_proc_band_t *const band,
+                         uint8_t (*const src)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+                         uint8_t (*const dst)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+{
+    uint16_t const y_out_start = band->y_start > roi.y_start ? band->y_start : roi.y_start;
+    uint16_t const y_out_end = band->y_end < roi.y_end ? band->y_end : roi.y_end;
+    if (y_out_start >= y_out_end)
+    {
+        memset(&(*dst)[band->y_start], 0, (band->y_end - band->y_start) * TCO_FRAME_WIDTH);
+        memset(&mask_segmented.rows[band->y_start], 0, (band->y_end - band->y_start) * sizeof(mask_segmented.rows[0]));
+        return;
+    }
+
+    band->y_read = 0;
+    band->integral_y_start = 0;
+    morph_begin(&band->morph, dst, &mask_segmented, y_out_start, y_out_end);
+    for (uint16_t y = band->morph.y_in_start; y < band->morph.y_in_end; y++)
+    {
+        if (y < roi.y_start || y >= roi.y_end || roi.x_end[y] <= roi.x_start[y])
         {
-            memcpy(&(*pixels)[y - row_tmp_count][1], &row_tmp[(row_tmp_idx + row_tmp_count - 1) % row_tmp_count][0], TCO_FRAME_WIDTH - 2);
+            if (segment_mode == SEGMENT_MODE_ADAPTIVE)
+            {
+                band_read_adaptive(band, src, y);
+            }
+            memset(band->row_segmented, 0, TCO_FRAME_WIDTH);
         }
-        for (uint16_t x = 1; x < TCO_FRAME_WIDTH - 1; x++)
+        else
         {
-            uint8_t matching;
-            if (three_or_five)
+            if (segment_mode == SEGMENT_MODE_ADAPTIVE)
             {
-                uint8_t const row1 = (1 & (*pixels)[y - 1][x - 1]) + (1 & (*pixels)[y - 1][x]) + (1 & (*pixels)[y - 1][x + 1]);
-                uint8_t const row2 = (1 & (*pixels)[y][x - 1]) + (1 & (*pixels)[y][x]) + (1 & (*pixels)[y][x + 1]);
-                uint8_t const row3 = (1 & (*pixels)[y + 1][x - 1]) + (1 & (*pixels)[y + 1][x]) + (1 & (*pixels)[y + 1][x + 1]);
-                matching = row1 + row2 + row3;
+                band_segment_adaptive(band, src, y);
             }
             else
             {
-                uint8_t const row1 = (1 & (*pixels)[y - 2][x - 2]) + (1 & (*pixels)[y - 2][x - 1]) + (1 & (*pixels)[y - 2][x]) + (1 & (*pixels)[y - 2][x + 1]) + (1 & (*pixels)[y - 2][x + 2]);
-                uint8_t const row2 = (1 & (*pixels)[y - 1][x - 2]) + (1 & (*pixels)[y - 1][x - 1]) + (1 & (*pixels)[y - 1][x]) + (1 & (*pixels)[y - 1][x + 1]) + (1 & (*pixels)[y - 1][x + 2]);
-                uint8_t const row3 = (1 & (*pixels)[y][x - 2]) + (1 & (*pixels)[y][x - 1]) + (1 & (*pixels)[y][x]) + (1 & (*pixels)[y][x + 1]) + (1 & (*pixels)[y][x + 2]);
-                uint8_t const row4 = (1 & (*pixels)[y + 1][x - 2]) + (1 & (*pixels)[y + 1][x - 1]) + (1 & (*pixels)[y + 1][x]) + (1 & (*pixels)[y + 1][x + 1]) + (1 & (*pixels)[y + 1][x + 2]);
-                uint8_t const row5 = (1 & (*pixels)[y + 2][x - 2]) + (1 & (*pixels)[y + 2][x - 1]) + (1 & (*pixels)[y + 2][x]) + (1 & (*pixels)[y + 2][x + 1]) + (1 & (*pixels)[y + 2][x + 2]);
-                matching = row1 + row2 + row3 + row4 + row5;
+                band_segment_delta(band, src, y);
             }
-
-            /* Branchless selection of dilation or erosion. */
-            row_tmp[row_tmp_idx][x - 1] = (dilate_or_erode * (matching >= 1)) + (!dilate_or_erode * (matching == (9 * three_or_five + 25 * !three_or_five))) ? 255 : 0;
+            roi_clear_outside(band->row_segmented, y);
         }
-        row_tmp_idx = (row_tmp_idx + 1) % row_tmp_count;
+        morph_push(&band->morph, band->row_segmented);
     }
+
+    /* The morphology only writes rows inside the region of interest. */
+    memset(&(*dst)[band->y_start], 0, (y_out_start - band->y_start) * TCO_FRAME_WIDTH);
+    memset(&(*dst)[y_out_end], 0, (band->y_end - y_out_end) * TCO_FRAME_WIDTH);
+    memset(&mask_segmented.rows[band->y_start], 0, (y_out_start - band->y_start) * sizeof(mask_segmented.rows[0]));
+    memset(&mask_segmented.rows[y_out_end], 0, (band->y_end - y_out_end) * sizeof(mask_segmented.rows[0]));
 }
 
-static void algo_grating(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+void pre_proc_segment_fused(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
 {
-    for (uint16_t y = 30; y < 211 - 10; y += 10)
+    bands[0].y_start = 0;
+    bands[0].y_end = TCO_FRAME_HEIGHT;
+    segment_band(&bands[0], pixels, pixels);
+    rle_encode_rows(&rle_segmented, &mask_segmented, 0, TCO_FRAME_HEIGHT);
+}
+
+/**
+ * @brief Worker task of @c pre_proc_segment_parallel . Splits the rows of the region of interest
+ * evenly between the workers, with the first and last worker also covering the rows above and
+ * below it.
+ * @param worker_idx
+ * @param worker_num
+ * @param arg The grayscale frame.
+ */
+static void task_segment(uint8_t const worker_idx, uint8_t const worker_num, void *const arg)
+{
+    pre_proc_band_t *const band = &bands[worker_idx];
+    uint16_t const roi_rows = roi.y_end - roi.y_start;
+    band->y_start = worker_idx == 0 ? 0 : roi.y_start + roi_rows * worker_idx / worker_num;
+    band->y_end = worker_idx + 1 == worker_num ? TCO_FRAME_HEIGHT : roi.y_start + roi_rows * (worker_idx + 1) / worker_num;
+    segment_band(band, arg, &frame_bands);
+    rle_encode_rows(&rle_segmented, &mask_segmented, band->y_start, band->y_end);
+}
+
+/**
+ * @brief Worker task of @c pre_proc_segment_parallel which copies the band of a worker back into
+ * the frame once all workers are done reading it.
+ * @param worker_idx
+ * @param worker_num
+ * @param arg The frame.
+ */
+static void task_copy_back(uint8_t const worker_idx, uint8_t const worker_num, void *const arg)
+{
+    uint8_t(*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH] = arg;
+    pre_proc_band_t const *const band = &bands[worker_idx];
+    memcpy(&(*pixels)[band->y_start], &frame_bands[band->y_start], (band->y_end - band->y_start) * TCO_FRAME_WIDTH);
+}
+
+void pre_proc_segment_parallel(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+{
+    if (pool_worker_num() == 1)
     {
-        uint8_t ray_num = 0;
-        uint16_t border_size = 0;
-        for (uint16_t x = 0; x < TCO_FRAME_WIDTH; x++)
+        pre_proc_segment_fused(pixels);
+        return;
+    }
+    pool_run(&task_segment, pixels);
+    pool_run(&task_copy_back, pixels);
+}
+
+void pre_proc(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+{
+    uint64_t const start = timing_now_ns();
+    if (gray_enabled)
+    {
+        memcpy(frame_gray, pixels, sizeof(frame_gray));
+    }
+    pre_proc_segment_parallel(pixels);
+    timing_stat_add(&stat_segment, timing_now_ns() - start);
+    if (stat_segment.sample_num >= PRE_PROC_STAT_FRAMES)
+    {
+        char note[96];
+        snprintf(note, sizeof(note), "region of interest skips %u of %u pixels",
+                 TCO_FRAME_WIDTH * TCO_FRAME_HEIGHT - roi.pixel_num, TCO_FRAME_WIDTH * TCO_FRAME_HEIGHT);
+        timing_stat_report(&stat_segment, note);
+    }
+
+    pyramid.level_num = 0;
+    for (uint8_t level = 1; level <= pyramid_level_num; level++)
+    {
+        uint64_t const level_start = timing_now_ns();
+        pyramid_build(&pyramid, pixels, level);
+        timing_stat_add(&stat_pyramid[level - 1], timing_now_ns() - level_start);
+        if (stat_pyramid[level - 1].sample_num >= PRE_PROC_STAT_FRAMES)
         {
-            if ((*pixels)[y][x] == 255)
-            {
-                border_size++;
-                draw_q_pixel((point2_t){x, y}, 60);
-            }
-            else if ((*pixels)[y][x] == 0)
-            {
-                point2_t start = {x, y};
-                uint16_t ray_len = raycast(pixels, start, (vec2_t){1, 0}, &cb_draw_no_stop_white);
-                x += ray_len;
-                point2_t end = {x, y};
+            timing_stat_report(&stat_pyramid[level - 1], NULL);
+        }
+    }
 
-                if (ray_len > 16 && border_size > 4 && border_size < 150)
-                {
-                    if (!((ray_num + 1) % 2 == 0))
-                    {
-                        draw_q_square(start, 4, 120);
-                        draw_q_square(end, 4, 100);
-                        draw_q_square((point2_t){(end.x + start.x) / 2, (end.y + start.y) / 2}, 4, 200);
-                        bresenham(pixels, &cb_draw_light_stop_no, start, end);
-                    }
-                    ray_num++;
-                }
-                else
-                {
-                    border_size += ray_len;
-                }
-                border_size = 0;
-            }
+    if (dist_map_enabled)
+    {
+        uint64_t const dist_map_start = timing_now_ns();
+        dist_map_build(&dist_map, pixels, &rle_segmented, &roi);
+        timing_stat_add(&stat_dist_map, timing_now_ns() - dist_map_start);
+        if (stat_dist_map.sample_num >= PRE_PROC_STAT_FRAMES)
+        {
+            char note[32];
+            snprintf(note, sizeof(note), "%zu kB", sizeof(dist_map) / 1024);
+            timing_stat_report(&stat_dist_map, note);
+        }
+    }
+
+    if (block_map_enabled)
+    {
+        uint64_t const block_map_start = timing_now_ns();
+        block_map_build(&block_map, &mask_segmented, &roi.inside);
+        timing_stat_add(&stat_block_map, timing_now_ns() - block_map_start);
+        if (stat_block_map.sample_num >= PRE_PROC_STAT_FRAMES)
+        {
+            char note[64];
+            snprintf(note, sizeof(note), "%u 8x8 and %u 32x32 blocks empty in the last frame", block_map.empty_num[0], block_map.empty_num[1]);
+            timing_stat_report(&stat_block_map, note);
         }
     }
+
+    if (label_enabled)
+    {
+        uint64_t const label_start = timing_now_ns();
+        if (label_mask(&regions, &mask_segmented, PRE_PROC_REGION_AREA_MIN) < 0)
+        {
+            log_debug("Segmented frame has too many components to label all of them");
+        }
+        timing_stat_add(&stat_label, timing_now_ns() - label_start);
+        if (stat_label.sample_num >= PRE_PROC_STAT_FRAMES)
+        {
+            char note[64];
+            snprintf(note, sizeof(note), "%u of %u components in the last frame are regions",
+                     regions.region_num, regions.component_num);
+            timing_stat_report(&stat_label, note);
+        }
+    }
+
+    uint64_t const fill_start = timing_now_ns();
+    point2_t const center_black = track_center_black(&rle_segmented, frame_bot, center_x);
+    track_pixel_num = fill_span(&mask_track, &mask_segmented, &roi.inside, center_black);
+    timing_stat_add(&stat_fill, timing_now_ns() - fill_start);
+    if (track_pixel_num < 0)
+    {
+        log_debug("Track fill ran out of stack space and is incomplete");
+    }
+    if (stat_fill.sample_num >= PRE_PROC_STAT_FRAMES)
+    {
+        timing_stat_report(&stat_fill, NULL);
+    }
 }
 
-static void span_fill(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t const origin)
+void pre_proc_segment_mode_set(segment_mode_t const mode)
 {
-    if ((*pixels)[origin.y][origin.x] == 255)
+    segment_mode = mode;
+    log_info("Segmenting with the %s threshold", mode == SEGMENT_MODE_ADAPTIVE ? "adaptive" : "delta");
+}
+
+void pre_proc_pyramid_set(uint8_t const level_num)
+{
+    pyramid_level_num = level_num < PYRAMID_LEVELS_MAX ? level_num : PYRAMID_LEVELS_MAX;
+    pyramid.level_num = 0;
+    if (pyramid_level_num > 0)
     {
-        return;
+        log_info("Downsampling segmented frames down to %ux", 1 << pyramid_level_num);
     }
+}
 
-    point2_t pt;
-    uint16_t x1;
-    uint8_t span_above, span_below;
+void pre_proc_dist_map_set(uint8_t const enabled)
+{
+    dist_map_enabled = enabled;
+    if (enabled)
+    {
+        dist_map_init();
+        log_info("Building a distance map of every segmented frame, which takes %zu kB", sizeof(dist_map) / 1024);
+    }
+}
 
-    stack_dyna_t stack = {NULL, 0, 0, sizeof(point2_t)};
+void pre_proc_gray_set(uint8_t const enabled)
+{
+    gray_enabled = enabled;
+    if (enabled)
+    {
+        log_info("Keeping a copy of every grayscale frame before it is segmented");
+    }
+}
 
-    /* TODO: Finish this. */
+void pre_proc_center_set(uint16_t const x)
+{
+    center_x = x < TCO_FRAME_WIDTH ? x : TCO_FRAME_WIDTH - 1;
+}
 
-    if (stack.data != NULL)
+void pre_proc_block_map_set(uint8_t const enabled)
+{
+    block_map_enabled = enabled;
+    if (enabled)
     {
-        free(stack.data);
+        log_info("Building a map of the blocks of every segmented frame which hold any white, for rays to skip the rest");
     }
 }
 
-void pre_proc(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+void pre_proc_label_set(uint8_t const enabled)
 {
-    uint8_t const color_floor = 120; /* 0 - 255 */
-    uint8_t const border_size = 6;
-    for (uint16_t y = 0; y < TCO_FRAME_HEIGHT; y++)
+    label_enabled = enabled;
+    if (enabled)
     {
-        uint8_t const color_floor_adaptive = color_floor - ((y / (float)TCO_FRAME_HEIGHT) * color_floor);
-        if (y < border_size || y > frame_bot)
-        {
-            memset(&(*pixels)[y][0], color_floor_adaptive, TCO_FRAME_WIDTH);
-        }
-        else
-        {
-            memset(&(*pixels)[y][0], color_floor_adaptive, border_size);
-            memset(&(*pixels)[y][TCO_FRAME_WIDTH - border_size], color_floor_adaptive, border_size);
-        }
+        log_info("Labelling the connected components of every segmented frame");
     }
-    algo_segment(pixels);
-    morph_primitive(pixels, 1, 1); /* Dilate 3x3 */
-    morph_primitive(pixels, 0, 1); /* Erode 3x3 */
-    point2_t const center_black = track_center_black(pixels, frame_bot);
-    span_fill(pixels, center_black);
+}
+
+mask_t const *pre_proc_mask(void)
+{
+    return &mask_segmented;
+}
+
+mask_t const *pre_proc_track(void)
+{
+    return &mask_track;
+}
+
+int32_t pre_proc_track_pixel_num(void)
+{
+    return track_pixel_num;
+}
+
+label_table_t const *pre_proc_regions(void)
+{
+    return label_enabled ? &regions : NULL;
+}
+
+rle_t const *pre_proc_rle(void)
+{
+    return &rle_segmented;
+}
+
+pyramid_t const *pre_proc_pyramid(void)
+{
+    return &pyramid;
+}
+
+dist_map_t const *pre_proc_dist_map(void)
+{
+    return dist_map_enabled ? &dist_map : NULL;
+}
+
+block_map_t const *pre_proc_block_map(void)
+{
+    return block_map_enabled ? &block_map : NULL;
+}
+
+uint8_t (*pre_proc_gray(void))[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH]
+{
+    return gray_enabled ? &frame_gray : NULL;
+}
+
+roi_t const *pre_proc_roi(void)
+{
+    return &roi;
 }
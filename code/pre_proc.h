@@ -3,7 +3,176 @@
 
 #include <stdint.h>
 #include "tco_shmem.h"
+#include "mask.h"
+#include "roi.h"
+#include "label.h"
+#include "segment.h"
+#include "pyramid.h"
+#include "rle.h"
+#include "dist_map.h"
+#include "block_map.h"
+
+/**
+ * @brief Initialize the pre-processing module.
+ * @param roi_init Region of interest outside which pixels are not processed. It gets copied. If
+ * NULL, the whole frame is processed.
+ * @return 0 on success, 1 on failure.
+ */
+int pre_proc_init(roi_t const *const roi_init);
+
+/**
+ * @brief Segment and denoise a frame with one full pass per step: border fill, segmentation,
+ * painting pixels outside the region of interest black and closing. Kept as the reference for
+ * @c pre_proc_segment_fused .
+ * @param pixels A grayscale frame which gets overwritten with the segmented frame. The packed copy
+ * is written to the mask returned by @c pre_proc_mask and its runs to @c pre_proc_rle .
+ */
+void pre_proc_segment_chain(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH]);
+
+/**
+ * @brief Segment and denoise a frame in a single sweep which streams each row through border fill,
+ * segmentation and closing while it is still in cache. Pixels outside the region of interest are
+ * not processed. The output is bit-identical to @c pre_proc_segment_chain .
+ * @param pixels A grayscale frame which gets overwritten with the segmented frame. The packed copy
+ * is written to the mask returned by @c pre_proc_mask and its runs to @c pre_proc_rle .
+ */
+void pre_proc_segment_fused(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH]);
+
+/**
+ * @brief Same as @c pre_proc_segment_fused but the frame is split into horizontal bands which run
+ * on the workers of the pool, each reading the halo rows it needs around its band. Falls back to
+ * @c pre_proc_segment_fused when the pool has a single worker.
+ * @param pixels A grayscale frame which gets overwritten with the segmented frame. The packed copy
+ * is written to the mask returned by @c pre_proc_mask and its runs to @c pre_proc_rle .
+ */
+void pre_proc_segment_parallel(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH]);
 
 void pre_proc(uint8_t (*pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH]);
 
+/**
+ * @brief Pick the kernel frames get segmented with. Must not be called while a frame is being
+ * processed. Defaults to @c SEGMENT_MODE_DELTA .
+ * @param mode
+ */
+void pre_proc_segment_mode_set(segment_mode_t const mode);
+
+/**
+ * @brief Build downsampled copies of every segmented frame so the planner can find the track at a
+ * lower resolution first. The time taken by every level is reported separately. Must not be called
+ * while a frame is being processed.
+ * @param level_num Number of levels past the full frame, 1 for 2x and 2 for 2x and 4x. 0 to not
+ * build any, which is the default.
+ */
+void pre_proc_pyramid_set(uint8_t const level_num);
+
+/**
+ * @brief Build a distance map of every segmented frame so the planner finds rays in the compass
+ * directions with a single load. Its size is logged and the time taken to build it is reported.
+ * Must not be called while a frame is being processed.
+ * @param enabled 0 to not build it, which is the default.
+ */
+void pre_proc_dist_map_set(uint8_t const enabled);
+
+/**
+ * @brief Keep a copy of every grayscale frame before it gets segmented, so the planner can refine
+ * where the edges it finds lie. Must not be called while a frame is being processed.
+ * @param enabled 0 to not keep it, which is the default.
+ */
+void pre_proc_gray_set(uint8_t const enabled);
+
+/**
+ * @brief Build bitmaps of the 8x8 and 32x32 blocks of every segmented frame which hold any white,
+ * which the planner's rays jump over the empty blocks with. The time taken to build them and how
+ * many blocks were empty are reported. Must not be called while a frame is being processed.
+ * @param enabled 0 to not build them, which is the default.
+ */
+void pre_proc_block_map_set(uint8_t const enabled);
+
+/**
+ * @brief Label the connected components of every segmented frame, so track borders can be told
+ * from blobs of noise by their size and bounds. The time taken and how many components were regions
+ * are reported. Must not be called while a frame is being processed.
+ * @param enabled 0 to not label them, which is the default.
+ */
+void pre_proc_label_set(uint8_t const enabled);
+
+/**
+ * @brief Set where the center of the track is searched out from when seeding the fill of the track
+ * in the following frames, e.g. where the planner tracked it. Must not be called while a frame is
+ * being processed.
+ * @param x Column of the frame. It is the frame center by default.
+ */
+void pre_proc_center_set(uint16_t const x);
+
+/**
+ * @brief Get the bit-packed copy of the frame last segmented by @c pre_proc .
+ * @return Pointer to the mask. It stays valid and gets overwritten on every @c pre_proc call.
+ */
+mask_t const *pre_proc_mask(void);
+
+/**
+ * @brief Get the black region of the track which @c pre_proc flood fills from the center of the
+ * track in the segmented frame. Use @c mask_get to check if a pixel belongs to it.
+ * @return Pointer to the mask. It stays valid and gets overwritten on every @c pre_proc call.
+ */
+mask_t const *pre_proc_track(void);
+
+/**
+ * @brief Get the size of the region returned by @c pre_proc_track .
+ * @return Number of pixels or -1 if the fill was cut short.
+ */
+int32_t pre_proc_track_pixel_num(void);
+
+/**
+ * @brief Get the connected components of the frame last segmented by @c pre_proc . Components too
+ * small to be anything but noise are not stored as regions.
+ * @return Pointer to the table, or NULL if labelling is off (see @c pre_proc_label_set ). It stays
+ * valid and gets overwritten on every @c pre_proc call.
+ */
+label_table_t const *pre_proc_regions(void);
+
+/**
+ * @brief Get the run-length encoding of the frame last segmented by @c pre_proc , which the
+ * workers write for their rows as soon as they are segmented.
+ * @return Pointer to the runs. They stay valid and get overwritten on every @c pre_proc call.
+ */
+rle_t const *pre_proc_rle(void);
+
+/**
+ * @brief Get the downsampled copies of the frame last segmented by @c pre_proc .
+ * @return Pointer to the pyramid. Its @c level_num is 0 if none are built. It stays valid and gets
+ * overwritten on every @c pre_proc call.
+ */
+pyramid_t const *pre_proc_pyramid(void);
+
+/**
+ * @brief Get the distance map of the frame last segmented by @c pre_proc , built for its region of
+ * interest.
+ * @return Pointer to the map or NULL if none is built. It stays valid and gets overwritten on every
+ * @c pre_proc call.
+ */
+dist_map_t const *pre_proc_dist_map(void);
+
+/**
+ * @brief Get the occupied blocks of the frame last segmented by @c pre_proc , built for its region
+ * of interest.
+ * @return Pointer to the map or NULL if none is built. It stays valid and gets overwritten on every
+ * @c pre_proc call.
+ */
+block_map_t const *pre_proc_block_map(void);
+
+/**
+ * @brief Get the grayscale frame last segmented by @c pre_proc , as it was before segmentation.
+ * @return Pointer to the frame or NULL if no copy is kept. It stays valid and gets overwritten on
+ * every @c pre_proc call.
+ */
+uint8_t (*pre_proc_gray(void))[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH];
+
+/**
+ * @brief Get the region of interest used by @c pre_proc . Pixels outside it are black in segmented
+ * frames.
+ * @return Pointer to the region. It stays valid and does not change after @c pre_proc_init .
+ */
+roi_t const *pre_proc_roi(void);
+
 #endif /* _PRE_PROC_H_ */
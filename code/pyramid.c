@@ -0,0 +1,150 @@
+#include <stdlib.h>
+#include <math.h>
+
+#include "pyramid.h"
+#include "simd.h"
+
+#define PYRAMID_REFINE_BACK 2 /* Level pixels before the coarse hit where tracing the full frame starts. */
+
+void pyramid_halve_row(uint8_t const *const row_top, uint8_t const *const row_bot, uint8_t *const out, uint16_t const out_width)
+{
+    uint16_t x = 0;
+#if defined(SIMD_NEON)
+    for (; x + SIMD_WIDTH <= out_width; x += SIMD_WIDTH)
+    {
+        /* Deinterleaving loads split the even and odd columns of a block. */
+        uint8x16x2_t const top = vld2q_u8(&row_top[2 * x]);
+        uint8x16x2_t const bot = vld2q_u8(&row_bot[2 * x]);
+        vst1q_u8(&out[x], vrhaddq_u8(vrhaddq_u8(top.val[0], bot.val[0]), vrhaddq_u8(top.val[1], bot.val[1])));
+    }
+#elif defined(SIMD_SSE2)
+    /* The even and odd columns get split into the low and high bytes of 16 bit lanes. */
+    __m128i const low_bytes = _mm_set1_epi16(0x00FF);
+    for (; x + SIMD_WIDTH <= out_width; x += SIMD_WIDTH)
+    {
+        __m128i const avg_a = _mm_avg_epu8(_mm_loadu_si128((__m128i const *)&row_top[2 * x]), _mm_loadu_si128((__m128i const *)&row_bot[2 * x]));
+        __m128i const avg_b = _mm_avg_epu8(_mm_loadu_si128((__m128i const *)&row_top[2 * x + SIMD_WIDTH]), _mm_loadu_si128((__m128i const *)&row_bot[2 * x + SIMD_WIDTH]));
+        __m128i const out_a = _mm_avg_epu16(_mm_and_si128(avg_a, low_bytes), _mm_srli_epi16(avg_a, 8));
+        __m128i const out_b = _mm_avg_epu16(_mm_and_si128(avg_b, low_bytes), _mm_srli_epi16(avg_b, 8));
+        _mm_storeu_si128((__m128i *)&out[x], _mm_packus_epi16(out_a, out_b));
+    }
+#endif
+
+    for (; x < out_width; x++)
+    {
+        uint8_t const avg_even = (row_top[2 * x] + row_bot[2 * x] + 1) / 2;
+        uint8_t const avg_odd = (row_top[2 * x + 1] + row_bot[2 * x + 1] + 1) / 2;
+        out[x] = (avg_even + avg_odd + 1) / 2;
+    }
+}
+
+void pyramid_build(pyramid_t *const pyramid, uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], uint8_t const level)
+{
+    uint8_t const *const src = level == 1 ? &(*pixels)[0][0] : pyramid_level(pyramid, level - 1);
+    uint8_t *const dst = (uint8_t *)pyramid_level(pyramid, level);
+    uint16_t const src_width = PYRAMID_WIDTH(level - 1);
+    for (uint16_t y = 0; y < PYRAMID_HEIGHT(level); y++)
+    {
+        pyramid_halve_row(&src[2 * y * src_width], &src[(2 * y + 1) * src_width], &dst[y * PYRAMID_WIDTH(level)], PYRAMID_WIDTH(level));
+    }
+    pyramid->level_num = level;
+}
+
+uint8_t const *pyramid_level(pyramid_t const *const pyramid, uint8_t const level)
+{
+    return level == 1 ? &pyramid->half[0][0] : &pyramid->quarter[0][0];
+}
+
+/**
+ * @brief Check if all the full frame pixels a pixel of a level covers lie inside a region of
+ * interest.
+ * @param roi
+ * @param level
+ * @param x In the coordinates of the level.
+ * @param y In the coordinates of the level.
+ * @return 1 if all of them are inside, 0 otherwise.
+ */
+static inline uint8_t pyramid_roi_inside(roi_t const *const roi, uint8_t const level, uint16_t const x, uint16_t const y)
+{
+    uint16_t const x_start = x << level;
+    uint16_t const x_end = (x + 1) << level;
+    for (uint16_t y_full = y << level; y_full < (uint16_t)((y + 1) << level); y_full++)
+    {
+        if (y_full < roi->y_start || y_full >= roi->y_end || x_start < roi->x_start[y_full] || x_end > roi->x_end[y_full])
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+uint16_t pyramid_raycast(pyramid_t const *const pyramid, uint8_t const level, roi_t const *const roi, point2_t const start, vec2_t const dir)
+{
+    uint16_t const width = PYRAMID_WIDTH(level);
+    uint16_t const height = PYRAMID_HEIGHT(level);
+    if (start.x >= width || start.y >= height || (dir.x == 0 && dir.y == 0))
+    {
+        return 0;
+    }
+    uint8_t const *const pixels = pyramid_level(pyramid, level);
+
+    /* Same as 'raycast', stretch the direction so it touches the border of the level. */
+    float const edge_stretch_x = dir.x == 0 ? INFINITY : dir.x < 0 ? start.x / (float)-dir.x : (width - 1 - start.x) / (float)dir.x;
+    float const edge_stretch_y = dir.y == 0 ? INFINITY : dir.y < 0 ? start.y / (float)-dir.y : (height - 1 - start.y) / (float)dir.y;
+    float const edge_stretch = edge_stretch_y < edge_stretch_x ? edge_stretch_y : edge_stretch_x;
+    point2_t const end = {start.x + (int16_t)(dir.x * edge_stretch), start.y + (int16_t)(dir.y * edge_stretch)};
+
+    int16_t const dx = abs(end.x - start.x), sx = start.x < end.x ? 1 : -1;
+    int16_t const dy = -abs(end.y - start.y), sy = start.y < end.y ? 1 : -1;
+    int16_t err = dx + dy;
+    uint16_t x = start.x;
+    uint16_t y = start.y;
+    uint16_t length = 0;
+    while (pixels[y * width + x] == 0 && (roi == NULL || pyramid_roi_inside(roi, level, x, y)) && (x != end.x || y != end.y))
+    {
+        length++;
+        int16_t const e2 = 2 * err;
+        if (e2 >= dy)
+        {
+            err += dy;
+            x += sx;
+        }
+        if (e2 <= dx)
+        {
+            err += dx;
+            y += sy;
+        }
+    }
+    return length;
+}
+
+uint16_t pyramid_raycast_refine(pyramid_t const *const pyramid,
+                                uint8_t const level,
+                                uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+                                roi_t const *const roi,
+                                point2_t const start,
+                                vec2_t const dir,
+                                raycast_func_t const cast)
+{
+    if (level == 0 || level > pyramid->level_num || start.x >= TCO_FRAME_WIDTH || start.y >= TCO_FRAME_HEIGHT)
+    {
+        return cast(pixels, roi, start, dir);
+    }
+    uint16_t const length_coarse = pyramid_raycast(pyramid, level, roi, (point2_t){start.x >> level, start.y >> level}, dir);
+    if (length_coarse <= PYRAMID_REFINE_BACK)
+    {
+        return cast(pixels, roi, start, dir);
+    }
+
+    /* Lengths count steps along the major axis of the direction, at every level. */
+    uint16_t const skip = (length_coarse - PYRAMID_REFINE_BACK) << level;
+    int16_t const dir_major = abs(dir.x) > abs(dir.y) ? abs(dir.x) : abs(dir.y);
+    int16_t const refine_x = start.x + (dir.x * skip + (dir.x < 0 ? -dir_major : dir_major) / 2) / dir_major;
+    int16_t const refine_y = start.y + (dir.y * skip + (dir.y < 0 ? -dir_major : dir_major) / 2) / dir_major;
+    if (check_bounds_inside(refine_x, refine_y) != 0 || (roi != NULL && !roi_contains(roi, refine_x, refine_y)))
+    {
+        /* The full frame ray may have left the region of interest before the skipped pixels. */
+        return cast(pixels, roi, start, dir);
+    }
+    return skip + cast(pixels, roi, (point2_t){refine_x, refine_y}, dir);
+}
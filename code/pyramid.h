@@ -0,0 +1,95 @@
+#ifndef _PYRAMID_H_
+#define _PYRAMID_H_
+
+/**
+ * @brief Half and quarter resolution copies of a segmented frame for planning coarse to fine. Every
+ * level is a 2x2 box filter of the level above, so a pixel of a level is white (non-zero) exactly
+ * when any pixel of the full frame it covers is white.
+ */
+
+#include <stdint.h>
+#include "tco_shmem.h"
+#include "tco_linalg.h"
+#include "roi.h"
+#include "misc.h"
+
+#define PYRAMID_LEVELS_MAX 2 /* Level 1 is 2x and level 2 is 4x downsampled. Level 0 is the full frame. */
+#define PYRAMID_WIDTH(level) (TCO_FRAME_WIDTH >> (level))
+#define PYRAMID_HEIGHT(level) (TCO_FRAME_HEIGHT >> (level))
+
+_Static_assert(TCO_FRAME_WIDTH % (1 << PYRAMID_LEVELS_MAX) == 0 && TCO_FRAME_HEIGHT % (1 << PYRAMID_LEVELS_MAX) == 0,
+               "Every level must cover the whole frame");
+
+typedef struct pyramid
+{
+    uint8_t level_num; /* Levels built past the full frame. */
+    uint8_t half[PYRAMID_HEIGHT(1)][PYRAMID_WIDTH(1)];
+    uint8_t quarter[PYRAMID_HEIGHT(2)][PYRAMID_WIDTH(2)];
+} pyramid_t;
+
+/**
+ * @brief Downsample two rows by averaging every 2x2 block of pixels. The average is taken as the
+ * rounded up average of the rounded up averages of the two rows, which is what NEON and SSE2
+ * compute, so it is not exact but a block is non-zero exactly when one of its pixels is. Uses NEON
+ * or SSE2 when available.
+ * @param row_top
+ * @param row_bot Row below @p row_top .
+ * @param out Where the downsampled row is written.
+ * @param out_width Number of pixels of @p out . The input rows are twice as wide.
+ */
+void pyramid_halve_row(uint8_t const *const row_top, uint8_t const *const row_bot, uint8_t *const out, uint16_t const out_width);
+
+/**
+ * @brief Build a level of the pyramid from the level above it. Levels have to be built in order.
+ * @param pyramid
+ * @param pixels The full frame, only read when building level 1.
+ * @param level Level to build, 1 to @c PYRAMID_LEVELS_MAX .
+ */
+void pyramid_build(pyramid_t *const pyramid, uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], uint8_t const level);
+
+/**
+ * @brief Get the pixels of a level.
+ * @param pyramid
+ * @param level 1 to @c PYRAMID_LEVELS_MAX .
+ * @return The first pixel of the level. Rows are @c PYRAMID_WIDTH(level) pixels apart.
+ */
+uint8_t const *pyramid_level(pyramid_t const *const pyramid, uint8_t const level);
+
+/**
+ * @brief Start a raycast on a level of the pyramid, which stops before the first white pixel, the
+ * first pixel covering any full frame pixel outside the region of interest, or the border of the
+ * level.
+ * @param pyramid
+ * @param level 1 to @c PYRAMID_LEVELS_MAX .
+ * @param roi Region of interest in full frame coordinates, or NULL to not stop at one.
+ * @param start Where the raycast will begin, in the coordinates of the level.
+ * @param dir In what direction the ray will be cast.
+ * @return Length of the ray in pixels of the level.
+ */
+uint16_t pyramid_raycast(pyramid_t const *const pyramid, uint8_t const level, roi_t const *const roi, point2_t const start, vec2_t const dir);
+
+/**
+ * @brief Cast a ray on the full frame the same way as @c raycast , but find roughly where it ends
+ * on a level of the pyramid first and only trace the full frame from a level pixel before that. The
+ * coarse ray stops where the region of interest does too, so it never jumps past its border.
+ * Since the coarse ray does not visit exactly the same pixels, the length can differ by a few
+ * pixels from the one @c raycast returns and @p cast does not see the skipped pixels.
+ * @param pyramid Built from @p pixels .
+ * @param level Level the ray is found on first. 0 traces the full frame only.
+ * @param pixels A segmented frame.
+ * @param roi See @c raycast .
+ * @param start Where the raycast will begin.
+ * @param dir In what direction the ray will be cast.
+ * @param cast Variant of @c raycast the full frame is traced with, such as
+ * @c raycast_draw_no_stop_white .
+ * @return Length of the ray.
+ */
+uint16_t pyramid_raycast_refine(pyramid_t const *const pyramid,
+                                uint8_t const level,
+                                uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+                                roi_t const *const roi,
+                                point2_t const start,
+                                vec2_t const dir,
+                                raycast_func_t const cast);
+
+#endif /* _PYRAMID_H_ */
@@ -0,0 +1,155 @@
+#include <stdlib.h>
+
+#include "ray_tmpl.h"
+
+void ray_tmpl_build(ray_tmpl_t *const tmpl, vec2_t const dir)
+{
+    tmpl->dir = dir;
+    /* Bresenham along the direction, continued until the template is long enough. The line of a
+    direction repeats after every multiple of it, so the steps follow the direction exactly. */
+    int16_t const dx = abs(dir.x), sx = dir.x < 0 ? -1 : 1;
+    int16_t const dy = -abs(dir.y), sy = dir.y < 0 ? -1 : 1;
+    int16_t err = dx + dy;
+    int16_t x = 0, y = 0;
+    for (uint16_t step = 0; step < RAY_TMPL_STEPS_MAX; step++)
+    {
+        tmpl->offsets[step] = (int32_t)y * TCO_FRAME_WIDTH + x;
+        tmpl->x[step] = x;
+        tmpl->y[step] = y;
+        int16_t const e2 = 2 * err;
+        if (e2 >= dy)
+        {
+            err += dy;
+            x += sx;
+        }
+        if (e2 <= dx)
+        {
+            err += dx;
+            y += sy;
+        }
+    }
+}
+
+/* Coordinates only ever grow or only ever shrink along a ray, so the steps outside are a suffix
+which is found by a binary search. */
+uint16_t ray_tmpl_steps_inside(ray_tmpl_t const *const tmpl, point2_t const origin)
+{
+    uint16_t lo = 1;
+    uint16_t hi = RAY_TMPL_STEPS_MAX;
+    while (lo < hi)
+    {
+        uint16_t const mid = lo + (hi - lo) / 2;
+        int16_t const x = origin.x + tmpl->x[mid];
+        int16_t const y = origin.y + tmpl->y[mid];
+        if (x >= 0 && x < TCO_FRAME_WIDTH && y >= 0 && y < TCO_FRAME_HEIGHT)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+uint16_t ray_tmpl_cast(ray_tmpl_t const *const tmpl,
+                       uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+                       roi_t const *const roi,
+                       point2_t const origin)
+{
+    if (origin.x >= TCO_FRAME_WIDTH || origin.y >= TCO_FRAME_HEIGHT)
+    {
+        return 0;
+    }
+    uint16_t const step_num = ray_tmpl_steps_inside(tmpl, origin);
+    uint8_t const *const start = &(*pixels)[origin.y][origin.x];
+    int32_t const *const offsets = tmpl->offsets;
+    uint16_t step = 0;
+    if (roi == NULL)
+    {
+        while (step < step_num && start[offsets[step]] != 255)
+        {
+            step++;
+        }
+    }
+    else
+    {
+        while (step < step_num && start[offsets[step]] != 255 && roi_contains(roi, origin.x + tmpl->x[step], origin.y + tmpl->y[step]))
+        {
+            step++;
+        }
+    }
+    /* A ray which reaches the border ends on its last pixel inside, like 'raycast'. */
+    return step < step_num ? step : step_num - 1;
+}
+
+/**
+ * @brief Count steps of a template which are sure to stay in the block a step lies in. Coordinates
+ * change by at most one per step and only ever one way, so the ray stays in the block for at least
+ * as many more steps as it is away from the nearest side it moves towards. When the step after the
+ * farthest such distance is still in the block, so is every step before it.
+ * @param tmpl
+ * @param origin
+ * @param step The step, which lies in the block.
+ * @param step_num Steps inside the frame.
+ * @param shift Side of the block as a power of 2.
+ * @return Steps to move on by, at least 1.
+ */
+static inline uint16_t ray_tmpl_block_skip(ray_tmpl_t const *const tmpl, point2_t const origin, uint16_t const step, uint16_t const step_num, uint8_t const shift)
+{
+    uint16_t const last = (1 << shift) - 1;
+    uint16_t const x = origin.x + tmpl->x[step];
+    uint16_t const y = origin.y + tmpl->y[step];
+    uint16_t const left = step_num - 1 - step; /* Steps after this one inside the frame. */
+    uint16_t const dist_x = tmpl->dir.x > 0 ? last - (x & last) : tmpl->dir.x < 0 ? (x & last) : left;
+    uint16_t const dist_y = tmpl->dir.y > 0 ? last - (y & last) : tmpl->dir.y < 0 ? (y & last) : left;
+    uint16_t dist_max = dist_x > dist_y ? dist_x : dist_y;
+    dist_max = dist_max < left ? dist_max : left;
+    uint16_t const x_far = origin.x + tmpl->x[step + dist_max];
+    uint16_t const y_far = origin.y + tmpl->y[step + dist_max];
+    if ((x_far >> shift) == (x >> shift) && (y_far >> shift) == (y >> shift))
+    {
+        return dist_max + 1;
+    }
+    uint16_t const dist_min = dist_x < dist_y ? dist_x : dist_y;
+    return (dist_min < left ? dist_min : left) + 1;
+}
+
+uint16_t ray_tmpl_cast_blocks(ray_tmpl_t const *const tmpl,
+                              uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+                              roi_t const *const roi,
+                              block_map_t const *const map,
+                              point2_t const origin)
+{
+    if (origin.x >= TCO_FRAME_WIDTH || origin.y >= TCO_FRAME_HEIGHT)
+    {
+        return 0;
+    }
+    uint16_t const step_num = ray_tmpl_steps_inside(tmpl, origin);
+    uint8_t const *const start = &(*pixels)[origin.y][origin.x];
+    uint16_t step = 0;
+    while (step < step_num)
+    {
+        uint16_t const x = origin.x + tmpl->x[step];
+        uint16_t const y = origin.y + tmpl->y[step];
+        if (!block_map_occupied(map, 1, x, y))
+        {
+            step += ray_tmpl_block_skip(tmpl, origin, step, step_num, BLOCK_MAP_SHIFT_COARSE);
+        }
+        else if (!block_map_occupied(map, 0, x, y))
+        {
+            step += ray_tmpl_block_skip(tmpl, origin, step, step_num, BLOCK_MAP_SHIFT_FINE);
+        }
+        else if (start[tmpl->offsets[step]] != 255 && (roi == NULL || roi_contains(roi, x, y)))
+        {
+            step++;
+        }
+        else
+        {
+            break;
+        }
+    }
+    /* A ray which reaches the border ends on its last pixel inside, like 'raycast'. */
+    return step < step_num ? step : step_num - 1;
+}
@@ -0,0 +1,75 @@
+#ifndef _RAY_TMPL_H_
+#define _RAY_TMPL_H_
+
+/**
+ * @brief Ray templates hold the pixels a ray in a fixed direction passes, as offsets from its
+ * origin into a frame, so casting it is a loop over a table which stops at the first white pixel
+ * with no line stepping at all. The digital line of a direction repeats itself after every
+ * multiple of the direction, so a single template serves every origin. Templates are built once and
+ * do not change, so planners can share them.
+ */
+
+#include <stdint.h>
+#include "tco_shmem.h"
+#include "tco_linalg.h"
+#include "roi.h"
+#include "block_map.h"
+
+#define RAY_TMPL_CACHE_LINE 64
+#define RAY_TMPL_STEPS_MAX TCO_FRAME_WIDTH /* Every step moves along the longer axis so rays leave the frame within this many. */
+
+typedef struct ray_tmpl
+{
+    _Alignas(RAY_TMPL_CACHE_LINE) int32_t offsets[RAY_TMPL_STEPS_MAX]; /* Of the pixel every step lands on, from the origin. The origin is step 0. */
+    _Alignas(RAY_TMPL_CACHE_LINE) int16_t x[RAY_TMPL_STEPS_MAX];       /* Columns from the origin, to find where the frame border cuts the ray. */
+    _Alignas(RAY_TMPL_CACHE_LINE) int16_t y[RAY_TMPL_STEPS_MAX];       /* Rows from the origin. */
+    vec2_t dir;
+} ray_tmpl_t;
+
+/**
+ * @brief Trace the line of a direction into a template.
+ * @param tmpl
+ * @param dir Direction of the ray. Must not be (0, 0).
+ */
+void ray_tmpl_build(ray_tmpl_t *const tmpl, vec2_t const dir);
+
+/**
+ * @brief Count the steps of a template which lie inside the frame from an origin.
+ * @param tmpl
+ * @param origin Must be inside the frame.
+ * @return Number of steps inside, at least 1.
+ */
+uint16_t ray_tmpl_steps_inside(ray_tmpl_t const *const tmpl, point2_t const origin);
+
+/**
+ * @brief Cast a ray which stops at white along a template. It ends the same way as @c raycast ,
+ * but follows its direction exactly where @c raycast follows the line to the frame border it
+ * rounds the direction to, so lengths of long slanted rays can differ by a pixel or two.
+ * @param tmpl
+ * @param pixels A segmented frame.
+ * @param roi See @c raycast .
+ * @param origin Where the raycast will begin.
+ * @return Length of the ray.
+ */
+uint16_t ray_tmpl_cast(ray_tmpl_t const *const tmpl,
+                       uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+                       roi_t const *const roi,
+                       point2_t const origin);
+
+/**
+ * @brief Cast a ray like @c ray_tmpl_cast , but jump over the blocks of the frame which hold no
+ * white instead of stepping through their pixels. Coarse blocks are checked before fine ones.
+ * @param tmpl
+ * @param pixels A segmented frame.
+ * @param roi See @c raycast .
+ * @param map Occupied blocks of @p pixels , built with the same region of interest.
+ * @param origin Where the raycast will begin.
+ * @return Length of the ray, the same as @c ray_tmpl_cast .
+ */
+uint16_t ray_tmpl_cast_blocks(ray_tmpl_t const *const tmpl,
+                              uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+                              roi_t const *const roi,
+                              block_map_t const *const map,
+                              point2_t const origin);
+
+#endif /* _RAY_TMPL_H_ */
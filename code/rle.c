@@ -0,0 +1,101 @@
+#include <stddef.h>
+
+#include "rle.h"
+
+void rle_encode_rows(rle_t *const rle, mask_t const *const mask, uint16_t const y_start, uint16_t const y_end)
+{
+    for (uint16_t y = y_start; y < y_end; y++)
+    {
+        rle_run_t *const runs = rle->runs[y];
+        uint16_t run_num = 0;
+        uint8_t in_run = 0;
+        uint64_t carry = 0; /* Last pixel of the previous word. */
+        for (uint8_t word_idx = 0; word_idx < MASK_WORDS; word_idx++)
+        {
+            uint64_t const word = mask->rows[y][word_idx];
+            /* Set bits mark pixels which differ from the pixel on their left i.e. where runs start or end. */
+            uint64_t edges = word ^ ((word << 1) | carry);
+            carry = word >> (MASK_WORD_BITS - 1);
+            for (; edges != 0; edges &= edges - 1)
+            {
+                uint16_t const x = word_idx * MASK_WORD_BITS + __builtin_ctzll(edges);
+                if (!in_run)
+                {
+                    runs[run_num].x_start = x;
+                }
+                else
+                {
+                    runs[run_num++].x_end = x;
+                }
+                in_run = !in_run;
+            }
+        }
+        if (in_run)
+        {
+            runs[run_num++].x_end = TCO_FRAME_WIDTH;
+        }
+        rle->run_num[y] = run_num;
+    }
+}
+
+uint16_t rle_run_find(rle_t const *const rle, uint16_t const y, uint16_t const x)
+{
+    rle_run_t const *const runs = rle->runs[y];
+    uint16_t lo = 0;
+    uint16_t hi = rle->run_num[y];
+    while (lo < hi)
+    {
+        uint16_t const mid = lo + (hi - lo) / 2;
+        if (runs[mid].x_end <= x)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+uint16_t rle_next_right(rle_t const *const rle, uint16_t const y, uint16_t const x)
+{
+    uint16_t const run_idx = rle_run_find(rle, y, x);
+    if (run_idx == rle->run_num[y])
+    {
+        return TCO_FRAME_WIDTH;
+    }
+    rle_run_t const run = rle->runs[y][run_idx];
+    return run.x_start > x ? run.x_start : x;
+}
+
+int16_t rle_next_left(rle_t const *const rle, uint16_t const y, uint16_t const x)
+{
+    uint16_t const run_idx = rle_run_find(rle, y, x);
+    if (run_idx < rle->run_num[y] && rle->runs[y][run_idx].x_start <= x)
+    {
+        return x;
+    }
+    return run_idx > 0 ? rle->runs[y][run_idx - 1].x_end - 1 : -1;
+}
+
+uint16_t rle_raycast_row(rle_t const *const rle, roi_t const *const roi, point2_t const start, uint8_t const left_or_right)
+{
+    if (start.x >= TCO_FRAME_WIDTH || start.y >= TCO_FRAME_HEIGHT || (roi != NULL && !roi_contains(roi, start.x, start.y)))
+    {
+        return 0;
+    }
+    /* The ray ends on the white pixel, on the last pixel inside the region or on the frame border,
+    whichever comes first. */
+    if (left_or_right)
+    {
+        int16_t stop = rle_next_left(rle, start.y, start.x);
+        stop = roi != NULL && roi->x_start[start.y] - 1 > stop ? roi->x_start[start.y] - 1 : stop;
+        stop = stop > 0 ? stop : 0;
+        return start.x - stop;
+    }
+    uint16_t stop = rle_next_right(rle, start.y, start.x);
+    stop = roi != NULL && roi->x_end[start.y] < stop ? roi->x_end[start.y] : stop;
+    stop = stop < TCO_FRAME_WIDTH - 1 ? stop : TCO_FRAME_WIDTH - 1;
+    return stop - start.x;
+}
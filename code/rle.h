@@ -0,0 +1,92 @@
+#ifndef _RLE_H_
+#define _RLE_H_
+
+/**
+ * @brief Run-length encoding of the rows of a segmented frame. Every row keeps the runs of white
+ * pixels in order, the black runs being the gaps between them, so the next white pixel left or
+ * right of a column is found by a binary search over the runs of its row rather than by reading
+ * pixels. A row has room for the most runs it can hold, so encoding never runs out of space, and
+ * rows are independent so bands of rows can be encoded in parallel.
+ */
+
+#include <stdint.h>
+#include "tco_shmem.h"
+#include "tco_linalg.h"
+#include "mask.h"
+#include "roi.h"
+
+#define RLE_ROW_RUNS_MAX (TCO_FRAME_WIDTH / 2) /* Every other pixel being white gives the most runs. */
+
+typedef struct rle_run
+{
+    uint16_t x_start; /* Columns in [x_start, x_end) are white. */
+    uint16_t x_end;
+} rle_run_t;
+
+typedef struct rle
+{
+    uint16_t run_num[TCO_FRAME_HEIGHT];
+    rle_run_t runs[TCO_FRAME_HEIGHT][RLE_ROW_RUNS_MAX];
+} rle_t;
+
+/**
+ * @brief Encode a range of rows of a mask.
+ * @param rle Where the runs are written. Other rows are left untouched.
+ * @param mask
+ * @param y_start First row to encode.
+ * @param y_end Row after the last one to encode.
+ */
+void rle_encode_rows(rle_t *const rle, mask_t const *const mask, uint16_t const y_start, uint16_t const y_end);
+
+/**
+ * @brief Find the run of a row which ends after a column, i.e. the run the column lies in or else
+ * the first run to its right.
+ * @param rle
+ * @param y Index of the row.
+ * @param x
+ * @return Index of the run in @c rle->runs[y] or @c rle->run_num[y] if there is none.
+ */
+uint16_t rle_run_find(rle_t const *const rle, uint16_t const y, uint16_t const x);
+
+/**
+ * @brief Find the first white pixel at or to the right of @p x .
+ * @param rle
+ * @param y Row to search in.
+ * @param x Where the search starts.
+ * @return Horizontal coordinate of the white pixel or TCO_FRAME_WIDTH if there is none.
+ */
+uint16_t rle_next_right(rle_t const *const rle, uint16_t const y, uint16_t const x);
+
+/**
+ * @brief Find the first white pixel at or to the left of @p x .
+ * @param rle
+ * @param y Row to search in.
+ * @param x Where the search starts.
+ * @return Horizontal coordinate of the white pixel or -1 if there is none.
+ */
+int16_t rle_next_left(rle_t const *const rle, uint16_t const y, uint16_t const x);
+
+/**
+ * @brief Cast a horizontal ray which stops at white. Returns the same length as @c raycast with a
+ * direction of (1, 0) or (-1, 0) and a callback which stops at white, without tracing the pixels.
+ * @param rle
+ * @param roi See @c raycast .
+ * @param start Where the raycast will begin.
+ * @param left_or_right If 1 the ray goes left, if 0 it goes right.
+ * @return Length of the ray.
+ */
+uint16_t rle_raycast_row(rle_t const *const rle, roi_t const *const roi, point2_t const start, uint8_t const left_or_right);
+
+/**
+ * @brief Read a single pixel.
+ * @param rle
+ * @param x Horizontal coordinate.
+ * @param y Vertical coordinate.
+ * @return 1 if the pixel is white, 0 if not.
+ */
+static inline uint8_t rle_get(rle_t const *const rle, uint16_t const x, uint16_t const y)
+{
+    return rle_next_right(rle, y, x) == x;
+}
+
+#endif /* _RLE_H_ */
@@ -0,0 +1,163 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string.h>
+
+#include "tco_libd.h"
+
+#include "roi.h"
+
+/**
+ * @brief Recompute the row range and pixel count after spans changed.
+ * @param roi
+ */
+static void roi_refresh(roi_t *const roi)
+{
+    roi->y_start = TCO_FRAME_HEIGHT;
+    roi->y_end = 0;
+    roi->pixel_num = 0;
+    for (uint16_t y = 0; y < TCO_FRAME_HEIGHT; y++)
+    {
+        if (roi->x_end[y] > roi->x_start[y])
+        {
+            roi->y_start = y < roi->y_start ? y : roi->y_start;
+            roi->y_end = y + 1;
+            roi->pixel_num += roi->x_end[y] - roi->x_start[y];
+        }
+    }
+    if (roi->y_end == 0)
+    {
+        roi->y_start = 0;
+    }
+}
+
+void roi_clear(roi_t *const roi)
+{
+    memset(roi, 0, sizeof(roi_t));
+}
+
+void roi_set_full(roi_t *const roi)
+{
+    roi_clear(roi);
+    roi_set_trapezoid(roi, 0, TCO_FRAME_HEIGHT, 0, TCO_FRAME_WIDTH, 0, TCO_FRAME_WIDTH);
+}
+
+/**
+ * @brief Write the span of a row without updating the row range and pixel count.
+ * @param roi
+ * @param y Index of the row.
+ * @param x_start First column inside.
+ * @param x_end Column after the last one inside.
+ */
+static void span_write(roi_t *const roi, uint16_t const y, uint16_t const x_start, uint16_t const x_end)
+{
+    roi->x_start[y] = x_start;
+    roi->x_end[y] = x_end;
+    memset(roi->inside.rows[y], 0, sizeof(roi->inside.rows[y]));
+    for (uint16_t x = x_start; x < x_end; x++)
+    {
+        roi->inside.rows[y][x / MASK_WORD_BITS] |= (uint64_t)1 << (x % MASK_WORD_BITS);
+    }
+}
+
+int roi_set_span(roi_t *const roi, uint16_t const y, uint16_t const x_start, uint16_t const x_end)
+{
+    if (y >= TCO_FRAME_HEIGHT || x_start > x_end || x_end > TCO_FRAME_WIDTH)
+    {
+        return -1;
+    }
+    span_write(roi, y, x_start, x_end);
+    roi_refresh(roi);
+    return 0;
+}
+
+int roi_set_trapezoid(roi_t *const roi,
+                      uint16_t const y_start,
+                      uint16_t const y_end,
+                      uint16_t const top_x_start,
+                      uint16_t const top_x_end,
+                      uint16_t const bot_x_start,
+                      uint16_t const bot_x_end)
+{
+    if (y_start >= y_end || y_end > TCO_FRAME_HEIGHT ||
+        top_x_start > top_x_end || top_x_end > TCO_FRAME_WIDTH ||
+        bot_x_start > bot_x_end || bot_x_end > TCO_FRAME_WIDTH)
+    {
+        return -1;
+    }
+    int32_t const row_last = y_end - 1 - y_start;
+    for (uint16_t y = y_start; y < y_end; y++)
+    {
+        int32_t const row = y - y_start;
+        int32_t x_start = top_x_start;
+        int32_t x_end = top_x_end;
+        if (row_last > 0)
+        {
+            /* Round half away from zero to the nearest column. */
+            int32_t const delta_start = (bot_x_start - top_x_start) * row * 2;
+            int32_t const delta_end = (bot_x_end - top_x_end) * row * 2;
+            x_start += (delta_start + (delta_start < 0 ? -row_last : row_last)) / (row_last * 2);
+            x_end += (delta_end + (delta_end < 0 ? -row_last : row_last)) / (row_last * 2);
+        }
+        span_write(roi, y, x_start, x_end);
+    }
+    roi_refresh(roi);
+    return 0;
+}
+
+int roi_load(roi_t *const roi, char const *const path)
+{
+    FILE *const file = fopen(path, "r");
+    if (file == NULL)
+    {
+        log_error("Failed to open region of interest file '%s'", path);
+        return EXIT_FAILURE;
+    }
+
+    roi_clear(roi);
+    char line[128];
+    uint16_t line_idx = 0;
+    int status = EXIT_SUCCESS;
+    while (status == EXIT_SUCCESS && fgets(line, sizeof(line), file) != NULL)
+    {
+        unsigned int v[6];
+        char extra;
+        line_idx++;
+        if (line[0] == '#' || line[strspn(line, " \t\r\n")] == '\0')
+        {
+            continue;
+        }
+        if (sscanf(line, "span %u %u %u %c", &v[0], &v[1], &v[2], &extra) == 3)
+        {
+            if (v[0] >= TCO_FRAME_HEIGHT || v[1] > TCO_FRAME_WIDTH || v[2] > TCO_FRAME_WIDTH ||
+                roi_set_span(roi, v[0], v[1], v[2]) != 0)
+            {
+                log_error("Invalid span on line %u of '%s'", line_idx, path);
+                status = EXIT_FAILURE;
+            }
+        }
+        else if (sscanf(line, "trapezoid %u %u %u %u %u %u %c", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &extra) == 6)
+        {
+            if (v[0] > TCO_FRAME_HEIGHT || v[1] > TCO_FRAME_HEIGHT ||
+                v[2] > TCO_FRAME_WIDTH || v[3] > TCO_FRAME_WIDTH || v[4] > TCO_FRAME_WIDTH || v[5] > TCO_FRAME_WIDTH ||
+                roi_set_trapezoid(roi, v[0], v[1], v[2], v[3], v[4], v[5]) != 0)
+            {
+                log_error("Invalid trapezoid on line %u of '%s'", line_idx, path);
+                status = EXIT_FAILURE;
+            }
+        }
+        else
+        {
+            log_error("Unrecognized line %u of '%s'", line_idx, path);
+            status = EXIT_FAILURE;
+        }
+    }
+    fclose(file);
+
+    if (status == EXIT_SUCCESS && roi->pixel_num == 0)
+    {
+        log_error("Region of interest in '%s' is empty", path);
+        status = EXIT_FAILURE;
+    }
+    return status;
+}
@@ -0,0 +1,89 @@
+#ifndef _ROI_H_
+#define _ROI_H_
+
+/**
+ * @brief Static region of interest. Every row holds a single span of columns which is processed,
+ * e.g. a trapezoid matching the camera's view of the track. Pixels outside the region are never
+ * segmented, denoised or traced and read as black (0) in segmented frames.
+ */
+
+#include <stdint.h>
+#include "tco_shmem.h"
+#include "mask.h"
+
+typedef struct roi
+{
+    uint16_t y_start; /* Rows in [y_start, y_end) have a non-empty span. */
+    uint16_t y_end;
+    uint16_t x_start[TCO_FRAME_HEIGHT]; /* Columns in [x_start, x_end) of a row are inside. */
+    uint16_t x_end[TCO_FRAME_HEIGHT];
+    mask_t inside;      /* Bit-packed copy of the region. */
+    uint32_t pixel_num; /* Number of pixels inside. */
+} roi_t;
+
+/**
+ * @brief Make the region empty.
+ * @param roi
+ */
+void roi_clear(roi_t *const roi);
+
+/**
+ * @brief Make the region cover the whole frame.
+ * @param roi
+ */
+void roi_set_full(roi_t *const roi);
+
+/**
+ * @brief Replace the span of a single row.
+ * @param roi
+ * @param y Index of the row.
+ * @param x_start First column inside.
+ * @param x_end Column after the last one inside. Equal to @p x_start for an empty row.
+ * @return 0 on success and -1 if the span does not fit in the frame.
+ */
+int roi_set_span(roi_t *const roi, uint16_t const y, uint16_t const x_start, uint16_t const x_end);
+
+/**
+ * @brief Replace the spans of a range of rows with a trapezoid whose span is linearly interpolated
+ * between the top and bottom rows.
+ * @param roi
+ * @param y_start First row of the trapezoid.
+ * @param y_end Row after the last row of the trapezoid.
+ * @param top_x_start First column inside on the first row.
+ * @param top_x_end Column after the last one inside on the first row.
+ * @param bot_x_start First column inside on the last row.
+ * @param bot_x_end Column after the last one inside on the last row.
+ * @return 0 on success and -1 if the trapezoid does not fit in the frame.
+ */
+int roi_set_trapezoid(roi_t *const roi,
+                      uint16_t const y_start,
+                      uint16_t const y_end,
+                      uint16_t const top_x_start,
+                      uint16_t const top_x_end,
+                      uint16_t const bot_x_start,
+                      uint16_t const bot_x_end);
+
+/**
+ * @brief Load a region from a text file. The region starts empty and every line of the file adds
+ * to it in order. Empty lines and lines starting with '#' are ignored. Supported lines are:
+ * "span <y> <x_start> <x_end>" and
+ * "trapezoid <y_start> <y_end> <top_x_start> <top_x_end> <bot_x_start> <bot_x_end>".
+ * @param roi Where the region is written.
+ * @param path Path to the file.
+ * @return 0 on success, 1 on failure.
+ */
+int roi_load(roi_t *const roi, char const *const path);
+
+/**
+ * @brief Check if a pixel lies inside the region.
+ * @param roi
+ * @param x
+ * @param y
+ * @return 1 if inside, 0 if not.
+ */
+static inline uint8_t roi_contains(roi_t const *const roi, uint16_t const x, uint16_t const y)
+{
+    return y >= roi->y_start && y < roi->y_end && x >= roi->x_start[y] && x < roi->x_end[y];
+}
+
+#endif /* _ROI_H_ */
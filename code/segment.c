@@ -0,0 +1,303 @@
+#include <stdlib.h>
+
+#include <string.h>
+
+#include "segment.h"
+#include "simd.h"
+
+void segment_delta_row(uint8_t const *const row,
+                       uint8_t const *const row_ahead,
+                       uint8_t *const out,
+                       uint16_t const x_start,
+                       uint16_t const x_end)
+{
+    uint16_t x = x_start;
+
+    /* Every vector is loaded before the matching store and the right neighbours are always ahead of
+    the store so the kernel works in-place. The last few vectors would read past the row end so they
+    are left to the scalar loop below. */
+#if defined(SIMD_NEON)
+    uint8x16_t const threshold = vdupq_n_u8(SEGMENT_DELTA_THRESHOLD);
+    for (; x + SIMD_WIDTH <= x_end && x + SIMD_WIDTH + SEGMENT_LOOK_AHEAD <= TCO_FRAME_WIDTH; x += SIMD_WIDTH)
+    {
+        uint8x16_t const now = vld1q_u8(&row[x]);
+        uint8x16_t edge = vcgtq_u8(vabdq_u8(now, vld1q_u8(&row[x + SEGMENT_LOOK_AHEAD])), threshold);
+        if (row_ahead != NULL)
+        {
+            edge = vorrq_u8(edge, vcgtq_u8(vabdq_u8(now, vld1q_u8(&row_ahead[x])), threshold));
+        }
+        vst1q_u8(&out[x], edge);
+    }
+#elif defined(SIMD_SSE2)
+    /* SSE2 has no unsigned byte compare so "d > threshold" is done as "max(d, threshold + 1) == d". */
+    __m128i const threshold = _mm_set1_epi8(SEGMENT_DELTA_THRESHOLD + 1);
+    for (; x + SIMD_WIDTH <= x_end && x + SIMD_WIDTH + SEGMENT_LOOK_AHEAD <= TCO_FRAME_WIDTH; x += SIMD_WIDTH)
+    {
+        __m128i const now = _mm_loadu_si128((__m128i const *)&row[x]);
+        __m128i const right = _mm_loadu_si128((__m128i const *)&row[x + SEGMENT_LOOK_AHEAD]);
+        __m128i delta = _mm_or_si128(_mm_subs_epu8(now, right), _mm_subs_epu8(right, now));
+        __m128i edge = _mm_cmpeq_epi8(_mm_max_epu8(delta, threshold), delta);
+        if (row_ahead != NULL)
+        {
+            __m128i const below = _mm_loadu_si128((__m128i const *)&row_ahead[x]);
+            delta = _mm_or_si128(_mm_subs_epu8(now, below), _mm_subs_epu8(below, now));
+            edge = _mm_or_si128(edge, _mm_cmpeq_epi8(_mm_max_epu8(delta, threshold), delta));
+        }
+        _mm_storeu_si128((__m128i *)&out[x], edge);
+    }
+#endif
+
+    for (; x < x_end; x++)
+    {
+        uint8_t const now = row[x];
+        uint8_t const edge = (x + SEGMENT_LOOK_AHEAD < TCO_FRAME_WIDTH && abs(now - row[x + SEGMENT_LOOK_AHEAD]) > SEGMENT_DELTA_THRESHOLD) ||
+                             (row_ahead != NULL && abs(now - row_ahead[x]) > SEGMENT_DELTA_THRESHOLD);
+        out[x] = edge ? 255 : 0;
+    }
+}
+
+void segment_delta(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+{
+    for (uint16_t y = 0; y < TCO_FRAME_HEIGHT; y++)
+    {
+        uint8_t const *const row_ahead = y + SEGMENT_LOOK_AHEAD < TCO_FRAME_HEIGHT ? (*pixels)[y + SEGMENT_LOOK_AHEAD] : NULL;
+        segment_delta_row((*pixels)[y], row_ahead, (*pixels)[y], 0, TCO_FRAME_WIDTH);
+    }
+}
+
+void segment_delta_ref(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+{
+    uint8_t const delta_threshold = SEGMENT_DELTA_THRESHOLD;
+    uint8_t const look_ahead_length = SEGMENT_LOOK_AHEAD;
+    for (uint16_t height_idx = 0; height_idx < TCO_FRAME_HEIGHT; height_idx++)
+    {
+        for (uint16_t width_idx = 0; width_idx < TCO_FRAME_WIDTH; width_idx++)
+        {
+            if (width_idx + look_ahead_length < TCO_FRAME_WIDTH &&
+                abs((*pixels)[height_idx][width_idx] - (*pixels)[height_idx][width_idx + look_ahead_length]) > delta_threshold)
+            {
+                (*pixels)[height_idx][width_idx] = 255;
+                continue;
+            }
+
+            if (height_idx + look_ahead_length < TCO_FRAME_HEIGHT &&
+                abs((*pixels)[height_idx][width_idx] - (*pixels)[height_idx + look_ahead_length][width_idx]) > delta_threshold)
+            {
+                (*pixels)[height_idx][width_idx] = 255;
+                continue;
+            }
+
+            (*pixels)[height_idx][width_idx] = 0;
+        }
+    }
+}
+
+void segment_integral_row(uint32_t *const integral, uint32_t const *const integral_above, uint8_t const *const row)
+{
+    uint16_t x = 0;
+    uint32_t sum = 0; /* Prefix sum of the row up to 'x'. */
+    integral[0] = 0;
+
+    /* Each vector gets its prefix sums in 16-bit lanes with log2(8) shifted adds per half, which
+    cannot overflow, and is then widened to 32 bits and offset by the sum of the vectors before it. */
+#if defined(SIMD_NEON)
+    uint16x8_t const zero = vdupq_n_u16(0);
+    uint32x4_t carry = vdupq_n_u32(0);
+    for (; x + SIMD_WIDTH <= TCO_FRAME_WIDTH; x += SIMD_WIDTH)
+    {
+        uint8x16_t const pixels = vld1q_u8(&row[x]);
+        uint16x8_t halves[2] = {vmovl_u8(vget_low_u8(pixels)), vmovl_u8(vget_high_u8(pixels))};
+        for (uint8_t half = 0; half < 2; half++)
+        {
+            halves[half] = vaddq_u16(halves[half], vextq_u16(zero, halves[half], 7));
+            halves[half] = vaddq_u16(halves[half], vextq_u16(zero, halves[half], 6));
+            halves[half] = vaddq_u16(halves[half], vextq_u16(zero, halves[half], 4));
+            uint32x4_t const quarter_lo = vaddq_u32(vmovl_u16(vget_low_u16(halves[half])), carry);
+            uint32x4_t const quarter_hi = vaddq_u32(vmovl_u16(vget_high_u16(halves[half])), carry);
+            carry = vdupq_n_u32(vgetq_lane_u32(quarter_hi, 3));
+            uint32_t *const out = &integral[x + 1 + half * 8];
+            vst1q_u32(out, vaddq_u32(quarter_lo, vld1q_u32(&integral_above[x + 1 + half * 8])));
+            vst1q_u32(out + 4, vaddq_u32(quarter_hi, vld1q_u32(&integral_above[x + 5 + half * 8])));
+        }
+    }
+    sum = vgetq_lane_u32(carry, 0);
+#elif defined(SIMD_SSE2)
+    __m128i const zero = _mm_setzero_si128();
+    __m128i carry = zero;
+    for (; x + SIMD_WIDTH <= TCO_FRAME_WIDTH; x += SIMD_WIDTH)
+    {
+        __m128i const pixels = _mm_loadu_si128((__m128i const *)&row[x]);
+        __m128i halves[2] = {_mm_unpacklo_epi8(pixels, zero), _mm_unpackhi_epi8(pixels, zero)};
+        for (uint8_t half = 0; half < 2; half++)
+        {
+            halves[half] = _mm_add_epi16(halves[half], _mm_slli_si128(halves[half], 2));
+            halves[half] = _mm_add_epi16(halves[half], _mm_slli_si128(halves[half], 4));
+            halves[half] = _mm_add_epi16(halves[half], _mm_slli_si128(halves[half], 8));
+            __m128i const quarter_lo = _mm_add_epi32(_mm_unpacklo_epi16(halves[half], zero), carry);
+            __m128i const quarter_hi = _mm_add_epi32(_mm_unpackhi_epi16(halves[half], zero), carry);
+            carry = _mm_shuffle_epi32(quarter_hi, 0xFF);
+            uint32_t *const out = &integral[x + 1 + half * 8];
+            _mm_storeu_si128((__m128i *)out, _mm_add_epi32(quarter_lo, _mm_loadu_si128((__m128i const *)&integral_above[x + 1 + half * 8])));
+            _mm_storeu_si128((__m128i *)(out + 4), _mm_add_epi32(quarter_hi, _mm_loadu_si128((__m128i const *)&integral_above[x + 5 + half * 8])));
+        }
+    }
+    sum = _mm_cvtsi128_si32(carry);
+#endif
+
+    for (; x < TCO_FRAME_WIDTH; x++)
+    {
+        sum += row[x];
+        integral[x + 1] = integral_above[x + 1] + sum;
+    }
+}
+
+/**
+ * @brief Segment a single pixel with the adaptive threshold.
+ * @param row
+ * @param integral_top
+ * @param integral_bot
+ * @param window_rows
+ * @param x
+ * @return 255 if the pixel is white and 0 if not.
+ */
+static inline uint8_t adaptive_pixel(uint8_t const *const row,
+                                     uint32_t const *const integral_top,
+                                     uint32_t const *const integral_bot,
+                                     uint16_t const window_rows,
+                                     uint16_t const x)
+{
+    uint16_t const x_lo = x < SEGMENT_ADAPTIVE_RADIUS ? 0 : x - SEGMENT_ADAPTIVE_RADIUS;
+    uint16_t const x_hi = x + SEGMENT_ADAPTIVE_RADIUS + 1 > TCO_FRAME_WIDTH ? TCO_FRAME_WIDTH : x + SEGMENT_ADAPTIVE_RADIUS + 1;
+    uint32_t const count = (uint32_t)window_rows * (x_hi - x_lo);
+    uint32_t const sum = integral_bot[x_hi] - integral_bot[x_lo] - integral_top[x_hi] + integral_top[x_lo];
+    /* Compares the pixel with the mean without dividing. */
+    return row[x] * count > sum + SEGMENT_ADAPTIVE_OFFSET * count ? 255 : 0;
+}
+
+void segment_adaptive_row(uint8_t const *const row,
+                          uint32_t const *const integral_top,
+                          uint32_t const *const integral_bot,
+                          uint16_t const window_rows,
+                          uint8_t *const out,
+                          uint16_t const x_start,
+                          uint16_t const x_end)
+{
+    uint16_t x = x_start;
+    for (; x < x_end && x < SEGMENT_ADAPTIVE_RADIUS; x++)
+    {
+        out[x] = adaptive_pixel(row, integral_top, integral_bot, window_rows, x);
+    }
+
+    /* Away from the left and right edges every window has the same width, so the count is the same
+    for the whole vector. Products and sums stay below 2^31 so signed compares work. */
+    uint32_t const count = (uint32_t)window_rows * (2 * SEGMENT_ADAPTIVE_RADIUS + 1);
+#if defined(SIMD_NEON)
+    uint32x4_t const offset = vdupq_n_u32(SEGMENT_ADAPTIVE_OFFSET * count);
+    for (; x + SIMD_WIDTH <= x_end && x + SIMD_WIDTH + SEGMENT_ADAPTIVE_RADIUS <= TCO_FRAME_WIDTH; x += SIMD_WIDTH)
+    {
+        uint8x16_t const pixels = vld1q_u8(&row[x]);
+        uint16x8_t const halves[2] = {vmovl_u8(vget_low_u8(pixels)), vmovl_u8(vget_high_u8(pixels))};
+        uint16x4_t white[4];
+        for (uint8_t quarter = 0; quarter < 4; quarter++)
+        {
+            uint16_t const x_q = x + quarter * 4;
+            uint16x4_t const pixels_q = quarter % 2 == 0 ? vget_low_u16(halves[quarter / 2]) : vget_high_u16(halves[quarter / 2]);
+            uint32x4_t sum = vsubq_u32(vld1q_u32(&integral_bot[x_q + SEGMENT_ADAPTIVE_RADIUS + 1]), vld1q_u32(&integral_bot[x_q - SEGMENT_ADAPTIVE_RADIUS]));
+            sum = vsubq_u32(sum, vld1q_u32(&integral_top[x_q + SEGMENT_ADAPTIVE_RADIUS + 1]));
+            sum = vaddq_u32(sum, vld1q_u32(&integral_top[x_q - SEGMENT_ADAPTIVE_RADIUS]));
+            white[quarter] = vmovn_u32(vcgtq_u32(vmulq_n_u32(vmovl_u16(pixels_q), count), vaddq_u32(sum, offset)));
+        }
+        uint8x8_t const white_lo = vmovn_u16(vcombine_u16(white[0], white[1]));
+        uint8x8_t const white_hi = vmovn_u16(vcombine_u16(white[2], white[3]));
+        vst1q_u8(&out[x], vcombine_u8(white_lo, white_hi));
+    }
+#elif defined(SIMD_SSE2)
+    /* 'madd' multiplies the 16-bit halves of each lane, the upper ones being 0, which gives a 32-bit
+    product that SSE2 has no other instruction for. */
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const count_v = _mm_set1_epi32(count);
+    __m128i const offset = _mm_set1_epi32(SEGMENT_ADAPTIVE_OFFSET * count);
+    for (; x + SIMD_WIDTH <= x_end && x + SIMD_WIDTH + SEGMENT_ADAPTIVE_RADIUS <= TCO_FRAME_WIDTH; x += SIMD_WIDTH)
+    {
+        __m128i const pixels = _mm_loadu_si128((__m128i const *)&row[x]);
+        __m128i const halves[2] = {_mm_unpacklo_epi8(pixels, zero), _mm_unpackhi_epi8(pixels, zero)};
+        __m128i white[4];
+        for (uint8_t quarter = 0; quarter < 4; quarter++)
+        {
+            uint16_t const x_q = x + quarter * 4;
+            __m128i const pixels_q = quarter % 2 == 0 ? _mm_unpacklo_epi16(halves[quarter / 2], zero) : _mm_unpackhi_epi16(halves[quarter / 2], zero);
+            __m128i sum = _mm_sub_epi32(_mm_loadu_si128((__m128i const *)&integral_bot[x_q + SEGMENT_ADAPTIVE_RADIUS + 1]),
+                                        _mm_loadu_si128((__m128i const *)&integral_bot[x_q - SEGMENT_ADAPTIVE_RADIUS]));
+            sum = _mm_sub_epi32(sum, _mm_loadu_si128((__m128i const *)&integral_top[x_q + SEGMENT_ADAPTIVE_RADIUS + 1]));
+            sum = _mm_add_epi32(sum, _mm_loadu_si128((__m128i const *)&integral_top[x_q - SEGMENT_ADAPTIVE_RADIUS]));
+            white[quarter] = _mm_cmpgt_epi32(_mm_madd_epi16(pixels_q, count_v), _mm_add_epi32(sum, offset));
+        }
+        __m128i const white_8 = _mm_packs_epi16(_mm_packs_epi32(white[0], white[1]), _mm_packs_epi32(white[2], white[3]));
+        _mm_storeu_si128((__m128i *)&out[x], white_8);
+    }
+#else
+    (void)count;
+#endif
+
+    for (; x < x_end; x++)
+    {
+        out[x] = adaptive_pixel(row, integral_top, integral_bot, window_rows, x);
+    }
+}
+
+void segment_adaptive(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+{
+    static uint32_t integral[SEGMENT_ADAPTIVE_RING][TCO_FRAME_WIDTH + 1];
+    static uint32_t const integral_zero[TCO_FRAME_WIDTH + 1] = {0};
+    uint16_t y_read = 0; /* Next row to add to the integral image. */
+    for (uint16_t y = 0; y < TCO_FRAME_HEIGHT; y++)
+    {
+        uint16_t const y_bot = y + SEGMENT_ADAPTIVE_RADIUS < TCO_FRAME_HEIGHT ? y + SEGMENT_ADAPTIVE_RADIUS : TCO_FRAME_HEIGHT - 1;
+        for (; y_read <= y_bot; y_read++)
+        {
+            segment_integral_row(integral[y_read % SEGMENT_ADAPTIVE_RING],
+                                 y_read > 0 ? integral[(y_read - 1) % SEGMENT_ADAPTIVE_RING] : integral_zero,
+                                 (*pixels)[y_read]);
+        }
+        /* Rows below 'y' are still grayscale since the window only reaches them through the integral. */
+        uint16_t const y_top = y > SEGMENT_ADAPTIVE_RADIUS ? y - SEGMENT_ADAPTIVE_RADIUS : 0;
+        segment_adaptive_row((*pixels)[y],
+                             y_top > 0 ? integral[(y_top - 1) % SEGMENT_ADAPTIVE_RING] : integral_zero,
+                             integral[y_bot % SEGMENT_ADAPTIVE_RING],
+                             y_bot - y_top + 1,
+                             (*pixels)[y],
+                             0,
+                             TCO_FRAME_WIDTH);
+    }
+}
+
+void segment_adaptive_ref(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+{
+    static uint8_t gray[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH];
+    memcpy(gray, pixels, sizeof(gray));
+    for (int16_t y = 0; y < TCO_FRAME_HEIGHT; y++)
+    {
+        int16_t const y_top = y - SEGMENT_ADAPTIVE_RADIUS < 0 ? 0 : y - SEGMENT_ADAPTIVE_RADIUS;
+        int16_t const y_bot = y + SEGMENT_ADAPTIVE_RADIUS >= TCO_FRAME_HEIGHT ? TCO_FRAME_HEIGHT - 1 : y + SEGMENT_ADAPTIVE_RADIUS;
+        uint32_t column_sums[TCO_FRAME_WIDTH] = {0}; /* Sums of the window rows in every column. */
+        for (int16_t window_y = y_top; window_y <= y_bot; window_y++)
+        {
+            for (int16_t x = 0; x < TCO_FRAME_WIDTH; x++)
+            {
+                column_sums[x] += gray[window_y][x];
+            }
+        }
+        for (int16_t x = 0; x < TCO_FRAME_WIDTH; x++)
+        {
+            int16_t const x_lo = x - SEGMENT_ADAPTIVE_RADIUS < 0 ? 0 : x - SEGMENT_ADAPTIVE_RADIUS;
+            int16_t const x_hi = x + SEGMENT_ADAPTIVE_RADIUS >= TCO_FRAME_WIDTH ? TCO_FRAME_WIDTH - 1 : x + SEGMENT_ADAPTIVE_RADIUS;
+            uint32_t sum = 0;
+            for (int16_t window_x = x_lo; window_x <= x_hi; window_x++)
+            {
+                sum += column_sums[window_x];
+            }
+            uint32_t const count = (uint32_t)(y_bot - y_top + 1) * (x_hi - x_lo + 1);
+            (*pixels)[y][x] = gray[y][x] * count > sum + SEGMENT_ADAPTIVE_OFFSET * count ? 255 : 0;
+        }
+    }
+}
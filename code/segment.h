@@ -0,0 +1,102 @@
+#ifndef _SEGMENT_H_
+#define _SEGMENT_H_
+
+/**
+ * @brief Kernels which turn a grayscale frame into a segmented frame of lines (white (255)) and
+ * not-lines (black (0)).
+ */
+
+#include <stdint.h>
+#include "tco_shmem.h"
+
+#define SEGMENT_LOOK_AHEAD 6      /* Distance in pixels to the right and bottom neighbour that a pixel gets compared with. */
+#define SEGMENT_DELTA_THRESHOLD 60 /* A pixel is white when it differs from a neighbour by more than this. */
+
+#define SEGMENT_ADAPTIVE_RADIUS 10 /* The local mean is taken over a square window of side 2 * radius + 1 around a pixel. */
+#define SEGMENT_ADAPTIVE_OFFSET 24 /* A pixel is white when it is brighter than its local mean by more than this. */
+#define SEGMENT_ADAPTIVE_RING (2 * SEGMENT_ADAPTIVE_RADIUS + 2) /* Integral rows needed to segment a row. */
+
+typedef enum segment_mode
+{
+    SEGMENT_MODE_DELTA = 0, /* Fixed threshold on the difference to the pixels right and below. */
+    SEGMENT_MODE_ADAPTIVE,  /* Threshold at the local mean, taken from an integral image. */
+} segment_mode_t;
+
+/**
+ * @brief Segment a single row using the delta threshold against the pixels @c SEGMENT_LOOK_AHEAD
+ * to the right and @c SEGMENT_LOOK_AHEAD below. Uses NEON or SSE2 when available.
+ * @param row The grayscale row to segment.
+ * @param row_ahead The grayscale row @c SEGMENT_LOOK_AHEAD rows below @p row or NULL if it lies
+ * outside the frame.
+ * @param out Where the segmented row is written. It may point to @p row to segment in-place.
+ * @param x_start First column to segment.
+ * @param x_end Column after the last one to segment. Columns outside [ @p x_start , @p x_end ) of
+ * @p out are left untouched.
+ */
+void segment_delta_row(uint8_t const *const row,
+                       uint8_t const *const row_ahead,
+                       uint8_t *const out,
+                       uint16_t const x_start,
+                       uint16_t const x_end);
+
+/**
+ * @brief Segment a whole frame in-place using the vectorized row kernel.
+ * @param pixels A grayscale frame which gets overwritten with the segmented frame.
+ */
+void segment_delta(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH]);
+
+/**
+ * @brief Scalar reference implementation of @c segment_delta . The vectorized kernels must produce
+ * exactly the same output as this one.
+ * @param pixels A grayscale frame which gets overwritten with the segmented frame.
+ */
+void segment_delta_ref(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH]);
+
+/**
+ * @brief Compute a row of an integral image, i.e. every entry is the sum of the pixels above and to
+ * the left of it, from the row above and the prefix sums of a grayscale row. Uses NEON or SSE2
+ * when available.
+ * @param integral Where the @c TCO_FRAME_WIDTH + 1 entries of the row are written. Entry 'x' sums
+ * the columns before 'x' so entry 0 is always 0.
+ * @param integral_above The integral row above or a row of zeros for the first row.
+ * @param row The grayscale row.
+ */
+void segment_integral_row(uint32_t *const integral, uint32_t const *const integral_above, uint8_t const *const row);
+
+/**
+ * @brief Segment a single row by thresholding every pixel at the mean of the window around it plus
+ * @c SEGMENT_ADAPTIVE_OFFSET . The window sums take 4 lookups into the integral image so the cost
+ * does not depend on @c SEGMENT_ADAPTIVE_RADIUS . Windows get clipped at the frame edges.
+ * @param row The grayscale row to segment.
+ * @param integral_top The integral row just above the window or a row of zeros if the window
+ * starts at the first row the integral image was started from.
+ * @param integral_bot The integral row of the last row of the window.
+ * @param window_rows Number of rows in the window.
+ * @param out Where the segmented row is written. It may point to @p row to segment in-place.
+ * @param x_start First column to segment.
+ * @param x_end Column after the last one to segment. Columns outside [ @p x_start , @p x_end ) of
+ * @p out are left untouched.
+ */
+void segment_adaptive_row(uint8_t const *const row,
+                          uint32_t const *const integral_top,
+                          uint32_t const *const integral_bot,
+                          uint16_t const window_rows,
+                          uint8_t *const out,
+                          uint16_t const x_start,
+                          uint16_t const x_end);
+
+/**
+ * @brief Segment a whole frame in-place with the adaptive threshold. The integral image is kept as
+ * a ring of @c SEGMENT_ADAPTIVE_RING rows.
+ * @param pixels A grayscale frame which gets overwritten with the segmented frame.
+ */
+void segment_adaptive(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH]);
+
+/**
+ * @brief Scalar reference implementation of @c segment_adaptive which sums every window from
+ * column sums instead of an integral image.
+ * @param pixels A grayscale frame which gets overwritten with the segmented frame.
+ */
+void segment_adaptive_ref(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH]);
+
+#endif /* _SEGMENT_H_ */
@@ -0,0 +1,65 @@
+#include <stdlib.h>
+
+#include "subpix.h"
+
+/* Gradients taken around the end of a ray. The peak is searched for in all but the outer two. */
+#define SUBPIX_GRADS (SUBPIX_RADIUS + SUBPIX_AHEAD + 3)
+
+int32_t subpix_ray(ray_tmpl_t const *const tmpl,
+                   uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+                   roi_t const *const roi,
+                   uint8_t (*const gray)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+                   point2_t const origin,
+                   uint16_t const length)
+{
+    int32_t const unrefined = (int32_t)length << SUBPIX_SHIFT;
+    /* Gradient 'grad_idx' lies between steps 'step_first + grad_idx' and the one after. The edge the
+    ray stopped at is the one 'SUBPIX_RADIUS + 1' in. */
+    int16_t const step_first = (int16_t)length - 2 - SUBPIX_RADIUS;
+    int16_t const step_last = step_first + SUBPIX_GRADS;
+    if (step_first < 0 || step_last >= RAY_TMPL_STEPS_MAX || origin.x >= TCO_FRAME_WIDTH || origin.y >= TCO_FRAME_HEIGHT)
+    {
+        return unrefined;
+    }
+    /* Coordinates only ever grow or only ever shrink along a ray, so the last step being inside
+    means all of them are. */
+    int16_t const x_last = origin.x + tmpl->x[step_last];
+    int16_t const y_last = origin.y + tmpl->y[step_last];
+    if (x_last < 0 || x_last >= TCO_FRAME_WIDTH || y_last < 0 || y_last >= TCO_FRAME_HEIGHT)
+    {
+        return unrefined;
+    }
+    /* Rays which ran into the border of the frame or of the region did not stop at an edge. */
+    int16_t const x_stop = origin.x + tmpl->x[length];
+    int16_t const y_stop = origin.y + tmpl->y[length];
+    if ((*pixels)[y_stop][x_stop] != 255 || (roi != NULL && !roi_contains(roi, x_stop, y_stop)))
+    {
+        return unrefined;
+    }
+
+    uint8_t const *const start = &(*gray)[origin.y][origin.x];
+    int16_t grads[SUBPIX_GRADS];
+    for (uint8_t grad_idx = 0; grad_idx < SUBPIX_GRADS; grad_idx++)
+    {
+        /* Lines can be brighter or darker than the floor so only the size of the change counts. */
+        grads[grad_idx] = abs(start[tmpl->offsets[step_first + grad_idx + 1]] - start[tmpl->offsets[step_first + grad_idx]]);
+    }
+
+    /* Closer gradients win ties so a flat peak stays where the ray stopped. */
+    uint8_t const grad_hit = SUBPIX_RADIUS + 1;
+    uint8_t peak = grad_hit;
+    for (uint8_t dist = 1; dist <= SUBPIX_AHEAD; dist++)
+    {
+        peak = dist <= SUBPIX_RADIUS && grads[grad_hit - dist] > grads[peak] ? grad_hit - dist : peak;
+        peak = grads[grad_hit + dist] > grads[peak] ? grad_hit + dist : peak;
+    }
+    if (grads[peak] == 0)
+    {
+        return unrefined;
+    }
+
+    /* Vertex of the parabola through the peak and its neighbours, at most half a pixel away. */
+    int32_t const curvature = grads[peak - 1] - 2 * grads[peak] + grads[peak + 1];
+    int32_t const offset = curvature < 0 ? ((grads[peak - 1] - grads[peak + 1]) * SUBPIX_ONE) / (2 * curvature) : 0;
+    return ((int32_t)(step_first + peak + 1) << SUBPIX_SHIFT) + offset;
+}
@@ -0,0 +1,49 @@
+#ifndef _SUBPIX_H_
+#define _SUBPIX_H_
+
+/**
+ * @brief Sub-pixel localization of the edges rays stop at. A ray cast on a segmented frame ends on
+ * a whole pixel, so its length jumps a pixel at a time as an edge moves. The grayscale frame the
+ * segmentation came from changes smoothly though, so the edge is placed where the gradient along
+ * the ray peaks, found by fitting a parabola to the gradient around the pixel the ray stopped on.
+ * The delta threshold marks pixels white up to @c SEGMENT_LOOK_AHEAD before the change they compare
+ * across, so rays moving right or down stop that far short of the edge and the peak is looked for
+ * that far past the end of the ray too, and one step more since blur spreads the change. Positions
+ * are fixed-point and only a few pixels are read per edge.
+ */
+
+#include <stdint.h>
+#include "tco_shmem.h"
+#include "tco_linalg.h"
+#include "ray_tmpl.h"
+#include "roi.h"
+#include "segment.h"
+
+#define SUBPIX_SHIFT 8                  /* Fractional bits of the fixed-point lengths. */
+#define SUBPIX_ONE (1 << SUBPIX_SHIFT) /* A length of one pixel. */
+#define SUBPIX_RADIUS 2                 /* Steps before the end of a ray the gradient peak is looked for in. */
+#define SUBPIX_AHEAD (SEGMENT_LOOK_AHEAD + 1) /* Steps past the end of a ray the gradient peak is looked for in. At least 'SUBPIX_RADIUS'. */
+
+/**
+ * @brief Refine the length of a ray which stopped at white on the segmented copy of a frame.
+ * @param tmpl Template of the ray's direction. The steps it holds are the pixels the gradient is
+ * taken along.
+ * @param pixels The segmented frame the ray was cast on.
+ * @param roi Region of interest the ray was cast with, see @c raycast .
+ * @param gray The grayscale frame before it was segmented.
+ * @param origin Where the ray begins.
+ * @param length Length of the ray on the segmented frame. The edge is taken to lie between the
+ * last pixel of the ray and the one after it, or up to @c SUBPIX_AHEAD steps past them.
+ * @return Length in 1 / @c SUBPIX_ONE pixels, with @p length being the boundary between the two
+ * pixels of the edge. It is @p length shifted up if the ray was stopped by the frame border or the
+ * region of interest instead of white, if the pixels around the end of the ray do not all lie inside
+ * the frame or if their gradient has no peak.
+ */
+int32_t subpix_ray(ray_tmpl_t const *const tmpl,
+                   uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+                   roi_t const *const roi,
+                   uint8_t (*const gray)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+                   point2_t const origin,
+                   uint16_t const length);
+
+#endif /* _SUBPIX_H_ */
@@ -0,0 +1,142 @@
+#include <string.h>
+
+#include "tracker.h"
+
+float tracker_ab_correct(tracker_ab_t *const ab, float const measured)
+{
+    if (!ab->valid)
+    {
+        ab->pos = measured;
+        ab->vel = 0.0f;
+        ab->valid = 1;
+        ab->miss_num = 0;
+        return ab->pos;
+    }
+    float const predicted = tracker_ab_predict(ab);
+    float const residual = measured - predicted;
+    ab->pos = predicted + TRACKER_ALPHA * residual;
+    ab->vel += TRACKER_BETA * residual;
+    ab->miss_num = 0;
+    return ab->pos;
+}
+
+void tracker_ab_coast(tracker_ab_t *const ab, uint8_t const miss_max)
+{
+    ab->pos = tracker_ab_predict(ab);
+    ab->miss_num++;
+    if (ab->miss_num > miss_max)
+    {
+        ab->valid = 0;
+    }
+}
+
+void tracker_init(tracker_t *const tracker, uint16_t const *const rows, uint8_t const row_num)
+{
+    memset(tracker, 0, sizeof(tracker_t));
+    tracker->row_num = row_num < TRACKER_ROWS_MAX ? row_num : TRACKER_ROWS_MAX;
+    memcpy(tracker->rows, rows, tracker->row_num * sizeof(tracker->rows[0]));
+}
+
+/**
+ * @brief Look for the left edge of a row only in a window around its prediction.
+ * @param rle
+ * @param y Index of the row.
+ * @param predicted Predicted column of the edge.
+ * @param center Column of the track center. The window does not reach past it.
+ * @param edge Where the edge is written when found. -1 if there is no white up to the frame border.
+ * @return 1 if the edge was in the window, 0 if not.
+ */
+static uint8_t tracker_window_left(rle_t const *const rle, uint16_t const y, int16_t const predicted, int16_t const center, int16_t *const edge)
+{
+    int16_t inner = predicted + TRACKER_WINDOW < center ? predicted + TRACKER_WINDOW : center;
+    inner = inner < TCO_FRAME_WIDTH - 1 ? inner : TCO_FRAME_WIDTH - 1;
+    if (inner < 0)
+    {
+        return 0;
+    }
+    *edge = rle_next_left(rle, y, inner);
+    return *edge >= predicted - TRACKER_WINDOW;
+}
+
+/**
+ * @brief Look for the right edge of a row only in a window around its prediction.
+ * @param rle
+ * @param y Index of the row.
+ * @param predicted Predicted column of the edge.
+ * @param center Column of the track center. The window does not reach past it.
+ * @param edge Where the edge is written when found. @c TCO_FRAME_WIDTH if there is no white up to
+ * the frame border.
+ * @return 1 if the edge was in the window, 0 if not.
+ */
+static uint8_t tracker_window_right(rle_t const *const rle, uint16_t const y, int16_t const predicted, int16_t const center, int16_t *const edge)
+{
+    int16_t inner = predicted - TRACKER_WINDOW > center ? predicted - TRACKER_WINDOW : center;
+    inner = inner > 0 ? inner : 0;
+    if (inner >= TCO_FRAME_WIDTH)
+    {
+        return 0;
+    }
+    *edge = rle_next_right(rle, y, inner);
+    return *edge <= predicted + TRACKER_WINDOW;
+}
+
+void tracker_step(tracker_t *const tracker, rle_t const *const rle)
+{
+    /* Where edges which are lost get scanned for from. The row below is the best guess. */
+    int16_t center_below = TCO_FRAME_WIDTH / 2;
+    for (uint8_t row_idx = 0; row_idx < tracker->row_num; row_idx++)
+    {
+        uint16_t const y = tracker->rows[row_idx];
+        tracker_ab_t *const left = &tracker->left[row_idx];
+        tracker_ab_t *const right = &tracker->right[row_idx];
+        int16_t const left_predicted = tracker_ab_predict(left) + 0.5f;
+        int16_t const right_predicted = tracker_ab_predict(right) + 0.5f;
+        int16_t const center = left->valid && right->valid ? (left_predicted + right_predicted) / 2 : center_below;
+
+        int16_t left_x, right_x;
+        if (left->valid)
+        {
+            tracker->window_num++;
+            if (tracker_window_left(rle, y, left_predicted, center, &left_x))
+            {
+                tracker_ab_correct(left, left_x);
+            }
+            else
+            {
+                tracker_ab_coast(left, TRACKER_MISS_MAX);
+            }
+        }
+        else
+        {
+            tracker->scan_num++;
+            tracker_ab_correct(left, rle_next_left(rle, y, center > 0 ? center - 1 : 0));
+        }
+        if (right->valid)
+        {
+            tracker->window_num++;
+            if (tracker_window_right(rle, y, right_predicted, center, &right_x))
+            {
+                tracker_ab_correct(right, right_x);
+            }
+            else
+            {
+                tracker_ab_coast(right, TRACKER_MISS_MAX);
+            }
+        }
+        else
+        {
+            tracker->scan_num++;
+            tracker_ab_correct(right, rle_next_right(rle, y, center));
+        }
+        center_below = tracker_center(tracker, row_idx).x;
+    }
+}
+
+point2_t tracker_center(tracker_t const *const tracker, uint8_t const row_idx)
+{
+    float left = tracker->left[row_idx].valid ? tracker->left[row_idx].pos : 0.0f;
+    float right = tracker->right[row_idx].valid ? tracker->right[row_idx].pos : TCO_FRAME_WIDTH - 1;
+    left = left > 0.0f ? left : 0.0f;
+    right = right < TCO_FRAME_WIDTH - 1 ? right : TCO_FRAME_WIDTH - 1;
+    return (point2_t){(left + right) / 2 + 0.5f, tracker->rows[row_idx]};
+}
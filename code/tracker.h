@@ -0,0 +1,94 @@
+#ifndef _TRACKER_H_
+#define _TRACKER_H_
+
+/**
+ * @brief Follows the edges of the track on a set of rows from frame to frame. Every edge has an
+ * alpha-beta filter which predicts where it lies in the next frame from its position and velocity,
+ * so it only has to be searched for in a window around the prediction. Edges which miss their
+ * window for a few frames in a row are found again by scanning out from the center of the track.
+ * The left edge of a row is the first white pixel left of the track center and the right one the
+ * first white pixel right of it, as found by @c rle_next_left and @c rle_next_right .
+ */
+
+#include <stdint.h>
+#include "tco_shmem.h"
+#include "tco_linalg.h"
+#include "rle.h"
+
+#define TRACKER_ROWS_MAX 32
+#define TRACKER_WINDOW 16    /* Pixels either side of a prediction an edge is searched in. */
+#define TRACKER_MISS_MAX 3   /* Frames an edge may miss its window before it is scanned for again. */
+#define TRACKER_ALPHA 0.5f   /* How much of the difference to a measurement goes into the position. */
+#define TRACKER_BETA 0.1f    /* How much of it goes into the velocity, per frame. */
+
+/* Alpha-beta filter of a value which changes at a roughly constant rate from frame to frame. */
+typedef struct tracker_ab
+{
+    float pos;
+    float vel;           /* Change of the position per frame. */
+    uint8_t valid;       /* Cleared until the first measurement and when the value is lost. */
+    uint8_t miss_num;    /* Frames in a row without a measurement. */
+} tracker_ab_t;
+
+typedef struct tracker
+{
+    uint16_t rows[TRACKER_ROWS_MAX]; /* Indices of the rows tracked, from the bottom up. */
+    uint8_t row_num;
+    tracker_ab_t left[TRACKER_ROWS_MAX];
+    tracker_ab_t right[TRACKER_ROWS_MAX];
+    uint32_t window_num; /* Searches done in a window since the counters were last cleared. */
+    uint32_t scan_num;   /* Searches done by scanning out from the track center. */
+} tracker_t;
+
+/**
+ * @brief Predict the value in the next frame.
+ * @param ab
+ * @return Predicted value.
+ */
+static inline float tracker_ab_predict(tracker_ab_t const *const ab)
+{
+    return ab->pos + ab->vel;
+}
+
+/**
+ * @brief Step the filter to the next frame and correct its prediction with a measurement. The
+ * first measurement after the filter was cleared is taken as is.
+ * @param ab
+ * @param measured
+ * @return The filtered value.
+ */
+float tracker_ab_correct(tracker_ab_t *const ab, float const measured);
+
+/**
+ * @brief Step the filter to the next frame without a measurement, going by its prediction.
+ * @param ab
+ * @param miss_max Once the filter went without a measurement for more than this many frames in a
+ * row, it gets cleared.
+ */
+void tracker_ab_coast(tracker_ab_t *const ab, uint8_t const miss_max);
+
+/**
+ * @brief Set up the rows to track, with no edges found yet.
+ * @param tracker
+ * @param rows Indices of the rows, from the bottom of the frame up. At most @c TRACKER_ROWS_MAX
+ * get used.
+ * @param row_num
+ */
+void tracker_init(tracker_t *const tracker, uint16_t const *const rows, uint8_t const row_num);
+
+/**
+ * @brief Find the edges on every tracked row of a frame and update their filters.
+ * @param tracker
+ * @param rle Runs of a segmented frame.
+ */
+void tracker_step(tracker_t *const tracker, rle_t const *const rle);
+
+/**
+ * @brief Get the filtered center of the track on a tracked row.
+ * @param tracker
+ * @param row_idx Index into the rows given to @c tracker_init .
+ * @return Center, between the frame borders where an edge was not found.
+ */
+point2_t tracker_center(tracker_t const *const tracker, uint8_t const row_idx);
+
+#endif /* _TRACKER_H_ */
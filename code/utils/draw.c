@@ -4,6 +4,8 @@
 #include "draw.h"
 #include "tco_libd.h"
 
+#ifndef DRAW_DISABLED
+
 static uint8_t (*target_frame)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH];
 
 /* Types used in the draw queue. */
@@ -311,3 +313,5 @@ void draw_run(uint8_t (*const frame)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
     }
     queue_idx_number = 0;
 }
+
+#endif /* DRAW_DISABLED */
@@ -1,10 +1,46 @@
 #ifndef _DRAW_H_
-#define _DRAW _H_
+#define _DRAW_H_
 
 #include <stdint.h>
 #include "tco_shmem.h"
 #include "tco_linalg.h"
 
+/* Building with DRAW_DISABLED defined leaves out all drawing. The functions below become empty and
+'draw_enabled' a constant 0, so code which only draws is removed from the production binary
+without having to be wrapped in checks. */
+#ifdef DRAW_DISABLED
+
+#define draw_enabled 0
+
+static inline void draw_run(uint8_t (*const frame)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH])
+{
+    (void)frame;
+}
+static inline void draw_q_line_horiz(uint16_t const row_idx, uint8_t const color)
+{
+    (void)row_idx;
+    (void)color;
+}
+static inline void draw_q_square(point2_t const center, uint8_t const size, uint8_t const color)
+{
+    (void)center;
+    (void)size;
+    (void)color;
+}
+static inline void draw_q_number(uint16_t const number, point2_t const start, uint8_t const scale)
+{
+    (void)number;
+    (void)start;
+    (void)scale;
+}
+static inline void draw_q_pixel(point2_t const pos, uint8_t const color)
+{
+    (void)pos;
+    (void)color;
+}
+
+#else
+
 extern int draw_enabled;
 
 /**
@@ -43,4 +79,6 @@ void draw_q_number(uint16_t const number, point2_t const start, uint8_t const sc
  */
 void draw_q_pixel(point2_t const pos, uint8_t const color);
 
+#endif /* DRAW_DISABLED */
+
 #endif /* _DRAW_H_ */
\ No newline at end of file
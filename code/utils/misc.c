@@ -2,13 +2,24 @@
 #include <math.h>
 
 #include "misc.h"
-#include "buf_circ.h"
 #include "draw.h"
 
-uint16_t bresenham(uint8_t (*pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
-                   callback_func_t const pixel_action,
-                   point2_t const start,
-                   point2_t const end)
+/**
+ * @brief Bresenham which additionally stops before the first traced pixel outside a region of
+ * interest, as if it were the end of the line. It is always inlined, so where @p pixel_action and
+ * @p roi are constants the compiler inlines the action into the loop and drops the checks for NULL.
+ * @param pixels A segmented frame.
+ * @param roi Region the line has to stay inside. If NULL, the line is not clipped.
+ * @param pixel_action See @c bresenham .
+ * @param start Where the line should start.
+ * @param end Where the line should end.
+ * @return Length of the line.
+ */
+static inline __attribute__((always_inline)) uint16_t bresenham_clip(uint8_t (*pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+                               roi_t const *const roi,
+                               callback_func_t const pixel_action,
+                               point2_t const start,
+                               point2_t const end)
 {
     if (start.x >= TCO_FRAME_WIDTH || end.x >= TCO_FRAME_WIDTH || start.y >= TCO_FRAME_HEIGHT || end.y >= TCO_FRAME_HEIGHT)
     {
@@ -26,6 +37,10 @@ uint16_t bresenham(uint8_t (*pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
 
     for (;;)
     {
+        if (roi != NULL && !roi_contains(roi, x, y))
+        {
+            break;
+        }
         if (pixel_action != NULL && pixel_action(pixels, (point2_t){x, y}) != 0)
         {
             break;
@@ -50,99 +65,15 @@ uint16_t bresenham(uint8_t (*pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
     return length;
 }
 
-point2_t radial_sweep(
-    uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
-    vec2_t *const circ_data,
-    uint16_t const circ_data_len,
-    point2_t const start,
-    uint16_t const contour_length,
-    uint8_t const cw_or_ccw,
-    float const radial_start,
-    float const radial_len_max,
-    uint8_t *const status)
+uint16_t bresenham(uint8_t (*pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+                   callback_func_t const pixel_action,
+                   point2_t const start,
+                   point2_t const end)
 {
-    static uint16_t const trace_margin = 10;
-
-    uint16_t const circ_size = circ_data_len;
-    uint16_t const radial_count_max = radial_len_max * circ_size;
-    uint16_t const quarter_size = circ_size / 4;
-    uint16_t const circ_idx_90deg = quarter_size + quarter_size + quarter_size;
-    uint16_t const circ_idx_270deg = quarter_size;
-
-    buf_circ_t circ_buf = {(void *)circ_data, circ_size, circ_size - 1, sizeof(vec2_t)};
-    uint16_t circ_idx = radial_start * circ_size;
-    // draw_q_square((point2_t){start.x + circ_data[circ_idx].x, start.y + circ_data[circ_idx].y}, 4, 150);
-    point2_t trace_last = start;
-
-    for (uint16_t contour_length_now = 0; contour_length_now < contour_length; contour_length_now++)
-    {
-        for (uint16_t swept_pts = 0; swept_pts < circ_size - 1; swept_pts++)
-        {
-            vec2_t const circ_vec = *((vec2_t *)buf_circ_get(&circ_buf, circ_idx));
-            point2_t const trace_target = {trace_last.x + circ_vec.x, trace_last.y + circ_vec.y};
-
-            /* Outside bounds. Also stop if the traced radial length is too long. */
-            if (trace_target.y >= TCO_FRAME_HEIGHT - trace_margin ||
-                trace_last.x >= TCO_FRAME_WIDTH - trace_margin ||
-                trace_last.x <= trace_margin ||
-                trace_target.y <= trace_margin ||
-                swept_pts >= radial_count_max)
-            {
-                if (swept_pts >= radial_count_max)
-                {
-                    *status = 3;
-                }
-                else
-                {
-                    *status = 2;
-                }
-                return trace_last;
-            }
-            // draw_q_pixel(trace_target, 120);
-
-            /* End current sweep when a white point is found and move onto the next one. */
-            if ((*pixels)[trace_target.y][trace_target.x] > 0)
-            {
-                trace_last = trace_target;
-                /* Sweep from a normal to the current point. */
-                if (cw_or_ccw)
-                {
-                    circ_idx = circ_idx + circ_idx_90deg;
-                }
-                else
-                {
-                    circ_idx = circ_idx + circ_idx_270deg;
-                }
-                break;
-            }
-
-            /* Go to next circle point. */
-            if (cw_or_ccw)
-            {
-                circ_idx += 1;
-            }
-            else
-            {
-                circ_idx += circ_size - 1; /* "buf_circ_get" will wrap-around automatically. */
-            }
-
-            /* If swept through whole circle (excluding starting pos) without a trace, just end
-            prematurely.  */
-            if (swept_pts >= circ_size - 1)
-            {
-                *status = 1;
-                return trace_last;
-            }
-        }
-    }
-    *status = 0;
-    return trace_last;
+    return bresenham_clip(pixels, NULL, pixel_action, start, end);
 }
 
-uint16_t raycast(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
-                 point2_t const start,
-                 vec2_t const dir,
-                 callback_func_t const callback)
+point2_t raycast_end(point2_t const start, vec2_t const dir)
 {
     /* How much to stretch the direction vector so it touches the frame border. */
     float const edge_stretch_x = dir.x < 0 ? start.x / fabs((float)dir.x) : (TCO_FRAME_WIDTH - 1 - start.x) / fabs((float)dir.x);
@@ -152,12 +83,21 @@ uint16_t raycast(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
     /* A direction vector which when added to start goes to the border of the frame while keeping
     angle. */
     vec2_t const dir_stretched = {dir.x * edge_stretch, dir.y * edge_stretch};
-    point2_t const end = {start.x + dir_stretched.x, start.y + dir_stretched.y};
+    return (point2_t){start.x + dir_stretched.x, start.y + dir_stretched.y};
+}
 
-    return bresenham(pixels, callback, (point2_t){start.x, start.y}, end);
+uint16_t raycast(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+                 roi_t const *const roi,
+                 point2_t const start,
+                 vec2_t const dir,
+                 callback_func_t const callback)
+{
+    return bresenham_clip(pixels, roi, callback, (point2_t){start.x, start.y}, raycast_end(start, dir));
 }
 
-uint8_t cb_draw_light_stop_white(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t const point)
+/* What the callbacks do for every pixel. These are what the specialized variants of 'bresenham' and
+'raycast' inline. */
+static inline uint8_t action_draw_light_stop_white(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t const point)
 {
     if ((*pixels)[point.y][point.x] != 255)
     {
@@ -167,19 +107,19 @@ uint8_t cb_draw_light_stop_white(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_F
     return -1;
 }
 
-uint8_t cb_draw_light_stop_no(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t const point)
+static inline uint8_t action_draw_light_stop_no(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t const point)
 {
     draw_q_pixel(point, 120);
     return 0;
 }
 
-uint8_t cb_draw_perm_stop_no(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t const point)
+static inline uint8_t action_draw_perm_stop_no(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t const point)
 {
     (*pixels)[point.y][point.x] = 255;
     return 0;
 }
 
-uint8_t cb_draw_no_stop_white(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t const point)
+static inline uint8_t action_draw_no_stop_white(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t const point)
 {
     if ((*pixels)[point.y][point.x] != 255)
     {
@@ -188,28 +128,54 @@ uint8_t cb_draw_no_stop_white(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAM
     return -1;
 }
 
-point2_t track_center(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], uint16_t const bottom_row_idx)
+/* Defines the callback and its variants of 'bresenham' and 'raycast'. The raycast checks for a
+region of interest once so rays without one get a loop with no region check in it at all. */
+#define MISC_CALLBACK_DEFINE(name)                                                                                                                      \
+    uint8_t cb_##name(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t const point)                                                 \
+    {                                                                                                                                                   \
+        return action_##name(pixels, point);                                                                                                            \
+    }                                                                                                                                                   \
+    uint16_t bresenham_##name(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t const start, point2_t const end)                     \
+    {                                                                                                                                                   \
+        return bresenham_clip(pixels, NULL, &action_##name, start, end);                                                                                \
+    }                                                                                                                                                   \
+    uint16_t raycast_##name(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], roi_t const *const roi, point2_t const start, vec2_t const dir) \
+    {                                                                                                                                                   \
+        point2_t const end = raycast_end(start, dir);                                                                                                   \
+        if (roi == NULL)                                                                                                                                \
+        {                                                                                                                                               \
+            return bresenham_clip(pixels, NULL, &action_##name, start, end);                                                                            \
+        }                                                                                                                                               \
+        return bresenham_clip(pixels, roi, &action_##name, start, end);                                                                                 \
+    }
+
+MISC_CALLBACKS(MISC_CALLBACK_DEFINE)
+
+point2_t track_center(rle_t const *const rle, uint16_t const bottom_row_idx, uint16_t const search_x)
 {
-    uint16_t left_edge = TCO_FRAME_WIDTH/2-1, right_edge = TCO_FRAME_WIDTH/2;
-    uint8_t left_edge_found = 0, right_edge_found = 0;
-    for (uint16_t x = 0; x < TCO_FRAME_WIDTH/2 && !(right_edge_found && left_edge_found); x++) {
-        if (!left_edge_found && (*pixels)[bottom_row_idx][left_edge--] == 255) {
-            left_edge_found = 1;
-        }
-        if (!right_edge_found && (*pixels)[bottom_row_idx][right_edge++] == 255) {
-            right_edge_found = 1;
-        }
+    int16_t left_edge = search_x > 0 ? rle_next_left(rle, bottom_row_idx, search_x - 1) : -1;
+    uint16_t right_edge = rle_next_right(rle, bottom_row_idx, search_x);
+    /* Edges are the white pixels themselves, where the old byte scan stopped one past each of
+    them. A missing edge is therefore clamped to the first and last column, not to -1 and
+    'TCO_FRAME_WIDTH' as before, which keeps every midpoint where it was. */
+    if (left_edge < 0)
+    {
+        left_edge = 0;
+    }
+    if (right_edge >= TCO_FRAME_WIDTH)
+    {
+        right_edge = TCO_FRAME_WIDTH - 1;
     }
 
-    point2_t const center = {(right_edge + left_edge)/2, bottom_row_idx}; /* Midpoint is the avg of the 2 values */
+    point2_t const center = {(right_edge + left_edge) / 2, bottom_row_idx}; /* Midpoint is the avg of the 2 values */
     return center;
 }
 
-point2_t track_center_black(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], uint16_t const bottom_row_idx)
+point2_t track_center_black(rle_t const *const rle, uint16_t const bottom_row_idx, uint16_t const search_x)
 {
-    point2_t const center = track_center(pixels, bottom_row_idx);
+    point2_t const center = track_center(rle, bottom_row_idx, search_x);
     point2_t center_black = center;
-    while (center_black.y - 1 > 0 && (*pixels)[center_black.y][center_black.x] != 0)
+    while (center_black.y - 1 > 0 && rle_get(rle, center_black.x, center_black.y))
     {
         center_black.y--;
     }
@@ -8,8 +8,12 @@
 #include <stdint.h>
 #include "tco_shmem.h"
 #include "tco_linalg.h"
+#include "mask.h"
+#include "roi.h"
+#include "rle.h"
 
 typedef uint8_t (*callback_func_t)(uint8_t (*const)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t const);
+typedef uint16_t (*raycast_func_t)(uint8_t (*const)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], roi_t const *const, point2_t const, vec2_t const);
 
 /**
  * @brief General purpose bresenham implementation. It takes in a callback which gets called for
@@ -29,95 +33,79 @@ uint16_t bresenham(uint8_t (*pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
                    point2_t const end);
 
 /**
- * @brief Perform a fast but rough radial sweep contour trace. It will trace at most @p
- * contour_length pixels and will travel in @p cw_or_ccw (clockwise or counter-clockwise) direction.
- * @param pixels A segmented frame.
- * @param circ_data List of arrays that indicate an offset from the origin at (0,0) to each point on
- * a circle.
- * @param circ_data_len Number of points on the circle.
- * @param start Where the the tracing should start from. It can be on black or white.
- * @param contour_length Max number of traced pixels.
- * @param cw_or_ccw Begin tracing clockwise or counter-clockwise.
- * @param radial_start Where the tracing will begin on the circle. 0=up, 0.25=right, 0.5=down,
- * 0.75=left
- * @param radial_len_max Fraction of points on the circle that can be swept when looking for the
- * next point. If a sweep goes beyong this fraction, it stops
- * @param status Set to 0 if nothing is abnormal, 1 if stopped because swept whole circle without a
- * trace, 2 if stopped when hitting frame bounds, 3 if stopped due to radial len max.
- * @return Last point traced.
+ * @brief Find the last pixel of a ray before the frame border, which is where @c raycast ends when
+ * nothing stops it sooner.
+ * @param start Where the raycast will begin.
+ * @param dir In what direction the ray will be cast.
+ * @return End of the ray.
  */
-point2_t radial_sweep(
-    uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
-    vec2_t *const circ_data,
-    uint16_t const circ_data_len,
-    point2_t const start,
-    uint16_t const contour_length,
-    uint8_t const cw_or_ccw,
-    float const radial_start,
-    float const radial_len_max,
-    uint8_t *const status);
+point2_t raycast_end(point2_t const start, vec2_t const dir);
 
 /**
  * @brief Start a raycast from a @p start position in the direction of @p dir .
  * @param pixels Frame where the raycast will be shot. It needs to be a segmented frame.
+ * @param roi Region of interest. The ray ends before the first pixel outside it, the same way it
+ * ends at the frame border. If NULL, only the frame border ends the ray.
  * @param start Where the raycast will begin.
  * @param dir In what direction the ray will be cast.
  * @param callback The function that will get called for every pixel of the cast ray.
  * @return Length of the ray.
  */
 uint16_t raycast(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],
+                 roi_t const *const roi,
                  point2_t const start,
                  vec2_t const dir,
                  callback_func_t const callback);
 
 /**
- * @brief A callback that draws a 'light' colored pixel and stops at white.
- * @param pixels A segmented frame.
- * @param point Last point of the raycast.
- * @return 0 if cast should continue and -1 if cast should stop.
- */
-uint8_t cb_draw_light_stop_white(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t const point);
-
-/**
- * @brief A callback that draws a 'light' colored pixel and does not stop at anything.
- * @param pixels A segmented frame.
- * @param point Last point of the raycast.
- * @return 0 if cast should continue and -1 if cast should stop.
+ * @brief Names of the callbacks below. Every callback 'cb_<name>' comes with the variants
+ * 'bresenham_<name>' and 'raycast_<name>' of @c bresenham and @c raycast , which take the same
+ * arguments without the callback and give the same result. The callback is inlined into them, so
+ * they trace without a function call per pixel. The variants with a callback are there for new
+ * callbacks.
  */
-uint8_t cb_draw_light_stop_no(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t const point);
+#define MISC_CALLBACKS(X)    \
+    X(draw_light_stop_white) \
+    X(draw_light_stop_no)    \
+    X(draw_perm_stop_no)     \
+    X(draw_no_stop_white)
 
-/**
- * @brief A callback that draws a white pixel on the frame such that it affect further computation
- * and does not stop at anything.
- * @param pixels A segmented frame.
- * @param point Last point of the raycast.
- * @return 0 if cast should continue and -1 if cast should stop.
- */
-uint8_t cb_draw_perm_stop_no(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t const point);
+#define MISC_CALLBACK_DECLARE(name)                                                                      \
+    uint8_t cb_##name(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t const point); \
+    uint16_t bresenham_##name(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],                \
+                              point2_t const start,                                                      \
+                              point2_t const end);                                                       \
+    uint16_t raycast_##name(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH],                  \
+                            roi_t const *const roi,                                                      \
+                            point2_t const start,                                                        \
+                            vec2_t const dir);
 
-/**
- * @brief A callback that stops at white and does nothing else.
- * @param pixels A segmented frame.
- * @param point Last point of the raycast.
- * @return 0 if cast should continue and -1 if cast should stop.
- */
-uint8_t cb_draw_no_stop_white(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], point2_t const point);
+/* The callbacks, each with the pixel given and the return value as described for @c bresenham :
+'cb_draw_light_stop_white' draws a 'light' colored pixel and stops at white.
+'cb_draw_light_stop_no' draws a 'light' colored pixel and does not stop at anything.
+'cb_draw_perm_stop_no' draws a white pixel on the frame such that it affect further computation and
+does not stop at anything.
+'cb_draw_no_stop_white' stops at white and does nothing else. */
+MISC_CALLBACKS(MISC_CALLBACK_DECLARE)
 
 /**
  * @brief Find the track center in the provided frame.
- * @param pixels The frame where the center will be found. It needs to be a segmented frame.
+ * @param rle Runs of the segmented frame where the center will be found.
  * @param bottomr_row_idx Defines the y index in the frame where the center should be found.
- * @return Track center.
+ * @param search_x Column the edges are searched for out from, e.g. the frame center or where the
+ * track center was last seen.
+ * @return Track center. A missing edge is taken to be at the frame border.
  */
-point2_t track_center(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], uint16_t const bottom_row_idx);
+point2_t track_center(rle_t const *const rle, uint16_t const bottom_row_idx, uint16_t const search_x);
 
 /**
  * @brief Find the track center in the provided frame which is above a black pixel.
- * @param pixels The frame where the center will be found. It needs to be a segmented frame.
+ * @param rle Runs of the segmented frame where the center will be found.
  * @param bottomr_row_idx Defines the y index in the frame where the center should be found.
+ * @param search_x See @c track_center .
  * @return Point over a black pixel closest to the track center.
  */
-point2_t track_center_black(uint8_t (*const pixels)[TCO_FRAME_HEIGHT][TCO_FRAME_WIDTH], uint16_t const bottom_row_idx);
+point2_t track_center_black(rle_t const *const rle, uint16_t const bottom_row_idx, uint16_t const search_x);
 
 /**
  * @brief Check if given coordinates lie within a frame.
@@ -0,0 +1,167 @@
+#define _GNU_SOURCE /* For 'pthread_setaffinity_np'. */
+
+#include <stdlib.h>
+#include <stdatomic.h>
+
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "tco_libd.h"
+
+#include "pool.h"
+
+static pthread_t threads[POOL_WORKERS_MAX];
+static pthread_barrier_t barrier_start; /* Releases the workers into a run. */
+static pthread_barrier_t barrier_done;  /* Waits for all workers to finish a run. */
+static uint8_t workers = 1;             /* Number of workers including the thread calling 'pool_run'. */
+static pool_task_t task_now = NULL;
+static void *task_arg = NULL;
+static atomic_char running = 0;       /* Set while a run is in progress. */
+static atomic_char exit_requested = 0; /* Makes the workers quit instead of running a task. */
+static pthread_mutex_t init_lock = PTHREAD_MUTEX_INITIALIZER; /* Held until the barriers are set up for the workers which got created. */
+
+/**
+ * @brief Loop of a worker thread.
+ * @param arg Index of the worker cast to a pointer.
+ */
+static void *worker_loop(void *arg)
+{
+    uint8_t const worker_idx = (uintptr_t)arg;
+    pthread_mutex_lock(&init_lock);
+    pthread_mutex_unlock(&init_lock);
+    /* Set when the barriers failed to init, so they must not be waited on. */
+    if (atomic_load(&exit_requested))
+    {
+        return NULL;
+    }
+    for (;;)
+    {
+        pthread_barrier_wait(&barrier_start);
+        if (atomic_load(&exit_requested))
+        {
+            break;
+        }
+        task_now(worker_idx, workers, task_arg);
+        pthread_barrier_wait(&barrier_done);
+    }
+    return NULL;
+}
+
+int pool_init(uint8_t const worker_num)
+{
+    long const core_num = sysconf(_SC_NPROCESSORS_ONLN);
+    uint8_t worker_num_used = worker_num;
+    if (worker_num_used == 0)
+    {
+        worker_num_used = core_num > 0 ? core_num : 1;
+    }
+    if (worker_num_used > POOL_WORKERS_MAX)
+    {
+        worker_num_used = POOL_WORKERS_MAX;
+    }
+    if (worker_num_used == 1)
+    {
+        workers = 1;
+        return EXIT_SUCCESS;
+    }
+
+    atomic_init(&exit_requested, 0);
+    atomic_init(&running, 0);
+    pthread_mutex_lock(&init_lock);
+    uint8_t worker_idx = 1;
+    for (; worker_idx < worker_num_used; worker_idx++)
+    {
+        if (pthread_create(&threads[worker_idx], NULL, &worker_loop, (void *)(uintptr_t)worker_idx) != 0)
+        {
+            log_error("Failed to create worker thread %u, continuing with fewer workers", worker_idx);
+            break;
+        }
+        /* Worker 0 is the thread calling 'pool_run' which is left to the scheduler. */
+        if (core_num > 1)
+        {
+            cpu_set_t cpu_set;
+            CPU_ZERO(&cpu_set);
+            CPU_SET(worker_idx % core_num, &cpu_set);
+            if (pthread_setaffinity_np(threads[worker_idx], sizeof(cpu_set), &cpu_set) != 0)
+            {
+                log_error("Failed to pin worker %u to core %ld", worker_idx, worker_idx % core_num);
+            }
+        }
+    }
+    /* The barriers are sized for the workers that actually exist and only then are they let in. */
+    uint8_t const created_num = worker_idx;
+    if (created_num == 1)
+    {
+        pthread_mutex_unlock(&init_lock);
+        workers = 1;
+        return EXIT_SUCCESS;
+    }
+    int const start_status = pthread_barrier_init(&barrier_start, NULL, created_num);
+    int const done_status = start_status == 0 ? pthread_barrier_init(&barrier_done, NULL, created_num) : -1;
+    if (start_status != 0 || done_status != 0)
+    {
+        log_error("Failed to init the worker pool barriers");
+        if (start_status == 0)
+        {
+            pthread_barrier_destroy(&barrier_start);
+        }
+        /* Let the workers which got created quit before they reach the barriers. */
+        atomic_store(&exit_requested, 1);
+        pthread_mutex_unlock(&init_lock);
+        for (worker_idx = 1; worker_idx < created_num; worker_idx++)
+        {
+            pthread_join(threads[worker_idx], NULL);
+        }
+        workers = 1;
+        return EXIT_FAILURE;
+    }
+    workers = created_num;
+    pthread_mutex_unlock(&init_lock);
+    log_info("Worker pool started with %u workers on %ld cores", workers, core_num);
+    return EXIT_SUCCESS;
+}
+
+void pool_run(pool_task_t const task, void *const arg)
+{
+    if (workers == 1)
+    {
+        task(0, 1, arg);
+        return;
+    }
+    task_now = task;
+    task_arg = arg;
+    atomic_store(&running, 1);
+    pthread_barrier_wait(&barrier_start);
+    task(0, workers, arg);
+    pthread_barrier_wait(&barrier_done);
+    atomic_store(&running, 0);
+}
+
+uint8_t pool_worker_num(void)
+{
+    return workers;
+}
+
+void pool_deinit(void)
+{
+    if (workers == 1)
+    {
+        return;
+    }
+    if (atomic_load(&running))
+    {
+        log_error("Worker pool is still running a task so its threads are left to exit with the process");
+        return;
+    }
+    atomic_store(&exit_requested, 1);
+    pthread_barrier_wait(&barrier_start);
+    for (uint8_t worker_idx = 1; worker_idx < workers; worker_idx++)
+    {
+        pthread_join(threads[worker_idx], NULL);
+    }
+    pthread_barrier_destroy(&barrier_start);
+    pthread_barrier_destroy(&barrier_done);
+    workers = 1;
+}
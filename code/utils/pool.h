@@ -0,0 +1,47 @@
+#ifndef _POOL_H_
+#define _POOL_H_
+
+/**
+ * @brief Persistent pool of worker threads for splitting per-frame work into parallel parts. The
+ * threads are created once, pinned to their own cores and park on a barrier between runs, so
+ * dispatching work costs two barrier waits instead of creating threads every frame. The thread
+ * calling @c pool_run takes part as worker 0.
+ */
+
+#include <stdint.h>
+
+#define POOL_WORKERS_MAX 8
+
+/* Work done by every worker of the pool during a run. */
+typedef void (*pool_task_t)(uint8_t const worker_idx, uint8_t const worker_num, void *const arg);
+
+/**
+ * @brief Create the worker threads.
+ * @param worker_num Number of workers including the thread calling @c pool_run . If 0, one worker
+ * per online core is used. Capped at @c POOL_WORKERS_MAX .
+ * @return 0 on success, 1 on failure, in which case no worker threads are left running and tasks
+ * run on the calling thread alone.
+ */
+int pool_init(uint8_t const worker_num);
+
+/**
+ * @brief Run a task on all workers and wait for all of them to finish it. Must only be called from
+ * a single thread. Without @c pool_init , the task runs on the calling thread alone.
+ * @param task
+ * @param arg Passed to @p task .
+ */
+void pool_run(pool_task_t const task, void *const arg);
+
+/**
+ * @brief Get the number of workers a task is split across.
+ * @return Number of workers including the calling thread. 1 if the pool is not initialized.
+ */
+uint8_t pool_worker_num(void);
+
+/**
+ * @brief Stop and join the worker threads. If a run is still in progress (e.g. the thread calling
+ * @c pool_run got cancelled), the workers are left parked until the process exits.
+ */
+void pool_deinit(void);
+
+#endif /* _POOL_H_ */
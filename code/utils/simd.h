@@ -0,0 +1,24 @@
+#ifndef _SIMD_H_
+#define _SIMD_H_
+
+/**
+ * @brief Picks the SIMD instruction set at build time. Exactly one of SIMD_NEON, SIMD_SSE2 or
+ * SIMD_NONE gets defined. Kernels which have a vectorized variant must also keep a scalar path for
+ * SIMD_NONE. Defining SIMD_DISABLE when building forces the scalar paths on every target.
+ */
+
+#include <stdint.h>
+
+#if !defined(SIMD_DISABLE) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#include <arm_neon.h>
+#define SIMD_NEON
+#elif !defined(SIMD_DISABLE) && defined(__SSE2__)
+#include <emmintrin.h>
+#define SIMD_SSE2
+#else
+#define SIMD_NONE
+#endif
+
+#define SIMD_WIDTH 16 /* Number of uint8_t lanes in a vector register for all supported sets. */
+
+#endif /* _SIMD_H_ */
@@ -9,14 +9,30 @@ int stack_dyna_push(stack_dyna_t *const stack, void const *const data)
     if (stack->data == NULL)
     {
         stack->data = malloc(4096); /* Get a page. */
+        if (stack->data == NULL)
+        {
+            return -1;
+        }
         stack->data_len = 4096;
         stack->top = 0;
     }
-    else if (stack->top * stack->el_size >= stack->data_len)
+    else if ((uint32_t)(stack->top + 1) * stack->el_size > stack->data_len)
     {
-        stack->data = realloc(stack->data, stack->data_len * stack->el_size + 4096);
+        /* Grow by a page. 'data_len' counts bytes, not elements. */
+        uint32_t const data_len_new = (uint32_t)stack->data_len + 4096;
+        if (data_len_new > UINT16_MAX)
+        {
+            return -1;
+        }
+        void *const data_new = realloc(stack->data, data_len_new);
+        if (data_new == NULL)
+        {
+            return -1; /* The old data stays valid. */
+        }
+        stack->data = data_new;
+        stack->data_len = data_len_new;
     }
-    memcpy(stack->data + (stack->top++) * stack->el_size, data, stack->el_size);
+    memcpy((uint8_t *)stack->data + (stack->top++) * stack->el_size, data, stack->el_size);
     return 0;
 }
 
@@ -36,6 +52,6 @@ int stack_dyna_top(stack_dyna_t *const stack, void *const top)
     {
         return -1;
     }
-    memcpy(top, stack->data + (stack->top - 1) * stack->el_size, stack->el_size);
+    memcpy(top, (uint8_t *)stack->data + (stack->top - 1) * stack->el_size, stack->el_size);
     return 0;
 }
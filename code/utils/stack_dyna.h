@@ -10,7 +10,7 @@
 typedef struct stack_dyna
 {
     void *data;
-    uint16_t data_len;
+    uint16_t data_len; /* Size of the allocation in bytes. */
     uint16_t top;    /* Points to the location where the next element will be pushed. When at 0, stack is empty. */
     uint8_t el_size; /* Mandatory field. */
 } stack_dyna_t;
@@ -21,7 +21,7 @@ typedef struct stack_dyna
  * allocated on the heap and the pointer stored in the structure.
  * @param stack
  * @param data Must contain at least as many bytes as the element size of the stack.
- * @return 0 on success and -1 on failure.
+ * @return 0 on success and -1 on failure i.e. out of memory or the stack would exceed 64 KiB.
  */
 int stack_dyna_push(stack_dyna_t *const stack, void const *const data);
 
@@ -0,0 +1,32 @@
+#include <time.h>
+
+#include "tco_libd.h"
+
+#include "timing.h"
+
+uint64_t timing_now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+void timing_stat_add(timing_stat_t *const stat, uint64_t const ns)
+{
+    stat->ns_total += ns;
+    stat->ns_max = ns > stat->ns_max ? ns : stat->ns_max;
+    stat->sample_num++;
+}
+
+void timing_stat_report(timing_stat_t *const stat, char const *const note)
+{
+    if (stat->sample_num > 0)
+    {
+        log_info("%s: avg %.1f us, max %.1f us over %u runs%s%s",
+                 stat->name, stat->ns_total / 1000.0f / stat->sample_num, stat->ns_max / 1000.0f, stat->sample_num,
+                 note != NULL ? ", " : "", note != NULL ? note : "");
+    }
+    stat->ns_total = 0;
+    stat->ns_max = 0;
+    stat->sample_num = 0;
+}
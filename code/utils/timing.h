@@ -0,0 +1,35 @@
+#ifndef _TIMING_H_
+#define _TIMING_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Read a monotonic clock. Only differences between two readings are meaningful.
+ * @return Current time in nanoseconds.
+ */
+uint64_t timing_now_ns(void);
+
+/* Accumulates the durations of a repeatedly timed stage so they can be reported periodically. */
+typedef struct timing_stat
+{
+    char const *name;
+    uint64_t ns_total;
+    uint64_t ns_max;
+    uint32_t sample_num;
+} timing_stat_t;
+
+/**
+ * @brief Add a duration to the statistics.
+ * @param stat
+ * @param ns Duration in nanoseconds.
+ */
+void timing_stat_add(timing_stat_t *const stat, uint64_t const ns);
+
+/**
+ * @brief Log the average and maximum durations and start accumulating from scratch.
+ * @param stat
+ * @param note Extra text appended to the log line e.g. how much work the stage skipped. Can be NULL.
+ */
+void timing_stat_report(timing_stat_t *const stat, char const *const note);
+
+#endif /* _TIMING_H_ */